@@ -0,0 +1,65 @@
+#include "activity_gate.h"
+#include "event_log.h"
+#include "log.h"
+
+#define IDLE_SECONDS (ACTIVITY_IDLE_MINUTES * 60)
+
+#if defined(PBL_HEALTH)
+static bool asleep(void) {
+  return (health_service_peek_current_activities() & (HealthActivitySleep | HealthActivityRestfulSleep)) != 0;
+}
+
+static bool no_recent_steps(time_t now) {
+  time_t start = now - IDLE_SECONDS;
+
+  // Without step data we cannot tell idle from busy, so assume busy.
+  if (!(health_service_metric_accessible(HealthMetricStepCount, start, now) & HealthServiceAccessibilityMaskAvailable)) {
+    return false;
+  }
+  return health_service_sum(HealthMetricStepCount, start, now) == 0;
+}
+#endif
+
+ActivityState activity_gate_state(ActivityGate const *gate) {
+#if defined(PBL_HEALTH)
+  time_t now = time(NULL);
+
+  if (asleep()) {
+    return ACTIVITY_ASLEEP;
+  }
+  if (now - gate->last_tap >= IDLE_SECONDS && no_recent_steps(now)) {
+    return ACTIVITY_IDLE;
+  }
+#endif
+  return ACTIVITY_AWAKE;
+}
+
+bool activity_gate_allow(ActivityGate *gate) {
+  ActivityState state = activity_gate_state(gate);
+
+  if (state == ACTIVITY_AWAKE) {
+    return true;
+  }
+  ++gate->suppressed;
+  gate->catch_up_pending = true;
+  event_log_add(EVENT_WEATHER_DEFERRED, state);
+  LOG_DEBUG("weather poll deferred while %s, %lu so far", state == ACTIVITY_ASLEEP ? "asleep" : "idle",
+            gate->suppressed);
+  return false;
+}
+
+bool activity_gate_take_catch_up(ActivityGate *gate) {
+  if (!gate->catch_up_pending || activity_gate_state(gate) != ACTIVITY_AWAKE) {
+    return false;
+  }
+  gate->catch_up_pending = false;
+  return true;
+}
+
+void activity_gate_fetched(ActivityGate *gate) {
+  gate->catch_up_pending = false;
+}
+
+void activity_gate_tap(ActivityGate *gate) {
+  gate->last_tap = time(NULL);
+}
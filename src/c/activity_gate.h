@@ -0,0 +1,29 @@
+#pragma once
+
+#include <pebble.h>
+
+// Decides whether a scheduled weather poll is worth making.  Nobody looks at the weather while asleep or while
+// the watch is lying on a desk, so polls are deferred then and one catch-up poll is made once there is activity
+// again.  Uses Health where the platform has it; elsewhere only taps count and the gate stays open.
+typedef enum {
+  ACTIVITY_AWAKE,
+  ACTIVITY_ASLEEP,
+  ACTIVITY_IDLE,   // no steps and no taps for ACTIVITY_IDLE_MINUTES
+} ActivityState;
+
+#define ACTIVITY_IDLE_MINUTES 90
+
+typedef struct {
+  uint32_t suppressed;    // polls deferred since launch
+  bool catch_up_pending;  // a poll was deferred and nothing has been fetched since
+  time_t last_tap;
+} ActivityGate;
+
+ActivityState activity_gate_state(ActivityGate const *gate);
+// Call in front of a scheduled poll.  Returns false, and counts the poll as suppressed, if it should be skipped.
+bool activity_gate_allow(ActivityGate *gate);
+// Returns true once when a poll was deferred and there is activity again.
+bool activity_gate_take_catch_up(ActivityGate *gate);
+// Weather was fetched for whatever reason, so there is nothing to catch up on.
+void activity_gate_fetched(ActivityGate *gate);
+void activity_gate_tap(ActivityGate *gate);
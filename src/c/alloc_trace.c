@@ -0,0 +1,99 @@
+#include "alloc_trace.h"
+#include "trace_table.h"
+#include "log.h"
+
+#if ALLOC_TRACE
+
+// Entries are named by update proc or event handler.
+enum {
+  ALLOC_RUNS,
+  ALLOC_ALLOCATIONS,
+  ALLOC_MOST,  // allocations in the worst single run
+};
+
+static TraceTableEntry s_entries[ALLOC_TRACE_ENTRIES + 1];
+static TraceTable s_table = { s_entries, ARRAY_LENGTH(s_entries), 0 };
+
+static TraceTableEntry *s_current;  // frame or event running right now, if any
+static uint16_t s_current_allocations;
+static bool s_current_steady;
+static int s_depth;
+
+static bool s_ready;
+static uint16_t s_outside;     // allocations outside any frame or event
+static uint16_t s_violations;  // allocations where there should have been none, since launch
+
+void *alloc_trace_note(void *allocated, char const *call, char const *cause) {
+  if (s_current == NULL) {
+    ++s_outside;
+    return allocated;
+  }
+
+  ++s_current_allocations;
+  if (s_ready && s_current_steady) {
+    ++s_violations;
+    LOG_ERROR("alloc: %s in %s during %s, which should not allocate", call, cause, s_current->name);
+  }
+  return allocated;
+}
+
+// Frames and events do not nest, but a handler may call another that brackets itself.  The outermost one counts.
+void alloc_trace_begin(char const *scope, bool steady) {
+  if (s_depth++ > 0) {
+    return;
+  }
+  s_current = trace_table_entry(&s_table, scope, NULL);
+  s_current_allocations = 0;
+  s_current_steady = steady;
+}
+
+void alloc_trace_end(void) {
+  if (--s_depth > 0 || s_current == NULL) {
+    return;
+  }
+  ++s_current->counts[ALLOC_RUNS];
+  s_current->counts[ALLOC_ALLOCATIONS] += s_current_allocations;
+  if (s_current_allocations > s_current->counts[ALLOC_MOST]) {
+    s_current->counts[ALLOC_MOST] = s_current_allocations;
+  }
+  s_current = NULL;
+}
+
+void alloc_trace_ready(void) {
+  if (!s_ready) {
+    s_ready = true;
+    LOG_DEBUG("alloc: steady state from here, %d allocations outside frames and events so far", s_outside);
+  }
+}
+
+bool alloc_trace_is_ready(void) {
+  return s_ready;
+}
+
+uint16_t alloc_trace_violations(void) {
+  return s_violations;
+}
+
+// At the same level as the violations, so a build at the default log level shows both.
+void alloc_trace_log(void) {
+  LOG_ERROR("allocations this minute (%d outside frames and events, %d in steady state since launch):",
+            s_outside, s_violations);
+  for (int i = 0; i < s_table.size; ++i) {
+    TraceTableEntry const *entry = &s_entries[i];
+    if (entry->counts[ALLOC_RUNS] == 0) {
+      continue;
+    }
+    LOG_ERROR("  %5d allocations in %d runs of %s (at most %d in one)",
+              entry->counts[ALLOC_ALLOCATIONS], entry->counts[ALLOC_RUNS], entry->name, entry->counts[ALLOC_MOST]);
+  }
+
+  // The frame or event running right now keeps its place.
+  char const *current = s_current != NULL ? s_current->name : NULL;
+  trace_table_reset(&s_table);
+  s_outside = 0;
+  if (current != NULL) {
+    s_current = trace_table_entry(&s_table, current, NULL);
+  }
+}
+
+#endif
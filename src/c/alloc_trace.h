@@ -0,0 +1,54 @@
+#pragma once
+
+#include <pebble.h>
+
+// Allocation counter.  Build with ALLOC_TRACE 1 to find out what allocates from the heap and when: every call
+// that allocates goes through one of the ALLOC_* macros below, and every update proc and event handler brackets
+// itself with ALLOC_TRACE_BEGIN/END, so allocations are counted per frame and per event.  Once the face is up
+// (ALLOC_TRACE_READY), frames and the handlers that run all day long are meant not to allocate at all; those
+// bracket themselves with ALLOC_TRACE_STEADY_BEGIN, and an allocation inside one is logged as an error.  Once a
+// minute the counts are logged, at error level too, and reset.  test/host/steady_state_test.c runs the face for
+// days on the host build and fails on any such allocation.  With ALLOC_TRACE 0 the ALLOC_* macros are just the
+// calls they wrap.
+#ifndef ALLOC_TRACE
+#define ALLOC_TRACE 0
+#endif
+
+#if ALLOC_TRACE
+
+// Frames and events told apart per minute; see trace_table.h.
+#define ALLOC_TRACE_ENTRIES 16
+
+void *alloc_trace_note(void *allocated, char const *call, char const *cause);
+void alloc_trace_begin(char const *scope, bool steady);
+void alloc_trace_end(void);
+void alloc_trace_ready(void);
+void alloc_trace_log(void);
+// For tests: whether ALLOC_TRACE_READY has happened, and how many allocations there have been in steady state since.
+bool alloc_trace_is_ready(void);
+uint16_t alloc_trace_violations(void);
+
+#define ALLOC_NOTE(type, call, allocation) ((type)alloc_trace_note((allocation), (call), __func__))
+#define ALLOC_TRACE_BEGIN() alloc_trace_begin(__func__, false)
+#define ALLOC_TRACE_STEADY_BEGIN() alloc_trace_begin(__func__, true)
+#define ALLOC_TRACE_END() alloc_trace_end()
+#define ALLOC_TRACE_READY() alloc_trace_ready()
+#define ALLOC_TRACE_LOG() alloc_trace_log()
+
+#else
+
+#define ALLOC_NOTE(type, call, allocation) (allocation)
+#define ALLOC_TRACE_BEGIN()
+#define ALLOC_TRACE_STEADY_BEGIN()
+#define ALLOC_TRACE_END()
+#define ALLOC_TRACE_READY()
+#define ALLOC_TRACE_LOG()
+
+#endif
+
+#define ALLOC_MALLOC(size) ALLOC_NOTE(void *, "malloc", malloc(size))
+#define ALLOC_LAYER_CREATE(frame) ALLOC_NOTE(Layer *, "layer_create", layer_create(frame))
+#define ALLOC_TEXT_LAYER_CREATE(frame) ALLOC_NOTE(TextLayer *, "text_layer_create", text_layer_create(frame))
+#define ALLOC_GPATH_CREATE(info) ALLOC_NOTE(GPath *, "gpath_create", gpath_create(info))
+#define ALLOC_FONTS_LOAD_CUSTOM_FONT(handle) \
+  ALLOC_NOTE(GFont, "fonts_load_custom_font", fonts_load_custom_font(handle))
@@ -0,0 +1,89 @@
+#include "circuit_breaker.h"
+#include "event_log.h"
+#include "log.h"
+
+// How long to leave each kind of failure alone before the first probe.  Rate limits want the longest rest.
+static uint32_t first_probe_seconds(WeatherErrorKind kind) {
+  switch (kind) {
+    case WEATHER_ERROR_RATE_LIMITED:
+      return 2 * 60 * 60;
+    case WEATHER_ERROR_NO_LOCATION:
+    case WEATHER_ERROR_NO_NETWORK:
+    case WEATHER_ERROR_PROVIDER:
+    default:
+      return 60 * 60;
+  }
+}
+
+static void trip(CircuitBreaker *breaker, time_t now) {
+  breaker->state = BREAKER_OPEN;
+  breaker->retry_at = now + breaker->probe_seconds;
+  ++breaker->trips;
+  event_log_add(EVENT_BREAKER_OPEN, breaker->last_kind);
+  LOG_INFO("weather polling stopped after error %d, next try in %lus", breaker->last_kind, breaker->probe_seconds);
+}
+
+bool circuit_breaker_allow(CircuitBreaker const *breaker, time_t now) {
+  switch (breaker->state) {
+    case BREAKER_OPEN:
+    // When half open a probe is already out.  If it never comes back, try another one after the same wait.
+    case BREAKER_HALF_OPEN:
+      return now >= breaker->retry_at;
+    case BREAKER_CLOSED:
+    default:
+      return true;
+  }
+}
+
+void circuit_breaker_probe_sent(CircuitBreaker *breaker, time_t now) {
+  if (breaker->state == BREAKER_CLOSED) {
+    return;
+  }
+  breaker->state = BREAKER_HALF_OPEN;
+  breaker->retry_at = now + breaker->probe_seconds;
+}
+
+void circuit_breaker_success(CircuitBreaker *breaker) {
+  if (breaker->state != BREAKER_CLOSED) {
+    LOG_INFO("weather polling resumed");
+  }
+  breaker->state = BREAKER_CLOSED;
+  breaker->last_kind = WEATHER_ERROR_NONE;
+  breaker->consecutive = 0;
+}
+
+void circuit_breaker_failure(CircuitBreaker *breaker, WeatherErrorKind kind, time_t now) {
+  if (kind <= WEATHER_ERROR_NONE || kind >= WEATHER_ERROR_KIND_COUNT) {
+    kind = WEATHER_ERROR_PROVIDER;
+  }
+  if (breaker->failures[kind] < UINT16_MAX) {
+    ++breaker->failures[kind];
+  }
+
+  if (breaker->state == BREAKER_HALF_OPEN) {
+    // The probe failed.  Back off further.
+    breaker->last_kind = kind;
+    breaker->probe_seconds *= 2;
+    if (breaker->probe_seconds > CIRCUIT_BREAKER_MAX_PROBE_SECONDS) {
+      breaker->probe_seconds = CIRCUIT_BREAKER_MAX_PROBE_SECONDS;
+    }
+    trip(breaker, now);
+    return;
+  }
+
+  if (kind != breaker->last_kind) {
+    breaker->last_kind = kind;
+    breaker->consecutive = 0;
+  }
+  if (++breaker->consecutive >= CIRCUIT_BREAKER_TRIP_FAILURES && breaker->state == BREAKER_CLOSED) {
+    breaker->probe_seconds = first_probe_seconds(kind);
+    trip(breaker, now);
+  }
+}
+
+void circuit_breaker_log(CircuitBreaker const *breaker) {
+  LOG_DEBUG("weather breaker: state %d, %d x error %d, %lu trips, failures: location %d network %d provider %d rate %d",
+            breaker->state, breaker->consecutive, breaker->last_kind, breaker->trips,
+            breaker->failures[WEATHER_ERROR_NO_LOCATION], breaker->failures[WEATHER_ERROR_NO_NETWORK],
+            breaker->failures[WEATHER_ERROR_PROVIDER], breaker->failures[WEATHER_ERROR_RATE_LIMITED]);
+}
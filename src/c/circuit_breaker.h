@@ -0,0 +1,42 @@
+#pragma once
+
+#include <pebble.h>
+
+// Why the phone could not get the weather.  IMPORTANT: Keep in sync with providers.js.
+typedef enum {
+  WEATHER_ERROR_NONE,
+  WEATHER_ERROR_NO_LOCATION,
+  WEATHER_ERROR_NO_NETWORK,
+  WEATHER_ERROR_PROVIDER,
+  WEATHER_ERROR_RATE_LIMITED,
+  WEATHER_ERROR_KIND_COUNT
+} WeatherErrorKind;
+
+typedef enum {
+  BREAKER_CLOSED,     // polling as usual
+  BREAKER_OPEN,       // failing; polls are skipped until retry_at
+  BREAKER_HALF_OPEN,  // one probe is out to see whether things are working again
+} BreakerState;
+
+// Stops scheduled weather polls after the phone has failed the same way CIRCUIT_BREAKER_TRIP_FAILURES times in a
+// row, then probes again on an interval that doubles with every failed probe.
+#define CIRCUIT_BREAKER_TRIP_FAILURES 3
+#define CIRCUIT_BREAKER_MAX_PROBE_SECONDS (6 * 60 * 60)
+
+typedef struct {
+  BreakerState state;
+  WeatherErrorKind last_kind;
+  uint8_t consecutive;        // failures of last_kind in a row
+  uint32_t probe_seconds;     // wait before the next probe while open
+  time_t retry_at;
+  uint32_t trips;
+  uint16_t failures[WEATHER_ERROR_KIND_COUNT];
+} CircuitBreaker;
+
+// Whether a scheduled poll may go out now.  Changes nothing, so ask whatever else decides on the poll first.
+bool circuit_breaker_allow(CircuitBreaker const *breaker, time_t now);
+// The poll circuit_breaker_allow let through went out.  Moves an open breaker to half open, with this as the probe.
+void circuit_breaker_probe_sent(CircuitBreaker *breaker, time_t now);
+void circuit_breaker_success(CircuitBreaker *breaker);
+void circuit_breaker_failure(CircuitBreaker *breaker, WeatherErrorKind kind, time_t now);
+void circuit_breaker_log(CircuitBreaker const *breaker);
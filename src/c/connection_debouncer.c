@@ -0,0 +1,47 @@
+#include "connection_debouncer.h"
+#include "log.h"
+
+void connection_debouncer_init(ConnectionDebouncer *debouncer, bool connected, uint32_t disconnect_ms,
+                               uint32_t connect_ms, ConnectionDebouncerHandler handler, void *context) {
+  connection_debouncer_cancel(debouncer);
+  debouncer->connected = connected;
+  debouncer->raw_connected = connected;
+  debouncer->disconnect_ms = disconnect_ms;
+  debouncer->connect_ms = connect_ms;
+  debouncer->handler = handler;
+  debouncer->context = context;
+}
+
+static void settled(void *data) {
+  ConnectionDebouncer *debouncer = data;
+
+  debouncer->timer = NULL;
+  debouncer->connected = debouncer->raw_connected;
+  debouncer->handler(debouncer->connected, debouncer->context);
+}
+
+void connection_debouncer_update(ConnectionDebouncer *debouncer, bool connected) {
+  debouncer->raw_connected = connected;
+
+  if (connected == debouncer->connected) {
+    // Back where we were before the window ran out.
+    if (debouncer->timer != NULL) {
+      connection_debouncer_cancel(debouncer);
+      ++debouncer->bounces;
+      LOG_DEBUG("bluetooth bounce ignored, %lu so far", debouncer->bounces);
+    }
+    return;
+  }
+
+  uint32_t window_ms = connected ? debouncer->connect_ms : debouncer->disconnect_ms;
+  if (debouncer->timer == NULL || !app_timer_reschedule(debouncer->timer, window_ms)) {
+    debouncer->timer = app_timer_register(window_ms, settled, debouncer);
+  }
+}
+
+void connection_debouncer_cancel(ConnectionDebouncer *debouncer) {
+  if (debouncer->timer != NULL) {
+    app_timer_cancel(debouncer->timer);
+    debouncer->timer = NULL;
+  }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <pebble.h>
+
+typedef void (*ConnectionDebouncerHandler)(bool connected, void *context);
+
+// Smooths over a flaky bluetooth link.  A change is only passed on once the link has stayed that way for the
+// window given for that direction; anything that flips back sooner is counted as a bounce and dropped.  Having a
+// longer window for disconnects than for reconnects means a brief drop never buzzes, while a real reconnect
+// still shows up quickly.
+typedef struct {
+  bool connected;      // debounced state
+  bool raw_connected;  // what the connection service last said
+  uint32_t disconnect_ms;
+  uint32_t connect_ms;
+  AppTimer *timer;
+  uint32_t bounces;
+  ConnectionDebouncerHandler handler;
+  void *context;
+} ConnectionDebouncer;
+
+void connection_debouncer_init(ConnectionDebouncer *debouncer, bool connected, uint32_t disconnect_ms,
+                               uint32_t connect_ms, ConnectionDebouncerHandler handler, void *context);
+void connection_debouncer_update(ConnectionDebouncer *debouncer, bool connected);
+void connection_debouncer_cancel(ConnectionDebouncer *debouncer);
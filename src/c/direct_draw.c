@@ -0,0 +1,441 @@
+#include "direct_draw.h"
+#include "alloc_trace.h"
+#include "feature_profile.h"
+
+// Row y of the frame buffer, with the first and last pixels of it that are on screen.
+typedef struct {
+  uint8_t *data;
+  int min_x;
+  int max_x;
+} Row;
+
+#if FEATURE_DIRECT_DRAW
+static bool known_format(GBitmap *frame_buffer) {
+  switch (gbitmap_get_format(frame_buffer)) {
+    case GBitmapFormat1Bit:
+    case GBitmapFormat8Bit:
+#if defined(PBL_ROUND)
+    case GBitmapFormat8BitCircular:
+#endif
+      return true;
+    default:
+      return false;
+  }
+}
+#endif
+
+static bool get_row(GBitmap *frame_buffer, int y, Row *row) {
+  GRect bounds = gbitmap_get_bounds(frame_buffer);
+
+  if (y < 0 || y >= bounds.size.h) {
+    return false;
+  }
+#if defined(PBL_ROUND)
+  if (gbitmap_get_format(frame_buffer) == GBitmapFormat8BitCircular) {
+    GBitmapDataRowInfo info = gbitmap_get_data_row_info(frame_buffer, y);
+    *row = (Row) { .data = info.data, .min_x = info.min_x, .max_x = info.max_x };
+    return true;
+  }
+#endif
+  *row = (Row) {
+    .data = gbitmap_get_data(frame_buffer) + y * gbitmap_get_bytes_per_row(frame_buffer),
+    .min_x = 0,
+    .max_x = bounds.size.w - 1,
+  };
+  return true;
+}
+
+static bool is_one_bit(GBitmap *frame_buffer) {
+  return gbitmap_get_format(frame_buffer) == GBitmapFormat1Bit;
+}
+
+static bool is_clear(GColor color) {
+  return (color.argb & 0xc0) == 0;
+}
+
+// Whether color lights a pixel on a 1 bit frame buffer.
+static bool is_light(GColor color) {
+  return ((color.argb >> 4) & 3) + ((color.argb >> 2) & 3) + (color.argb & 3) >= 5;
+}
+
+// Pixels left to right on row y, clipped to the screen.  1 bit frame buffers keep the leftmost pixel of each byte
+// in its low bit.
+static void fill_span(GBitmap *frame_buffer, int y, int left, int right, GColor color) {
+  Row row;
+
+  if (!get_row(frame_buffer, y, &row)) {
+    return;
+  }
+  left = left < row.min_x ? row.min_x : left;
+  right = right > row.max_x ? row.max_x : right;
+  if (left > right) {
+    return;
+  }
+
+  if (!is_one_bit(frame_buffer)) {
+    memset(&row.data[left], color.argb | 0xc0, right - left + 1);
+    return;
+  }
+
+  uint8_t fill = is_light(color) ? 0xff : 0x00;
+  int first = left / 8;
+  int last = right / 8;
+  uint8_t first_mask = (uint8_t)(0xff << (left % 8));
+  uint8_t last_mask = (uint8_t)(0xff >> (7 - right % 8));
+  if (first == last) {
+    first_mask &= last_mask;
+  }
+  row.data[first] = (row.data[first] & ~first_mask) | (fill & first_mask);
+  if (first != last) {
+    memset(&row.data[first + 1], fill, last - first - 1);
+    row.data[last] = (row.data[last] & ~last_mask) | (fill & last_mask);
+  }
+}
+
+static void plot(GBitmap *frame_buffer, int x, int y, GColor color) {
+  fill_span(frame_buffer, y, x, x, color);
+}
+
+// Mixes color into the pixel at x, y by coverage out of 255.  8 bit frame buffers only.
+static void blend(GBitmap *frame_buffer, int x, int y, GColor color, int coverage) {
+  Row row;
+
+  if (!get_row(frame_buffer, y, &row) || x < row.min_x || x > row.max_x) {
+    return;
+  }
+  uint8_t under = row.data[x];
+  uint8_t mixed = 0xc0;
+  for (int shift = 0; shift < 6; shift += 2) {
+    int over_channel = (color.argb >> shift) & 3;
+    int under_channel = (under >> shift) & 3;
+    mixed |= ((over_channel * coverage + under_channel * (255 - coverage) + 127) / 255) << shift;
+  }
+  row.data[x] = mixed;
+}
+
+static int abs_int(int value) {
+  return value < 0 ? -value : value;
+}
+
+static void bresenham_line(GBitmap *frame_buffer, GPoint from, GPoint to, GColor color) {
+  int dx = abs_int(to.x - from.x);
+  int dy = -abs_int(to.y - from.y);
+  int step_x = from.x < to.x ? 1 : -1;
+  int step_y = from.y < to.y ? 1 : -1;
+  int error = dx + dy;
+  int x = from.x;
+  int y = from.y;
+
+  for (;;) {
+    plot(frame_buffer, x, y, color);
+    if (x == to.x && y == to.y) {
+      break;
+    }
+    int error2 = 2 * error;
+    if (error2 >= dy) {
+      error += dy;
+      x += step_x;
+    }
+    if (error2 <= dx) {
+      error += dx;
+      y += step_y;
+    }
+  }
+}
+
+// Xiaolin Wu's line, in 16.16 fixed point.  The ends are on whole pixels, so they need no special treatment.
+static void wu_line(GBitmap *frame_buffer, GPoint from, GPoint to, GColor color) {
+  int x0 = from.x, y0 = from.y, x1 = to.x, y1 = to.y;
+  bool steep = abs_int(y1 - y0) > abs_int(x1 - x0);
+  int swap;
+
+  if (steep) {
+    swap = x0; x0 = y0; y0 = swap;
+    swap = x1; x1 = y1; y1 = swap;
+  }
+  if (x0 > x1) {
+    swap = x0; x0 = x1; x1 = swap;
+    swap = y0; y0 = y1; y1 = swap;
+  }
+
+  int32_t gradient = x1 == x0 ? 0 : (int32_t)(y1 - y0) * 0x10000 / (x1 - x0);
+  int32_t y = (int32_t)y0 * 0x10000;
+  for (int x = x0; x <= x1; ++x, y += gradient) {
+    int whole = y >> 16;
+    int fraction = (y >> 8) & 0xff;
+    if (steep) {
+      blend(frame_buffer, whole, x, color, 255 - fraction);
+      blend(frame_buffer, whole + 1, x, color, fraction);
+    } else {
+      blend(frame_buffer, x, whole, color, 255 - fraction);
+      blend(frame_buffer, x, whole + 1, color, fraction);
+    }
+  }
+}
+
+static void line(GBitmap *frame_buffer, GPoint from, GPoint to, GColor color) {
+  if (is_one_bit(frame_buffer)) {
+    bresenham_line(frame_buffer, from, to, color);
+  } else {
+    wu_line(frame_buffer, from, to, color);
+  }
+}
+
+// The path's points where gpath_move_to and gpath_rotate_to put them, worked out the way gpath does.
+static void place_path(GPath const *path, GPoint points[DIRECT_DRAW_MAX_POINTS]) {
+  int32_t cos = cos_lookup(path->rotation);
+  int32_t sin = sin_lookup(path->rotation);
+
+  for (uint32_t i = 0; i < path->num_points; ++i) {
+    GPoint point = path->points[i];
+    points[i] = (GPoint) {
+      .x = point.x * cos / TRIG_MAX_RATIO - point.y * sin / TRIG_MAX_RATIO + path->offset.x,
+      .y = point.y * cos / TRIG_MAX_RATIO + point.x * sin / TRIG_MAX_RATIO + path->offset.y,
+    };
+  }
+}
+
+// A convex polygon is one span per row, between the leftmost and rightmost edges crossing it.
+static void fill_convex(GBitmap *frame_buffer, GPoint const *points, int count, GColor color) {
+  int top = points[0].y;
+  int bottom = points[0].y;
+
+  for (int i = 1; i < count; ++i) {
+    top = points[i].y < top ? points[i].y : top;
+    bottom = points[i].y > bottom ? points[i].y : bottom;
+  }
+
+  for (int y = top; y <= bottom; ++y) {
+    int left = INT16_MAX;
+    int right = INT16_MIN;
+    for (int i = 0; i < count; ++i) {
+      GPoint a = points[i];
+      GPoint b = points[(i + 1) % count];
+      if ((y < a.y && y < b.y) || (y > a.y && y > b.y)) {
+        continue;
+      }
+      int x_a = a.x;
+      int x_b = b.x;
+      if (a.y != b.y) {
+        x_a = x_b = a.x + (y - a.y) * (b.x - a.x) / (b.y - a.y);
+      }
+      left = x_a < left ? x_a : left;
+      left = x_b < left ? x_b : left;
+      right = x_a > right ? x_a : right;
+      right = x_b > right ? x_b : right;
+    }
+    fill_span(frame_buffer, y, left, right, color);
+  }
+}
+
+void direct_draw_begin(DirectDraw *draw, GContext *ctx) {
+  draw->ctx = ctx;
+  draw->frame_buffer = NULL;
+#if FEATURE_DIRECT_DRAW
+  GBitmap *frame_buffer = graphics_capture_frame_buffer(ctx);
+  if (frame_buffer != NULL && !known_format(frame_buffer)) {
+    graphics_release_frame_buffer(ctx, frame_buffer);
+    frame_buffer = NULL;
+  }
+  draw->frame_buffer = frame_buffer;
+#endif
+}
+
+void direct_draw_end(DirectDraw *draw) {
+  if (draw->frame_buffer != NULL) {
+    graphics_release_frame_buffer(draw->ctx, draw->frame_buffer);
+    draw->frame_buffer = NULL;
+  }
+}
+
+void direct_draw_line(DirectDraw *draw, GPoint from, GPoint to, GColor color) {
+  if (draw->frame_buffer == NULL) {
+    graphics_context_set_stroke_color(draw->ctx, color);
+    graphics_draw_line(draw->ctx, from, to);
+  } else if (!is_clear(color)) {
+    line(draw->frame_buffer, from, to, color);
+  }
+}
+
+void direct_draw_path_filled(DirectDraw *draw, GPath *path, GColor color) {
+  if (draw->frame_buffer == NULL || path->num_points > DIRECT_DRAW_MAX_POINTS) {
+    bool taken = draw->frame_buffer != NULL;
+    direct_draw_end(draw);
+    graphics_context_set_fill_color(draw->ctx, color);
+    gpath_draw_filled(draw->ctx, path);
+    if (taken) {
+      direct_draw_begin(draw, draw->ctx);
+    }
+  } else if (path->num_points > 0 && !is_clear(color)) {
+    GPoint points[DIRECT_DRAW_MAX_POINTS];
+    place_path(path, points);
+    fill_convex(draw->frame_buffer, points, path->num_points, color);
+  }
+}
+
+void direct_draw_path_outline(DirectDraw *draw, GPath *path, GColor color) {
+  if (draw->frame_buffer == NULL || path->num_points > DIRECT_DRAW_MAX_POINTS) {
+    bool taken = draw->frame_buffer != NULL;
+    direct_draw_end(draw);
+    graphics_context_set_stroke_color(draw->ctx, color);
+    gpath_draw_outline(draw->ctx, path);
+    if (taken) {
+      direct_draw_begin(draw, draw->ctx);
+    }
+  } else if (path->num_points > 0 && !is_clear(color)) {
+    GPoint points[DIRECT_DRAW_MAX_POINTS];
+    place_path(path, points);
+    for (uint32_t i = 0; i < path->num_points; ++i) {
+      line(draw->frame_buffer, points[i], points[(i + 1) % path->num_points], color);
+    }
+  }
+}
+
+// Midpoint circles, an octant at a time.
+void direct_draw_circle(DirectDraw *draw, GPoint center, uint16_t radius, GColor color) {
+  if (draw->frame_buffer == NULL) {
+    graphics_context_set_stroke_color(draw->ctx, color);
+    graphics_draw_circle(draw->ctx, center, radius);
+    return;
+  }
+  if (is_clear(color)) {
+    return;
+  }
+
+  int x = radius, y = 0, error = 1 - radius;
+  while (x >= y) {
+    plot(draw->frame_buffer, center.x + x, center.y + y, color);
+    plot(draw->frame_buffer, center.x - x, center.y + y, color);
+    plot(draw->frame_buffer, center.x + x, center.y - y, color);
+    plot(draw->frame_buffer, center.x - x, center.y - y, color);
+    plot(draw->frame_buffer, center.x + y, center.y + x, color);
+    plot(draw->frame_buffer, center.x - y, center.y + x, color);
+    plot(draw->frame_buffer, center.x + y, center.y - x, color);
+    plot(draw->frame_buffer, center.x - y, center.y - x, color);
+    ++y;
+    if (error < 0) {
+      error += 2 * y + 1;
+    } else {
+      --x;
+      error += 2 * (y - x) + 1;
+    }
+  }
+}
+
+void direct_draw_fill_circle(DirectDraw *draw, GPoint center, uint16_t radius, GColor color) {
+  if (draw->frame_buffer == NULL) {
+    graphics_context_set_fill_color(draw->ctx, color);
+    graphics_fill_circle(draw->ctx, center, radius);
+    return;
+  }
+  if (is_clear(color)) {
+    return;
+  }
+
+  int x = radius, y = 0, error = 1 - radius;
+  while (x >= y) {
+    fill_span(draw->frame_buffer, center.y + y, center.x - x, center.x + x, color);
+    fill_span(draw->frame_buffer, center.y - y, center.x - x, center.x + x, color);
+    fill_span(draw->frame_buffer, center.y + x, center.x - y, center.x + y, color);
+    fill_span(draw->frame_buffer, center.y - x, center.x - y, center.x + y, color);
+    ++y;
+    if (error < 0) {
+      error += 2 * y + 1;
+    } else {
+      --x;
+      error += 2 * (y - x) + 1;
+    }
+  }
+}
+
+// Rectangular frame buffers are one run of rows, so they copy in one go.  Round ones are copied a row at a time,
+// the part of each row that is on screen.
+static size_t snapshot_size(GBitmap *frame_buffer) {
+  GRect bounds = gbitmap_get_bounds(frame_buffer);
+
+#if defined(PBL_ROUND)
+  if (gbitmap_get_format(frame_buffer) == GBitmapFormat8BitCircular) {
+    size_t size = 0;
+    Row row;
+    for (int y = 0; get_row(frame_buffer, y, &row); ++y) {
+      size += row.max_x - row.min_x + 1;
+    }
+    return size;
+  }
+#endif
+  return gbitmap_get_bytes_per_row(frame_buffer) * bounds.size.h;
+}
+
+static void snapshot_copy(uint8_t *bytes, GBitmap *frame_buffer, bool to_frame_buffer) {
+#if defined(PBL_ROUND)
+  if (gbitmap_get_format(frame_buffer) == GBitmapFormat8BitCircular) {
+    Row row;
+    for (int y = 0; get_row(frame_buffer, y, &row); ++y) {
+      size_t length = row.max_x - row.min_x + 1;
+      if (to_frame_buffer) {
+        memcpy(&row.data[row.min_x], bytes, length);
+      } else {
+        memcpy(bytes, &row.data[row.min_x], length);
+      }
+      bytes += length;
+    }
+    return;
+  }
+#endif
+  size_t size = snapshot_size(frame_buffer);
+  if (to_frame_buffer) {
+    memcpy(gbitmap_get_data(frame_buffer), bytes, size);
+  } else {
+    memcpy(bytes, gbitmap_get_data(frame_buffer), size);
+  }
+}
+
+bool direct_draw_snapshot_take(DirectDrawSnapshot *snapshot, DirectDraw *draw) {
+  snapshot->valid = false;
+  if (draw->frame_buffer == NULL) {
+    return false;
+  }
+
+  size_t size = snapshot_size(draw->frame_buffer);
+#ifdef DIRECT_DRAW_SNAPSHOT_BYTES
+  if (size > sizeof(snapshot->storage)) {
+    return false;
+  }
+  snapshot->bytes = snapshot->storage;
+  snapshot->size = size;
+#else
+  if (snapshot->bytes == NULL || snapshot->size != size) {
+    direct_draw_snapshot_free(snapshot);
+    snapshot->bytes = ALLOC_MALLOC(size);
+    if (snapshot->bytes == NULL) {
+      return false;
+    }
+    snapshot->size = size;
+  }
+#endif
+  snapshot_copy(snapshot->bytes, draw->frame_buffer, false);
+  snapshot->valid = true;
+  return true;
+}
+
+bool direct_draw_snapshot_blit(DirectDrawSnapshot const *snapshot, DirectDraw *draw) {
+  if (!snapshot->valid || draw->frame_buffer == NULL || snapshot_size(draw->frame_buffer) != snapshot->size) {
+    return false;
+  }
+  snapshot_copy(snapshot->bytes, draw->frame_buffer, true);
+  return true;
+}
+
+void direct_draw_snapshot_invalidate(DirectDrawSnapshot *snapshot) {
+  snapshot->valid = false;
+}
+
+// Field by field, as a compound literal would put a copy of the static storage on the stack.
+void direct_draw_snapshot_free(DirectDrawSnapshot *snapshot) {
+#ifndef DIRECT_DRAW_SNAPSHOT_BYTES
+  free(snapshot->bytes);
+#endif
+  snapshot->bytes = NULL;
+  snapshot->size = 0;
+  snapshot->valid = false;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <pebble.h>
+#include "feature_profile.h"
+
+// Drawing straight into the frame buffer, for the shapes drawn on every frame: the hands, the second hand and the
+// dial.  Each call goes to the frame buffer when the DirectDraw has one and to the usual graphics_* call through
+// ctx when it does not, so a proc is written once and the platform decides.  Whether a platform draws directly is
+// FEATURE_DIRECT_DRAW in feature_profile.h.
+//
+// Nothing drawn directly is antialiased except lines on 8 bit frame buffers, and strokes are one pixel wide.
+// Coordinates are frame buffer coordinates, so only use it from layers that cover the window.
+
+typedef struct {
+  GContext *ctx;
+  GBitmap *frame_buffer;  // NULL when drawing through ctx
+} DirectDraw;
+
+// The most points a path may have to be drawn directly.  Longer ones are drawn through ctx.
+#define DIRECT_DRAW_MAX_POINTS 8
+
+// Takes the frame buffer from ctx if this platform draws directly and the frame buffer is a format we know.
+void direct_draw_begin(DirectDraw *draw, GContext *ctx);
+// Gives the frame buffer back, if it was taken.  ctx cannot be drawn to until then.
+void direct_draw_end(DirectDraw *draw);
+
+void direct_draw_line(DirectDraw *draw, GPoint from, GPoint to, GColor color);
+// Paths are drawn where gpath_move_to and gpath_rotate_to last put them.  Filling assumes a convex path.
+void direct_draw_path_filled(DirectDraw *draw, GPath *path, GColor color);
+void direct_draw_path_outline(DirectDraw *draw, GPath *path, GColor color);
+void direct_draw_circle(DirectDraw *draw, GPoint center, uint16_t radius, GColor color);
+void direct_draw_fill_circle(DirectDraw *draw, GPoint center, uint16_t radius, GColor color);
+
+// A copy of the whole frame buffer, for a scene that changes far less often than it is drawn.  Round frame
+// buffers are copied a row at a time, only the part of each row that is on screen.  On black and white watches
+// the copy lives in the snapshot itself, 20 bytes a row by 168 rows, so it is as static as whatever holds it.
+// Elsewhere it is allocated the first time one is taken and kept until freed.
+#if defined(PBL_BW) && FEATURE_DIRECT_DRAW
+#define DIRECT_DRAW_SNAPSHOT_BYTES (20 * 168)
+#endif
+
+typedef struct {
+  uint8_t *bytes;
+  size_t size;
+  bool valid;
+#ifdef DIRECT_DRAW_SNAPSHOT_BYTES
+  uint8_t storage[DIRECT_DRAW_SNAPSHOT_BYTES];
+#endif
+} DirectDrawSnapshot;
+
+// Both return false, doing nothing, when draw has no frame buffer or the snapshot cannot be taken or used.
+bool direct_draw_snapshot_take(DirectDrawSnapshot *snapshot, DirectDraw *draw);
+bool direct_draw_snapshot_blit(DirectDrawSnapshot const *snapshot, DirectDraw *draw);
+void direct_draw_snapshot_invalidate(DirectDrawSnapshot *snapshot);
+void direct_draw_snapshot_free(DirectDrawSnapshot *snapshot);
@@ -0,0 +1,50 @@
+#include "event_log.h"
+
+typedef struct {
+  uint8_t next;   // slot the next entry goes in
+  uint8_t count;
+  EventLogEntry entries[EVENT_LOG_ENTRIES];
+} EventLog;
+
+static EventLog s_log;
+static uint32_t s_persist_key;
+static bool s_dirty;
+
+void event_log_load(uint32_t persist_key) {
+  s_persist_key = persist_key;
+  if (persist_read_data(persist_key, &s_log, sizeof(s_log)) != sizeof(s_log)
+      || s_log.next >= EVENT_LOG_ENTRIES || s_log.count > EVENT_LOG_ENTRIES) {
+    memset(&s_log, 0, sizeof(s_log));
+  }
+  s_dirty = false;
+}
+
+// Written on the way out and with the other stats now and then, rather than per event, to spare the flash.
+void event_log_save(void) {
+  if (s_dirty) {
+    persist_write_data(s_persist_key, &s_log, sizeof(s_log));
+    s_dirty = false;
+  }
+}
+
+void event_log_add(EventId id, int16_t arg) {
+  s_log.entries[s_log.next] = (EventLogEntry) {
+    .time = time(NULL),
+    .id = id,
+    .arg = arg,
+  };
+  s_log.next = (s_log.next + 1) % EVENT_LOG_ENTRIES;
+  if (s_log.count < EVENT_LOG_ENTRIES) {
+    ++s_log.count;
+  }
+  s_dirty = true;
+}
+
+int event_log_read(EventLogEntry entries[EVENT_LOG_ENTRIES]) {
+  int oldest = (s_log.next + EVENT_LOG_ENTRIES - s_log.count) % EVENT_LOG_ENTRIES;
+
+  for (int i = 0; i < s_log.count; ++i) {
+    entries[i] = s_log.entries[(oldest + i) % EVENT_LOG_ENTRIES];
+  }
+  return s_log.count;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <pebble.h>
+
+// A small binary log of what the watchface has been doing, kept in a ring and persisted across launches so
+// there is some history to look at on a production build where the text log is compiled out.  Entries are
+// stored unformatted; the phone decodes them when it asks for a dump.
+//
+// IMPORTANT: Event ids and the entry layout are decoded by app.js.  Only ever add ids at the end.
+typedef enum {
+  EVENT_LAUNCH = 1,
+  EVENT_WEATHER_REQUESTED,  // arg: message id
+  EVENT_WEATHER_RECEIVED,   // arg: message id
+  EVENT_SEND_FAILED,        // arg: AppMessageResult
+  EVENT_BLUETOOTH,          // arg: 1 connected, 0 disconnected
+  EVENT_SETTINGS_RECEIVED,
+  EVENT_RESTART,            // arg: AppMessageResult that forced it
+  EVENT_WEATHER_DEFERRED,   // arg: ActivityState
+  EVENT_WEATHER_ERROR,      // arg: WeatherErrorKind
+  EVENT_BREAKER_OPEN,       // arg: WeatherErrorKind
+} EventId;
+
+typedef struct {
+  uint32_t time;  // seconds since the epoch
+  uint16_t id;
+  int16_t arg;
+} EventLogEntry;
+
+// Sized so the ring and its header fit in one persistent storage key.
+#define EVENT_LOG_ENTRIES 31
+
+void event_log_load(uint32_t persist_key);
+void event_log_save(void);
+void event_log_add(EventId id, int16_t arg);
+// Copies the log into entries, oldest first.  Returns the number copied.
+int event_log_read(EventLogEntry entries[EVENT_LOG_ENTRIES]);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <pebble.h>
+
+// Optional features, per platform.  Aplite has about 24 KB of app heap against 64 KB elsewhere, so it goes without
+// the extras that cost heap or resource space.  The matching settings are hidden on aplite in config.js and the
+// resources they need are left out of its build in package.json, whose targetPlatforms for them must name every
+// platform but aplite, emery included.
+//
+// On every platform, everything the watchface needs is allocated when the window loads.  The window state is static
+// and the hand paths are fixed, so once the first frame is drawn nothing is allocated until the window goes away.
+// The dial snapshot for direct drawing is part of that static state on black and white watches; only a color build
+// that opts in to direct drawing allocates one, on the first frame.
+#if defined(PBL_PLATFORM_APLITE)
+#define FEATURE_TIMEZONE 0                // the timezone readout
+#define FEATURE_SMALL_TEMPERATURE_FONT 0  // the small temperature size and its custom font
+#else
+#define FEATURE_TIMEZONE 1
+#define FEATURE_SMALL_TEMPERATURE_FONT 1
+#endif
+
+// Draw the dial, hands and second hand straight into the frame buffer (direct_draw.h) instead of through graphics_*.
+// On by default where it draws the same pixels as the stock calls, the platforms without antialiasing; on color
+// platforms the stock calls antialias the hands and it does not.  Build with FEATURE_DIRECT_DRAW set to compare
+// the two in the frame time histograms.  Opting in on color costs a heap allocation the size of the frame buffer.
+#ifndef FEATURE_DIRECT_DRAW
+#if defined(PBL_BW)
+#define FEATURE_DIRECT_DRAW 1
+#else
+#define FEATURE_DIRECT_DRAW 0
+#endif
+#endif
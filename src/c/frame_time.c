@@ -0,0 +1,85 @@
+#include "frame_time.h"
+#include "log.h"
+#include "pebble_patch.h"
+
+#if FRAME_TIME
+
+// Counts are halved once a histogram has this many samples, so they never saturate and recent launches weigh
+// more than old ones.
+#define FRAME_TIME_DECAY_SAMPLES 32768
+
+typedef struct {
+  Histogram procs[FRAME_PROC_COUNT];
+  Histogram frames;
+} FrameTimes;
+
+static char const *const s_proc_names[FRAME_PROC_COUNT] = {
+  [FRAME_PROC_BACKGROUND] = "background",
+  [FRAME_PROC_COMPLICATIONS] = "complications",
+  [FRAME_PROC_HANDS] = "hands",
+  [FRAME_PROC_SECONDS] = "seconds",
+};
+
+static FrameTimes s_times;
+static uint32_t s_persist_key;
+static bool s_dirty;
+
+static uint32_t s_begin_ms;        // proc being drawn
+static uint32_t s_frame_begin_ms;  // first proc of the current pass
+static uint32_t s_frame_end_ms;    // last proc of the current pass so far
+static int s_last_proc = -1;       // -1 until something has drawn
+
+void frame_time_load(uint32_t persist_key) {
+  s_persist_key = persist_key;
+  if (persist_read_data(persist_key, &s_times, sizeof(s_times)) != sizeof(s_times)) {
+    memset(&s_times, 0, sizeof(s_times));
+  }
+  s_dirty = false;
+}
+
+static void log_histogram(char const *name, Histogram const *histogram) {
+  LOG_INFO("draw %s: %lu samples, p50 %lums, p90 %lums, p99 %lums, max %lums", name, histogram->samples,
+           histogram_percentile(histogram, 50), histogram_percentile(histogram, 90),
+           histogram_percentile(histogram, 99), histogram->max);
+}
+
+void frame_time_save(void) {
+  if (!s_dirty) {
+    return;
+  }
+  for (int i = 0; i < FRAME_PROC_COUNT; ++i) {
+    log_histogram(s_proc_names[i], &s_times.procs[i]);
+  }
+  log_histogram("frame", &s_times.frames);
+
+  persist_write_data(s_persist_key, &s_times, sizeof(s_times));
+  s_dirty = false;
+}
+
+static void add(Histogram *histogram, uint32_t ms) {
+  if (histogram->samples >= FRAME_TIME_DECAY_SAMPLES) {
+    histogram_decay(histogram);
+  }
+  histogram_add(histogram, ms);
+}
+
+void frame_time_begin(FrameProc proc) {
+  s_begin_ms = time_ms_peek();
+  // Layers draw bottom up, so a proc no higher in the stack than the last one means a new pass.  The frame that
+  // just finished is only counted now, once all of its procs are in.
+  if ((int)proc <= s_last_proc) {
+    add(&s_times.frames, s_frame_end_ms - s_frame_begin_ms);
+  }
+  if ((int)proc <= s_last_proc || s_last_proc < 0) {
+    s_frame_begin_ms = s_begin_ms;
+  }
+  s_last_proc = proc;
+}
+
+void frame_time_end(FrameProc proc) {
+  s_frame_end_ms = time_ms_peek();
+  add(&s_times.procs[proc], s_frame_end_ms - s_begin_ms);
+  s_dirty = true;
+}
+
+#endif
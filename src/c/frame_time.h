@@ -0,0 +1,41 @@
+#pragma once
+
+#include <pebble.h>
+#include "histogram.h"
+
+// How long drawing takes on the watch itself.  Each update proc brackets itself with FRAME_TIME_BEGIN/END, which
+// adds its time to a histogram for that proc, and the procs drawn in one pass add up to a frame.  The histograms
+// carry over between launches in one persistent storage key, so they show the real cost on each platform and
+// whether a change to the drawing helped.  Build with FRAME_TIME 0 to compile all of it out.
+#ifndef FRAME_TIME
+#define FRAME_TIME 1
+#endif
+
+// In the order the layers are stacked, which is the order they draw in.
+typedef enum {
+  FRAME_PROC_BACKGROUND,
+  FRAME_PROC_COMPLICATIONS,
+  FRAME_PROC_HANDS,
+  FRAME_PROC_SECONDS,
+  FRAME_PROC_COUNT
+} FrameProc;
+
+#if FRAME_TIME
+
+void frame_time_load(uint32_t persist_key);
+// Logs the histograms and writes them out if anything was drawn since the last save.
+void frame_time_save(void);
+void frame_time_begin(FrameProc proc);
+void frame_time_end(FrameProc proc);
+
+#define FRAME_TIME_BEGIN(proc) frame_time_begin(proc)
+#define FRAME_TIME_END(proc) frame_time_end(proc)
+
+#else
+
+#define frame_time_load(persist_key)
+#define frame_time_save()
+#define FRAME_TIME_BEGIN(proc)
+#define FRAME_TIME_END(proc)
+
+#endif
@@ -0,0 +1,50 @@
+#include "histogram.h"
+
+static int histogram_bucket(uint32_t value) {
+  int bucket = 0;
+
+  while (value != 0 && bucket < HISTOGRAM_BUCKETS - 1) {
+    value >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+void histogram_add(Histogram *histogram, uint32_t value) {
+  uint16_t *count = &histogram->counts[histogram_bucket(value)];
+
+  if (*count < UINT16_MAX) {
+    ++*count;
+  }
+  ++histogram->samples;
+  if (value > histogram->max) {
+    histogram->max = value;
+  }
+}
+
+uint32_t histogram_percentile(Histogram const *histogram, int percent) {
+  uint32_t counted = 0;
+  for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+    counted += histogram->counts[i];
+  }
+  if (counted == 0) {
+    return 0;
+  }
+
+  uint32_t wanted = (counted * percent + 99) / 100;
+  uint32_t seen = 0;
+  for (int i = 0; i < HISTOGRAM_BUCKETS - 1; ++i) {
+    seen += histogram->counts[i];
+    if (seen >= wanted) {
+      return i == 0 ? 0 : (1u << i) - 1;
+    }
+  }
+  return histogram->max;
+}
+
+void histogram_decay(Histogram *histogram) {
+  for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+    histogram->counts[i] /= 2;
+  }
+  histogram->samples /= 2;
+}
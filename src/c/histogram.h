@@ -0,0 +1,19 @@
+#pragma once
+
+#include <pebble.h>
+
+// Power of two histogram.  Bucket 0 counts zeros and bucket i counts values in [2^(i-1), 2^i), with the last
+// bucket taking everything larger.  Small enough to keep several around and to persist as is.
+#define HISTOGRAM_BUCKETS 18
+
+typedef struct {
+  uint16_t counts[HISTOGRAM_BUCKETS];  // saturate rather than wrap
+  uint32_t samples;
+  uint32_t max;
+} Histogram;
+
+void histogram_add(Histogram *histogram, uint32_t value);
+// Upper bound of the bucket holding the given percentile, or 0 if the histogram is empty.
+uint32_t histogram_percentile(Histogram const *histogram, int percent);
+// Halves every count, so a long running histogram keeps its shape without saturating.
+void histogram_decay(Histogram *histogram);
@@ -1,6 +1,8 @@
 #include "watchface_window.h"
+#include "startup_profile.h"
 
 int main() {
+  startup_profile_begin();
   Window *watchface_window = watchface_window_create();
   watchface_window_show(watchface_window);
   app_event_loop();
@@ -0,0 +1,67 @@
+#include "motion_detector.h"
+#include "log.h"
+
+// The accel data service takes a plain function, so the running detector is kept here.
+static MotionDetector *s_running;
+
+static bool batch_moving(AccelData const *samples, uint32_t count) {
+  int min[3] = { INT16_MAX, INT16_MAX, INT16_MAX };
+  int max[3] = { INT16_MIN, INT16_MIN, INT16_MIN };
+  bool any = false;
+
+  for (uint32_t i = 0; i < count; ++i) {
+    if (samples[i].did_vibrate) {
+      continue;
+    }
+    int axes[3] = { samples[i].x, samples[i].y, samples[i].z };
+    for (int axis = 0; axis < 3; ++axis) {
+      if (axes[axis] < min[axis]) {
+        min[axis] = axes[axis];
+      }
+      if (axes[axis] > max[axis]) {
+        max[axis] = axes[axis];
+      }
+    }
+    any = true;
+  }
+  if (!any) {
+    return false;
+  }
+  for (int axis = 0; axis < 3; ++axis) {
+    if (max[axis] - min[axis] > MOTION_DETECTOR_THRESHOLD) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void data_received(AccelData *samples, uint32_t count) {
+  if (s_running != NULL && batch_moving(samples, count)) {
+    s_running->handler(s_running->context);
+  }
+}
+
+void motion_detector_start(MotionDetector *detector, MotionDetectorHandler handler, void *context) {
+  detector->handler = handler;
+  detector->context = context;
+  if (detector->running) {
+    return;
+  }
+  if (s_running != NULL) {
+    motion_detector_stop(s_running);
+  }
+  detector->running = true;
+  s_running = detector;
+  accel_data_service_subscribe(MOTION_DETECTOR_BATCH, data_received);
+  accel_service_set_sampling_rate(ACCEL_SAMPLING_10HZ);
+  LOG_DEBUG("motion detector started");
+}
+
+void motion_detector_stop(MotionDetector *detector) {
+  if (!detector->running) {
+    return;
+  }
+  accel_data_service_unsubscribe();
+  detector->running = false;
+  s_running = NULL;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <pebble.h>
+
+typedef void (*MotionDetectorHandler)(void *context);
+
+// Tells when the watch is being moved, from the accelerometer at its lowest sampling rate.  Samples come in batches
+// of MOTION_DETECTOR_BATCH, and a batch in which any axis swings by more than MOTION_DETECTOR_THRESHOLD counts as
+// motion.  A wrist at rest, or the watch on a nightstand, stays well under it, while turning the wrist to look is
+// far over.  Samples taken while the watch vibrated are left out.  Only one detector runs at a time.
+#define MOTION_DETECTOR_BATCH 25      // 2.5s at 10Hz
+#define MOTION_DETECTOR_THRESHOLD 80  // thousandths of a g
+
+typedef struct {
+  bool running;
+  MotionDetectorHandler handler;
+  void *context;
+} MotionDetector;
+
+// Calls handler for every batch with motion in it until stopped.
+void motion_detector_start(MotionDetector *detector, MotionDetectorHandler handler, void *context);
+void motion_detector_stop(MotionDetector *detector);
@@ -16,3 +16,26 @@ struct tm* local_time_peek() {
   time_t utc_time = time(NULL);
   return localtime(&utc_time);
 }
+
+// Minutes east of UTC for the watch's timezone at utc_time, including daylight saving time.
+int utc_offset_minutes(time_t utc_time) {
+  struct tm local = *localtime(&utc_time);  // copy, gmtime shares the buffer
+  struct tm *utc = gmtime(&utc_time);
+  int days = local.tm_yday - utc->tm_yday;
+
+  if (days > 1) {  // local time is still in last year
+    days = -1;
+  } else if (days < -1) {  // local time is already in next year
+    days = 1;
+  }
+  return days * 24 * 60 + (local.tm_hour - utc->tm_hour) * 60 + (local.tm_min - utc->tm_min);
+}
+
+// Milliseconds since the epoch, truncated to 32 bits.  Only good for measuring intervals.
+uint32_t time_ms_peek() {
+  time_t seconds;
+  uint16_t milliseconds;
+
+  time_ms(&seconds, &milliseconds);
+  return (uint32_t)seconds * 1000 + milliseconds;
+}
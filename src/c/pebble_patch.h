@@ -12,3 +12,5 @@ bool persist_read_bool_or_default(uint32_t key, bool default_value);
 int32_t persist_read_int_or_default(uint32_t key, int32_t default_value);
 
 struct tm* local_time_peek();
+int utc_offset_minutes(time_t utc_time);
+uint32_t time_ms_peek();
@@ -0,0 +1,143 @@
+#include "radio_stats.h"
+#include "log.h"
+#include "pebble_patch.h"
+
+// Today in full.
+typedef struct {
+  uint16_t day;  // local days since the epoch
+  uint16_t outcomes[RADIO_OUTCOME_COUNT];
+  RadioCount sent[RADIO_MESSAGE_TYPES];
+  RadioCount received[RADIO_MESSAGE_TYPES];
+} RadioDay;
+
+// An earlier day, summed over message types.
+typedef struct {
+  uint16_t day;
+  uint16_t failures;
+  RadioCount sent;
+  RadioCount received;
+} RadioDayTotal;
+
+// Sized so it fits in one persistent storage key.
+typedef struct {
+  RadioDay today;
+  RadioDayTotal history[RADIO_HISTORY_DAYS];  // newest first; day 0 if empty
+} RadioStats;
+
+static RadioStats s_stats;
+static uint32_t s_persist_key;
+static bool s_dirty;
+
+static uint16_t local_day(void) {
+  time_t now = time(NULL);
+  return (now + utc_offset_minutes(now) * 60) / (24 * 60 * 60);
+}
+
+static RadioDayTotal total(RadioDay const *day) {
+  RadioDayTotal total = { .day = day->day };
+
+  for (int i = 0; i < RADIO_MESSAGE_TYPES; ++i) {
+    total.sent.messages += day->sent[i].messages;
+    total.sent.bytes += day->sent[i].bytes;
+    total.received.messages += day->received[i].messages;
+    total.received.bytes += day->received[i].bytes;
+  }
+  for (int i = RADIO_TIMEOUT; i <= RADIO_BEGIN_FAILED; ++i) {
+    total.failures += day->outcomes[i];
+  }
+  return total;
+}
+
+static RadioDay *today(void) {
+  uint16_t day = local_day();
+
+  if (s_stats.today.day != day) {
+    if (s_stats.today.day != 0) {
+      memmove(&s_stats.history[1], &s_stats.history[0], sizeof(s_stats.history) - sizeof(s_stats.history[0]));
+      s_stats.history[0] = total(&s_stats.today);
+    }
+    s_stats.today = (RadioDay) { .day = day };
+    s_dirty = true;
+  }
+  return &s_stats.today;
+}
+
+static int type_slot(int message_type) {
+  return message_type >= 0 && message_type < RADIO_MESSAGE_TYPES ? message_type : RADIO_MESSAGE_TYPES - 1;
+}
+
+static void count(RadioCount *count, uint32_t bytes) {
+  if (count->messages < UINT16_MAX) {
+    ++count->messages;
+  }
+  count->bytes += bytes;
+  s_dirty = true;
+}
+
+void radio_stats_load(uint32_t persist_key) {
+  s_persist_key = persist_key;
+  if (persist_read_data(persist_key, &s_stats, sizeof(s_stats)) != sizeof(s_stats)) {
+    memset(&s_stats, 0, sizeof(s_stats));
+  }
+  s_dirty = false;
+}
+
+static void log_stats(void) {
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+  RadioDayTotal now = total(&s_stats.today);
+
+  LOG_INFO("radio today: sent %u (%lu bytes), received %u (%lu bytes), %u failed, %u restarts", now.sent.messages,
+           now.sent.bytes, now.received.messages, now.received.bytes, now.failures,
+           s_stats.today.outcomes[RADIO_RESTART]);
+  for (int i = 0; i < RADIO_HISTORY_DAYS && s_stats.history[i].day != 0; ++i) {
+    RadioDayTotal const *day = &s_stats.history[i];
+    LOG_INFO("radio %d days ago: sent %u (%lu bytes), received %u (%lu bytes), %u failed", now.day - day->day,
+             day->sent.messages, day->sent.bytes, day->received.messages, day->received.bytes, day->failures);
+  }
+#endif
+}
+
+void radio_stats_save(void) {
+  today();  // roll over first if the day has changed
+  log_stats();
+
+  if (s_dirty) {
+    persist_write_data(s_persist_key, &s_stats, sizeof(s_stats));
+    s_dirty = false;
+  }
+}
+
+void radio_stats_sent(int message_type, uint32_t bytes) {
+  count(&today()->sent[type_slot(message_type)], bytes);
+}
+
+void radio_stats_received(int message_type, uint32_t bytes) {
+  count(&today()->received[type_slot(message_type)], bytes);
+}
+
+void radio_stats_outcome(RadioOutcome outcome) {
+  uint16_t *outcomes = today()->outcomes;
+
+  if (outcomes[outcome] < UINT16_MAX) {
+    ++outcomes[outcome];
+  }
+  s_dirty = true;
+}
+
+void radio_stats_send_failed(AppMessageResult reason) {
+  switch (reason) {
+    case APP_MSG_SEND_TIMEOUT:
+      radio_stats_outcome(RADIO_TIMEOUT);
+      break;
+    case APP_MSG_NOT_CONNECTED:
+    case APP_MSG_APP_NOT_RUNNING:
+      radio_stats_outcome(RADIO_NOT_CONNECTED);
+      break;
+    case APP_MSG_BUSY:
+      radio_stats_outcome(RADIO_BUSY);
+      break;
+    default:
+      radio_stats_outcome(RADIO_OTHER_FAILURE);
+      break;
+  }
+}
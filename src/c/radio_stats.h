@@ -0,0 +1,37 @@
+#pragma once
+
+#include <pebble.h>
+
+// What the watch costs in radio traffic.  Every AppMessage in and out is counted by message type, along with how
+// each send turned out, and the counts roll over into a short history of daily totals kept in one persistent
+// storage key.  Bytes are dict_size of the message, which is what goes over the air less the protocol overhead.
+
+// Message types counted separately.  Higher ones share the last slot.
+#define RADIO_MESSAGE_TYPES 6
+// Days of totals kept besides today.
+#define RADIO_HISTORY_DAYS 6
+
+typedef enum {
+  RADIO_SENT,           // outbox_sent
+  RADIO_TIMEOUT,        // APP_MSG_SEND_TIMEOUT
+  RADIO_NOT_CONNECTED,  // APP_MSG_NOT_CONNECTED or APP_MSG_APP_NOT_RUNNING
+  RADIO_BUSY,           // APP_MSG_BUSY
+  RADIO_OTHER_FAILURE,
+  RADIO_BEGIN_FAILED,   // app_message_outbox_begin refused, so nothing went out
+  RADIO_RESTART,        // the watchface restarted itself to get out of APP_MSG_BUSY
+  RADIO_OUTCOME_COUNT
+} RadioOutcome;
+
+typedef struct {
+  uint16_t messages;
+  uint32_t bytes;
+} RadioCount;
+
+void radio_stats_load(uint32_t persist_key);
+// Logs today and the days before, then writes them out if anything changed since the last save.
+void radio_stats_save(void);
+void radio_stats_sent(int message_type, uint32_t bytes);
+void radio_stats_received(int message_type, uint32_t bytes);
+void radio_stats_outcome(RadioOutcome outcome);
+// For an AppMessageResult from a send, either straight away or in outbox_failed.
+void radio_stats_send_failed(AppMessageResult reason);
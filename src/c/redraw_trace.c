@@ -0,0 +1,87 @@
+#include "redraw_trace.h"
+#include "trace_table.h"
+#include "log.h"
+
+#if REDRAW_TRACE
+
+// Entries are named by layer for marks, with the function that asked as the cause, and by update proc for draws.
+enum {
+  REDRAW_COUNT,
+  REDRAW_COALESCED,  // marks of a layer that was already waiting to be drawn
+};
+
+static TraceTableEntry s_entries[REDRAW_TRACE_ENTRIES + 1];
+static TraceTable s_table = { s_entries, ARRAY_LENGTH(s_entries), 0 };
+
+// Layers marked since they last drew, so repeated marks within one frame can be told apart.
+static Layer *s_pending[8];
+static int s_pending_count;
+
+static char const *s_drawing;  // update proc running right now, if any
+static uint16_t s_mutations;
+
+static bool take_pending(Layer *layer) {
+  for (int i = 0; i < s_pending_count; ++i) {
+    if (s_pending[i] == layer) {
+      s_pending[i] = s_pending[--s_pending_count];
+      return true;
+    }
+  }
+  return false;
+}
+
+void redraw_trace_mark_dirty(Layer *layer, char const *layer_name, char const *cause) {
+  TraceTableEntry *entry = trace_table_entry(&s_table, layer_name, cause);
+  ++entry->counts[REDRAW_COUNT];
+
+  if (take_pending(layer)) {
+    ++entry->counts[REDRAW_COALESCED];
+  }
+  if (s_pending_count < (int)ARRAY_LENGTH(s_pending)) {
+    s_pending[s_pending_count++] = layer;
+  }
+
+  if (s_drawing != NULL) {
+    LOG_WARNING("redraw: %s marked %s dirty while %s was drawing", cause, layer_name, s_drawing);
+  }
+  layer_mark_dirty(layer);
+}
+
+void redraw_trace_draw_begin(char const *proc) {
+  ++trace_table_entry(&s_table, proc, NULL)->counts[REDRAW_COUNT];
+  s_drawing = proc;
+  // Whatever was waiting on this frame is being drawn now.
+  s_pending_count = 0;
+}
+
+void redraw_trace_draw_end(void) {
+  s_drawing = NULL;
+}
+
+void redraw_trace_mutation(char const *what, char const *cause) {
+  if (s_drawing != NULL) {
+    ++s_mutations;
+    LOG_WARNING("redraw: %s changed %s while %s was drawing", cause, what, s_drawing);
+  }
+}
+
+void redraw_trace_log(void) {
+  LOG_WARNING("redraws this minute (%d changes made while drawing):", s_mutations);
+  for (int i = 0; i < s_table.size; ++i) {
+    TraceTableEntry const *entry = &s_entries[i];
+    if (entry->counts[REDRAW_COUNT] == 0) {
+      continue;
+    }
+    if (entry->cause == NULL) {
+      LOG_WARNING("  %5d draws by %s", entry->counts[REDRAW_COUNT], entry->name);
+    } else {
+      LOG_WARNING("  %5d marks of %s from %s (%d already dirty)",
+                  entry->counts[REDRAW_COUNT], entry->name, entry->cause, entry->counts[REDRAW_COALESCED]);
+    }
+  }
+
+  trace_table_reset(&s_table);
+  s_mutations = 0;
+}
+
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <pebble.h>
+
+// Redraw tracer.  Build with REDRAW_TRACE 1 to find out what is invalidating which layer and how often: every
+// mark goes through REDRAW_MARK_DIRTY, which remembers the layer and the function that asked, every update proc
+// brackets itself with REDRAW_DRAW_BEGIN/END, and state changed while a proc is drawing is logged as a warning.
+// Once a minute the counts are logged, at warning level too so the default log level shows them, and reset.  With
+// REDRAW_TRACE 0 everything compiles down to the plain SDK calls.
+#ifndef REDRAW_TRACE
+#define REDRAW_TRACE 0
+#endif
+
+#if REDRAW_TRACE
+
+// Distinct (layer, cause) pairs and update procs counted per minute, past which they go in one "(other)" entry.
+#define REDRAW_TRACE_ENTRIES 24
+
+void redraw_trace_mark_dirty(Layer *layer, char const *layer_name, char const *cause);
+void redraw_trace_draw_begin(char const *proc);
+void redraw_trace_draw_end(void);
+void redraw_trace_mutation(char const *what, char const *cause);
+void redraw_trace_log(void);
+
+#define REDRAW_CAUSE __func__
+#define REDRAW_MARK_DIRTY(layer, cause) redraw_trace_mark_dirty((layer), #layer, (cause))
+#define REDRAW_DRAW_BEGIN() redraw_trace_draw_begin(__func__)
+#define REDRAW_DRAW_END() redraw_trace_draw_end()
+#define REDRAW_MUTATION(what, cause) redraw_trace_mutation((what), (cause))
+#define REDRAW_LOG() redraw_trace_log()
+
+#else
+
+#define REDRAW_CAUSE NULL
+#define REDRAW_MARK_DIRTY(layer, cause) layer_mark_dirty(layer)
+#define REDRAW_DRAW_BEGIN()
+#define REDRAW_DRAW_END()
+#define REDRAW_MUTATION(what, cause)
+#define REDRAW_LOG()
+
+#endif
@@ -0,0 +1,59 @@
+#include "round_trip.h"
+#include "log.h"
+#include "pebble_patch.h"
+
+void round_trip_request_sent(RoundTripStats *stats, int message_id, uint32_t bytes) {
+  if (stats->pending_message_id != 0) {
+    ++stats->lost;
+  }
+  stats->pending_message_id = message_id;
+  stats->pending_sent_ms = time_ms_peek();
+  stats->pending_request_bytes = bytes;
+}
+
+static void count_failure(RoundTripStats *stats, AppMessageResult reason) {
+  if (reason == APP_MSG_BUSY) {
+    ++stats->busy;
+  } else {
+    ++stats->send_failed;
+  }
+}
+
+void round_trip_send_failed(RoundTripStats *stats, int message_id, AppMessageResult reason) {
+  if (message_id == stats->pending_message_id) {
+    stats->pending_message_id = 0;  // counted here, so do not count it as lost as well
+  }
+  count_failure(stats, reason);
+}
+
+void round_trip_begin_failed(RoundTripStats *stats, AppMessageResult reason) {
+  count_failure(stats, reason);
+}
+
+void round_trip_reply_received(RoundTripStats *stats, int message_id, uint32_t bytes) {
+  if (message_id != stats->pending_message_id) {
+    ++stats->stale;
+    return;
+  }
+
+  histogram_add(&stats->latency_ms, time_ms_peek() - stats->pending_sent_ms);
+  ++stats->completed;
+  stats->request_bytes += stats->pending_request_bytes;
+  stats->reply_bytes += bytes;
+  stats->pending_message_id = 0;
+}
+
+void round_trip_log(RoundTripStats const *stats) {
+  if (stats->completed == 0) {
+    LOG_DEBUG("weather round trips: none completed, %lu lost %lu failed %lu busy",
+              stats->lost, stats->send_failed, stats->busy);
+    return;
+  }
+
+  LOG_DEBUG("weather round trips: p50 <=%lums p90 <=%lums p99 <=%lums max %lums",
+            histogram_percentile(&stats->latency_ms, 50), histogram_percentile(&stats->latency_ms, 90),
+            histogram_percentile(&stats->latency_ms, 99), stats->latency_ms.max);
+  LOG_DEBUG("  %lu bytes out + %lu bytes back per update, %lu ok %lu lost %lu stale %lu failed %lu busy",
+            stats->request_bytes / stats->completed, stats->reply_bytes / stats->completed,
+            stats->completed, stats->lost, stats->stale, stats->send_failed, stats->busy);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <pebble.h>
+#include "histogram.h"
+
+// Weather requests from the watch to the phone and back: how long they take, how many bytes they cost, and how
+// many never make it.
+typedef struct {
+  Histogram latency_ms;
+  uint32_t completed;
+  uint32_t lost;         // a new request went out before the last one was answered
+  uint32_t stale;        // answers that came back after we had given up on them
+  uint32_t send_failed;  // outbox failures other than busy
+  uint32_t busy;         // APP_MSG_BUSY, which we recover from by restarting the watchface
+  uint32_t request_bytes;  // for completed round trips only
+  uint32_t reply_bytes;
+
+  int pending_message_id;  // 0 if nothing is outstanding
+  uint32_t pending_sent_ms;
+  uint32_t pending_request_bytes;
+} RoundTripStats;
+
+void round_trip_request_sent(RoundTripStats *stats, int message_id, uint32_t bytes);
+// The request for message_id did not go out.  It stops being outstanding only if it is the one we are waiting on.
+void round_trip_send_failed(RoundTripStats *stats, int message_id, AppMessageResult reason);
+// The outbox could not be opened, so no request was written.  Whatever is outstanding still is.
+void round_trip_begin_failed(RoundTripStats *stats, AppMessageResult reason);
+void round_trip_reply_received(RoundTripStats *stats, int message_id, uint32_t bytes);
+void round_trip_log(RoundTripStats const *stats);
@@ -0,0 +1,125 @@
+#include "save_under.h"
+
+// Row y of the frame buffer, with the first and last bytes of it that are on screen.
+static uint8_t *row_bytes(GBitmap *frame_buffer, int y, int *first, int *last) {
+  GRect bounds = gbitmap_get_bounds(frame_buffer);
+
+  switch (gbitmap_get_format(frame_buffer)) {
+    case GBitmapFormat1Bit:
+      *first = 0;
+      *last = (bounds.size.w - 1) / 8;
+      return gbitmap_get_data(frame_buffer) + y * gbitmap_get_bytes_per_row(frame_buffer);
+    case GBitmapFormat8Bit:
+      *first = 0;
+      *last = bounds.size.w - 1;
+      return gbitmap_get_data(frame_buffer) + y * gbitmap_get_bytes_per_row(frame_buffer);
+#if defined(PBL_ROUND)
+    case GBitmapFormat8BitCircular: {
+      GBitmapDataRowInfo info = gbitmap_get_data_row_info(frame_buffer, y);
+      *first = info.min_x;
+      *last = info.max_x;
+      return info.data;
+    }
+#endif
+    default:
+      return NULL;
+  }
+}
+
+static int pixels_per_byte(GBitmap *frame_buffer) {
+  return gbitmap_get_format(frame_buffer) == GBitmapFormat1Bit ? 8 : 1;
+}
+
+// x on the line at row y, with y held to the rows the line covers.
+static int line_x(GPoint from, GPoint to, int y) {
+  int min_y = from.y < to.y ? from.y : to.y;
+  int max_y = from.y < to.y ? to.y : from.y;
+
+  y = y < min_y ? min_y : (y > max_y ? max_y : y);
+  return from.x + (y - from.y) * (to.x - from.x) / (to.y - from.y);
+}
+
+bool save_under_capture(SaveUnder *save_under, GBitmap *frame_buffer, GPoint from, GPoint to, int margin) {
+  GRect bounds = gbitmap_get_bounds(frame_buffer);
+  int per_byte = pixels_per_byte(frame_buffer);
+  int first_y = (from.y < to.y ? from.y : to.y) - margin;
+  int last_y = (from.y < to.y ? to.y : from.y) + margin;
+  int used = 0;
+
+  save_under->valid = false;
+  save_under->span_count = 0;
+
+  first_y = first_y < 0 ? 0 : first_y;
+  last_y = last_y >= bounds.size.h ? bounds.size.h - 1 : last_y;
+  if (last_y - first_y + 1 > SAVE_UNDER_ROWS) {
+    return false;
+  }
+
+  for (int y = first_y; y <= last_y; ++y) {
+    int first, last;
+    uint8_t *row = row_bytes(frame_buffer, y, &first, &last);
+    if (row == NULL) {
+      return false;
+    }
+
+    // The line crosses this row somewhere between where it is on the rows either side.
+    int left, right;
+    if (from.y == to.y) {
+      left = from.x < to.x ? from.x : to.x;
+      right = from.x < to.x ? to.x : from.x;
+    } else {
+      int above = line_x(from, to, y - 1);
+      int below = line_x(from, to, y + 1);
+      left = above < below ? above : below;
+      right = above < below ? below : above;
+    }
+    left -= margin;
+    right += margin;
+    if (right < 0 || left >= bounds.size.w) {
+      continue;
+    }
+    int start = (left < 0 ? 0 : left) / per_byte;
+    int end = (right >= bounds.size.w ? bounds.size.w - 1 : right) / per_byte;
+    start = start < first ? first : start;
+    end = end > last ? last : end;
+    if (start > end) {
+      continue;
+    }
+
+    int length = end - start + 1;
+    if (used + length > SAVE_UNDER_BYTES) {
+      save_under->span_count = 0;
+      return false;
+    }
+    memcpy(&save_under->bytes[used], &row[start], length);
+    save_under->spans[save_under->span_count++] = (SaveUnderSpan) { .y = y, .start = start, .length = length };
+    used += length;
+  }
+
+  save_under->valid = true;
+  return true;
+}
+
+void save_under_restore(SaveUnder *save_under, GBitmap *frame_buffer) {
+  int used = 0;
+
+  if (!save_under->valid) {
+    return;
+  }
+  for (int i = 0; i < save_under->span_count; ++i) {
+    SaveUnderSpan const *span = &save_under->spans[i];
+    int first, last;
+    uint8_t *row = row_bytes(frame_buffer, span->y, &first, &last);
+
+    if (row != NULL) {
+      memcpy(&row[span->start], &save_under->bytes[used], span->length);
+    }
+    used += span->length;
+  }
+  save_under_invalidate(save_under);
+}
+
+void save_under_invalidate(SaveUnder *save_under) {
+  save_under->valid = false;
+  save_under->span_count = 0;
+}
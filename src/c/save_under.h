@@ -0,0 +1,38 @@
+#pragma once
+
+#include <pebble.h>
+
+// Frame buffer pixels saved from under a thin line before it is drawn, so the line can be taken away again by
+// putting them back rather than by drawing the whole scene under it.  The cost is in proportion to the length of
+// the line, not the size of the screen.
+//
+// Pixels are saved a row at a time, whole bytes at a time: every pixel on 8 bit frame buffers, eight at a time on
+// 1 bit ones.  Round frame buffers are saved within each row's visible span.
+
+// Enough for a line the length of the radius of the largest screen, with its margin.
+#define SAVE_UNDER_ROWS 96
+#if defined(PBL_BW)
+#define SAVE_UNDER_BYTES 192
+#else
+#define SAVE_UNDER_BYTES 512
+#endif
+
+typedef struct {
+  int16_t y;
+  int16_t start;    // first byte of the row saved
+  uint16_t length;  // bytes saved
+} SaveUnderSpan;
+
+typedef struct {
+  bool valid;
+  uint16_t span_count;
+  SaveUnderSpan spans[SAVE_UNDER_ROWS];
+  uint8_t bytes[SAVE_UNDER_BYTES];
+} SaveUnder;
+
+// Saves the pixels within margin of the line from `from` to `to`.  Returns false, leaving nothing saved, if the
+// frame buffer format is not one we know or the line does not fit.
+bool save_under_capture(SaveUnder *save_under, GBitmap *frame_buffer, GPoint from, GPoint to, int margin);
+// Puts back what was saved, if anything, and forgets it.
+void save_under_restore(SaveUnder *save_under, GBitmap *frame_buffer);
+void save_under_invalidate(SaveUnder *save_under);
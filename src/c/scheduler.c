@@ -0,0 +1,84 @@
+#include "scheduler.h"
+#include "alloc_trace.h"
+#include "log.h"
+
+static void dispatch(void *data);
+
+static void arm(Scheduler *scheduler) {
+  if (scheduler->dispatching) {
+    return;
+  }
+
+  time_t next = 0;
+  for (int i = 0; i < SCHEDULER_JOBS; ++i) {
+    if (scheduler->deadlines[i] != 0 && (next == 0 || scheduler->deadlines[i] < next)) {
+      next = scheduler->deadlines[i];
+    }
+  }
+
+  if (next == 0) {
+    if (scheduler->timer != NULL) {
+      app_timer_cancel(scheduler->timer);
+      scheduler->timer = NULL;
+    }
+    return;
+  }
+
+  time_t now;
+  uint16_t now_ms;
+  time_ms(&now, &now_ms);
+  int32_t delay_ms = (next - now) * 1000 - now_ms;
+  if (delay_ms < 0) {
+    delay_ms = 0;
+  }
+
+  if (scheduler->timer == NULL || !app_timer_reschedule(scheduler->timer, delay_ms)) {
+    scheduler->timer = app_timer_register(delay_ms, dispatch, scheduler);
+  }
+}
+
+static void dispatch(void *data) {
+  Scheduler *scheduler = data;
+  time_t now = time(NULL);
+
+  ALLOC_TRACE_STEADY_BEGIN();
+  scheduler->timer = NULL;
+  scheduler->dispatching = true;
+  for (int i = 0; i < SCHEDULER_JOBS; ++i) {
+    if (scheduler->deadlines[i] != 0 && scheduler->deadlines[i] <= now) {
+      // Cleared first so the handler can schedule the job again.
+      scheduler->deadlines[i] = 0;
+      LOG_DEBUG("scheduler: job %d due", i);
+      scheduler->handlers[i](scheduler->context);
+    }
+  }
+  scheduler->dispatching = false;
+  arm(scheduler);
+  ALLOC_TRACE_END();
+}
+
+void scheduler_init(Scheduler *scheduler, void *context) {
+  *scheduler = (Scheduler) { .context = context };
+}
+
+void scheduler_at(Scheduler *scheduler, int job, time_t deadline, SchedulerHandler handler) {
+  scheduler->deadlines[job] = deadline;
+  scheduler->handlers[job] = handler;
+  arm(scheduler);
+}
+
+void scheduler_cancel(Scheduler *scheduler, int job) {
+  if (scheduler->deadlines[job] != 0) {
+    scheduler->deadlines[job] = 0;
+    arm(scheduler);
+  }
+}
+
+bool scheduler_pending(Scheduler const *scheduler, int job) {
+  return scheduler->deadlines[job] != 0;
+}
+
+void scheduler_stop(Scheduler *scheduler) {
+  memset(scheduler->deadlines, 0, sizeof(scheduler->deadlines));
+  arm(scheduler);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <pebble.h>
+
+typedef void (*SchedulerHandler)(void *context);
+
+// Everything the watchface does at a given time rather than in response to something.  Each job has at most one
+// deadline, to the second, and a single AppTimer is kept armed for whichever comes first, so nothing has to look
+// at the clock on every tick to see if it is time yet.
+#define SCHEDULER_JOBS 8
+
+typedef struct {
+  time_t deadlines[SCHEDULER_JOBS];  // 0 if the job is not scheduled
+  SchedulerHandler handlers[SCHEDULER_JOBS];
+  void *context;
+  AppTimer *timer;
+  bool dispatching;  // running handlers; the timer is armed once they are all done
+} Scheduler;
+
+void scheduler_init(Scheduler *scheduler, void *context);
+// Runs handler at deadline, replacing whatever job was scheduled before.  A deadline in the past runs as soon as
+// the app is idle.
+void scheduler_at(Scheduler *scheduler, int job, time_t deadline, SchedulerHandler handler);
+void scheduler_cancel(Scheduler *scheduler, int job);
+bool scheduler_pending(Scheduler const *scheduler, int job);
+// Cancels every job.
+void scheduler_stop(Scheduler *scheduler);
@@ -0,0 +1,96 @@
+#include "solar.h"
+
+// Fixed point sunrise/sunset using the usual low precision approximations for the solar declination and the
+// equation of time.
+// Angles are kept in Pebble trig units (TRIG_MAX_ANGLE per turn) so the SDK lookup tables do the trigonometry.
+// Good to within a couple of minutes, which is plenty for picking day or night icons.
+
+// sin(23.44 degrees), Earth's axial tilt, as a trig ratio.
+#define SIN_AXIAL_TILT 26069
+// Correction for the eccentricity of Earth's orbit, 1.914 degrees.
+#define ORBIT_ECCENTRICITY_ANGLE (TRIG_MAX_ANGLE * 1914 / 360000)
+// Altitude of the sun's center at sunrise and sunset, -0.833 degrees to account for refraction and the disc.
+#define SUNRISE_ALTITUDE_ANGLE (-TRIG_MAX_ANGLE * 833 / 360000)
+
+static int32_t normalize_angle(int32_t angle) {
+  angle %= TRIG_MAX_ANGLE;
+  return angle < 0 ? angle + TRIG_MAX_ANGLE : angle;
+}
+
+static int32_t sin_angle(int32_t angle) {
+  return sin_lookup(normalize_angle(angle));
+}
+
+static int32_t cos_angle(int32_t angle) {
+  return cos_lookup(normalize_angle(angle));
+}
+
+// The SDK has no acos_lookup.  cos is decreasing over the first half turn, so binary search it.
+static int32_t acos_angle(int32_t ratio) {
+  int32_t low = 0;
+  int32_t high = TRIG_MAX_ANGLE / 2;
+
+  while (low < high) {
+    int32_t mid = (low + high) / 2;
+    if (cos_lookup(mid) > ratio) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+static int16_t wrap_minutes(int32_t minutes) {
+  minutes %= MINUTES_PER_DAY;
+  return minutes < 0 ? minutes + MINUTES_PER_DAY : minutes;
+}
+
+SolarDay solar_day_compute(SolarLocation const *location, int day_of_year, int utc_offset_minutes) {
+  // day_of_year is 0 based like tm_yday.  The approximations below want it 1 based.
+  int day = day_of_year + 1;
+
+  // sin(declination) = -sin(tilt) cos(days since the December solstice, corrected for the orbit's eccentricity)
+  int32_t orbit = TRIG_MAX_ANGLE * (day + 10) / 365
+                  + ORBIT_ECCENTRICITY_ANGLE * sin_angle(TRIG_MAX_ANGLE * (day - 2) / 365) / TRIG_MAX_RATIO;
+  int32_t declination = TRIG_MAX_ANGLE / 4 - acos_angle(-(int64_t)SIN_AXIAL_TILT * cos_angle(orbit) / TRIG_MAX_RATIO);
+
+  // Equation of time in hundredths of a minute.
+  int32_t b = TRIG_MAX_ANGLE * (day - 81) / 364;
+  int32_t equation_of_time = (987 * sin_angle(2 * b) - 753 * cos_angle(b) - 150 * sin_angle(b)) / TRIG_MAX_RATIO;
+
+  // cos(hour angle) = (sin(altitude) - sin(latitude) sin(declination)) / (cos(latitude) cos(declination))
+  int32_t latitude = (int64_t)location->latitude * TRIG_MAX_ANGLE / (360 * 10000);
+  int64_t numerator = (int64_t)sin_angle(SUNRISE_ALTITUDE_ANGLE) * TRIG_MAX_RATIO
+                      - (int64_t)sin_angle(latitude) * sin_angle(declination);
+  int64_t denominator = (int64_t)cos_angle(latitude) * cos_angle(declination);
+
+  if (numerator >= denominator) {
+    return (SolarDay) { .sunrise = 0, .sunset = 0 };  // polar night
+  }
+  if (numerator <= -denominator) {
+    return (SolarDay) { .sunrise = 0, .sunset = MINUTES_PER_DAY };  // midnight sun
+  }
+
+  int32_t hour_angle = acos_angle(numerator * TRIG_MAX_RATIO / denominator);
+  int32_t half_day = hour_angle * MINUTES_PER_DAY / TRIG_MAX_ANGLE;
+  if (half_day >= MINUTES_PER_DAY / 2) {
+    return (SolarDay) { .sunrise = 0, .sunset = MINUTES_PER_DAY };
+  }
+
+  // 4 minutes per degree of longitude, and longitude is in 1/10000 degree.
+  int32_t noon = MINUTES_PER_DAY / 2 - location->longitude / 2500 - equation_of_time / 100 + utc_offset_minutes;
+
+  return (SolarDay) {
+    .sunrise = wrap_minutes(noon - half_day),
+    .sunset = wrap_minutes(noon + half_day),
+  };
+}
+
+bool solar_is_daylight(SolarDay const *day, int minute_of_day) {
+  if (day->sunrise <= day->sunset) {
+    return minute_of_day >= day->sunrise && minute_of_day < day->sunset;
+  }
+  // Daylight wraps past local midnight.
+  return minute_of_day >= day->sunrise || minute_of_day < day->sunset;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <pebble.h>
+
+// Latitude and longitude in 1/10000 of a degree, north and east positive.
+typedef struct {
+  int32_t latitude;
+  int32_t longitude;
+} SolarLocation;
+
+// Sunrise and sunset in minutes after local midnight.  The sun is up from sunrise until sunset, which may wrap
+// past midnight.  Polar night has sunrise == sunset, midnight sun has sunrise 0 and sunset MINUTES_PER_DAY.
+typedef struct {
+  int16_t sunrise;
+  int16_t sunset;
+} SolarDay;
+
+#define MINUTES_PER_DAY (24 * 60)
+
+SolarDay solar_day_compute(SolarLocation const *location, int day_of_year, int utc_offset_minutes);
+bool solar_is_daylight(SolarDay const *day, int minute_of_day);
@@ -0,0 +1,72 @@
+#include "startup_profile.h"
+#include "log.h"
+#include "pebble_patch.h"
+
+typedef struct {
+  uint8_t next;  // slot the next launch goes in
+  StartupProfile profiles[STARTUP_PROFILE_HISTORY];
+} StartupProfileHistory;
+
+static uint32_t s_begin_ms;
+static StartupProfile s_profile;
+static bool s_saved;
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+static char const *const s_phase_names[STARTUP_PHASE_COUNT] = {
+  [STARTUP_PHASE_SETTINGS] = "settings",
+  [STARTUP_PHASE_APP_MESSAGE] = "app message",
+  [STARTUP_PHASE_LOAD] = "load",
+  [STARTUP_PHASE_APPEAR] = "appear",
+  [STARTUP_PHASE_FIRST_FRAME] = "first frame",
+  [STARTUP_PHASE_READY] = "ready",
+  [STARTUP_PHASE_FIRST_WEATHER] = "first weather",
+};
+#endif
+
+void startup_profile_begin(void) {
+  s_begin_ms = time_ms_peek();
+  s_profile = (StartupProfile) { .launched = time(NULL) };
+  s_saved = false;
+}
+
+void startup_profile_mark(StartupPhase phase) {
+  if (s_profile.phase_ms[phase] == 0) {
+    // A phase that finishes inside the first millisecond still counts as reached.
+    uint32_t elapsed = time_ms_peek() - s_begin_ms;
+    s_profile.phase_ms[phase] = elapsed > 0 ? elapsed : 1;
+  }
+}
+
+void startup_profile_save(uint32_t persist_key) {
+  if (s_saved) {
+    return;
+  }
+  s_saved = true;
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+  for (int i = 0; i < STARTUP_PHASE_COUNT; ++i) {
+    if (s_profile.phase_ms[i] != 0) {
+      LOG_DEBUG("startup: %s at %lums", s_phase_names[i], s_profile.phase_ms[i]);
+    }
+  }
+#endif
+
+  StartupProfileHistory history;
+  if (persist_read_data(persist_key, &history, sizeof(history)) != sizeof(history)
+      || history.next >= STARTUP_PROFILE_HISTORY) {
+    memset(&history, 0, sizeof(history));
+  }
+
+  // Older launches, oldest first, to compare against.
+  for (int i = 0; i < STARTUP_PROFILE_HISTORY; ++i) {
+    StartupProfile const *profile = &history.profiles[(history.next + i) % STARTUP_PROFILE_HISTORY];
+    if (profile->launched != 0) {
+      LOG_DEBUG("startup earlier: first frame %lums, first weather %lums",
+                profile->phase_ms[STARTUP_PHASE_FIRST_FRAME], profile->phase_ms[STARTUP_PHASE_FIRST_WEATHER]);
+    }
+  }
+
+  history.profiles[history.next] = s_profile;
+  history.next = (history.next + 1) % STARTUP_PROFILE_HISTORY;
+  persist_write_data(persist_key, &history, sizeof(history));
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <pebble.h>
+
+// Where launch time goes.  Each phase is stamped the first time it finishes, in milliseconds since main()
+// started, and the last few launches are kept in persistent storage so regressions show up across builds.
+typedef enum {
+  STARTUP_PHASE_SETTINGS,       // settings read back from persistent storage
+  STARTUP_PHASE_APP_MESSAGE,    // app_message_open
+  STARTUP_PHASE_LOAD,           // fonts and layers created
+  STARTUP_PHASE_APPEAR,         // services subscribed and the dial filled in
+  STARTUP_PHASE_FIRST_FRAME,    // every layer has drawn once
+  STARTUP_PHASE_READY,          // PebbleKit JS said it is ready
+  STARTUP_PHASE_FIRST_WEATHER,  // first weather reply from the phone
+  STARTUP_PHASE_COUNT
+} StartupPhase;
+
+// Launches kept.  Sized so the whole history fits in one persistent storage key.
+#define STARTUP_PROFILE_HISTORY 6
+
+typedef struct {
+  time_t launched;
+  uint32_t phase_ms[STARTUP_PHASE_COUNT];  // 0 if the phase was never reached
+} StartupProfile;
+
+void startup_profile_begin(void);
+void startup_profile_mark(StartupPhase phase);
+// Logs this launch and adds it to the history under persist_key.  Only the first call per launch does anything.
+void startup_profile_save(uint32_t persist_key);
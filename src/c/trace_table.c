@@ -0,0 +1,35 @@
+#include "trace_table.h"
+#include "alloc_trace.h"
+#include "redraw_trace.h"
+
+// Only the trace builds use it, and app code counts against the same memory as the heap.
+#if ALLOC_TRACE || REDRAW_TRACE
+
+static bool same(char const *a, char const *b) {
+  return a == b || (a != NULL && b != NULL && strcmp(a, b) == 0);
+}
+
+TraceTableEntry *trace_table_entry(TraceTable *table, char const *name, char const *cause) {
+  for (int i = 0; i < table->used; ++i) {
+    if (same(table->entries[i].name, name) && same(table->entries[i].cause, cause)) {
+      return &table->entries[i];
+    }
+  }
+
+  TraceTableEntry *entry = &table->entries[table->used];
+  if (table->used == table->size - 1) {
+    entry->name = "(other)";
+    entry->cause = "(other)";
+    return entry;
+  }
+  ++table->used;
+  *entry = (TraceTableEntry) { .name = name, .cause = cause };
+  return entry;
+}
+
+void trace_table_reset(TraceTable *table) {
+  memset(table->entries, 0, table->size * sizeof(table->entries[0]));
+  table->used = 0;
+}
+
+#endif
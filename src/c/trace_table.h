@@ -0,0 +1,22 @@
+#pragma once
+
+#include <pebble.h>
+
+// Counters for the trace builds, one entry per (name, cause) pair seen since the last reset, in a fixed array the
+// caller owns.  Once the array is full every new pair counts in its last entry, named "(other)".
+#define TRACE_TABLE_COUNTS 3
+
+typedef struct {
+  char const *name;
+  char const *cause;  // NULL where the name says it all
+  uint16_t counts[TRACE_TABLE_COUNTS];
+} TraceTableEntry;
+
+typedef struct {
+  TraceTableEntry *entries;
+  int size;  // the overflow entry included
+  int used;
+} TraceTable;
+
+TraceTableEntry *trace_table_entry(TraceTable *table, char const *name, char const *cause);
+void trace_table_reset(TraceTable *table);
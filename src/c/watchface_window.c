@@ -7,6 +7,20 @@
  *
  * Version 1.6 (in progress)
  *  - add optional TimeZone display
+ *  - rank weather providers by speed and reliability, hedge a slow one, or race the two fastest
+ *  - keep a 12 hour forecast on the watch and only ask the phone for weather when it runs low
+ *  - work out sunrise and sunset on the watch so the night icons flip on time
+ *  - move the date out of the way of Timeline Quick View
+ *  - draw the date, weather, battery, bluetooth and timezone from one layer to save memory on aplite
+ *  - skip weather updates while asleep or while the watch is lying still, and catch up afterwards
+ *  - stop asking for weather when the phone keeps failing the same way, and try again later
+ *  - ride out a flaky bluetooth link without buzzing or asking for weather on every bounce
+ *  - keep one timer for everything that happens at a set time instead of checking the clock every tick
+ *  - leave the timezone and small temperature font out on aplite, and stop allocating once the face is up
+ *  - optionally show the seconds hand only while the watch is moving
+ *  - move the second hand without drawing the rest of the face again
+ *  - draw the dial and hands straight into the frame buffer on black and white watches
+ *  - retry weather and settings the watch did not acknowledge, and only send the newest weather
  *
  * Version 1.5 adds
  *   - code cleanup on font to weather condition mapping to make it easier to read - DONE
@@ -62,10 +76,28 @@
  */
 #include "watchface_window.h"
 #include "pebble_patch.h"
+#include "feature_profile.h"
+#include "solar.h"
+#include "round_trip.h"
+#include "redraw_trace.h"
+#include "startup_profile.h"
+#include "event_log.h"
+#include "activity_gate.h"
+#include "circuit_breaker.h"
+#include "connection_debouncer.h"
+#include "scheduler.h"
+#include "frame_time.h"
+#include "radio_stats.h"
+#include "save_under.h"
+#include "direct_draw.h"
+#include "motion_detector.h"
+#include "alloc_trace.h"
+#include "log.h"
 #include <limits.h>
 
 typedef struct {
   int message_type;
+  uint32_t size;  // bytes in the dictionary
 
   union {
     // Weather message.
@@ -74,6 +106,12 @@ typedef struct {
       int condition_code;
       int temperature;
       bool is_daylight;
+      int forecast_start;
+      uint8_t const *forecast;  // points into the inbox dictionary, only valid while handling the message
+      int forecast_length;
+      int latitude;  // 1/10000 degree.  Both are LOCATION_NOT_SENT unless the phone sent them.
+      int longitude;
+      int error_kind;  // error message only
     };
 
     // Settings message.
@@ -107,6 +145,24 @@ typedef struct {
 #define KEY_CONDITION_CODE 2
 #define KEY_TEMPERATURE 3
 #define KEY_IS_DAYLIGHT 4
+#define KEY_FORECAST 21
+#define KEY_FORECAST_START 22
+#define KEY_LATITUDE 23
+#define KEY_LONGITUDE 24
+
+// Keys used in event log message.
+#define KEY_EVENT_LOG 25
+#define KEY_SECONDS_REDRAWS_SAVED 28
+
+// Keys used in error message, along with KEY_MESSAGE_ID.
+#define KEY_ERROR_KIND 26
+
+// Keys used in our answer to ready and in weather requests.  Whether settings from the phone are stored here, so
+// the phone sends them all again after the watch lost them.
+#define KEY_SETTINGS_STORED 27
+
+// What inbox_received leaves in a field the phone did not send.
+#define LOCATION_NOT_SENT -1
 
 // Keys used in settings message.
 #define MESSAGE_KEY_SHOW_SECONDS_HAND 5
@@ -130,77 +186,38 @@ typedef struct {
 #define MESSAGE_TYPE_READY 0
 #define MESSAGE_TYPE_WEATHER 1
 #define MESSAGE_TYPE_SETTINGS 2
+#define MESSAGE_TYPE_EVENT_LOG 3
+#define MESSAGE_TYPE_ERROR 4
 
 // Temperature units.
 #define TEMPERATURE_UNITS_CELSIUS 0
 #define TEMPERATURE_UNITS_FAHRENHEIT 1
 
 // Weather sources  -- Yahoo stopped working for me as of 8/23/2016.  Appears to be a problem with converting lat/long to WOEID
+//  The source is only a preference passed on to the phone, which may also hedge or race other providers.
 #define WEATHER_SOURCE_OPENWEATHERMAP 1
 #define WEATHER_SOURCE_YAHOO 2
+#define WEATHER_SOURCE_FASTEST 3
 
 // state of how to handle seconds hand  -- 0x08 mask means show seconds hand   0x04 means we need to be registerd for the tap sensor
 #define SHOW_SECONDS_HAND(x)  (x & 0x8)
 #define TAP_SENSOR_NEEDED(x)  (x & 0x4)
+#define MOTION_NEEDED(x)  ((x & 0x7) == 0x7)
 #define SECONDS_HAND_OFF 0x0                        // binary 0000 or 0
 #define SECONDS_HAND_ON 0x8                         // binary 1000 or 8
 #define SECONDS_HAND_FOR_FIXED_DURATION_OFF 0x5     // binary 0101 or 5
 #define SECONDS_HAND_FOR_FIXED_DURATION_ON 0xd      // binary 1101 or 13
 #define SECONDS_HAND_TOGGLE_TAP_OFF 0x6             // binary 0110 or 6
 #define SECONDS_HAND_TOGGLE_TAP_ON 0xe              // binary 1110 or 15
+#define SECONDS_HAND_WHILE_MOVING_OFF 0x7           // binary 0111 or 7, still for the duration since the last motion
+#define SECONDS_HAND_WHILE_MOVING_ON 0xf            // binary 1111 or 15
 
 
-// Condition codes.
-// Reference: https://developer.yahoo.com/weather/documentation.html#codes
+// Condition code used locally to show the refresh icon.  Everything else the phone sends is an OpenWeatherMap
+// condition code; the phone normalizes other providers to it.
 #define CONDITION_CODE_REFRESH -1
-#define CONDITION_CODE_TORNADO 0
-#define CONDITION_CODE_TROPICAL_STORM 1
-#define CONDITION_CODE_HURRICANE 2
-#define CONDITION_CODE_SEVERE_THUNDERSTORMS 3
-#define CONDITION_CODE_THUNDERSTORMS 4
-#define CONDITION_CODE_MIXED_RAIN_AND_SNOW 5
-#define CONDITION_CODE_MIXED_RAIN_AND_SLEET 6
-#define CONDITION_CODE_MIXED_SNOW_AND_SLEET 7
-#define CONDITION_CODE_FREEZING_DRIZZLE 8
-#define CONDITION_CODE_DRIZZLE 9
-#define CONDITION_CODE_FREEZING_RAIN 10
-#define CONDITION_CODE_SHOWERS 11
-#define CONDITION_CODE_SHOWERS_ALIAS 12
-#define CONDITION_CODE_SNOW_FLURRIES 13
-#define CONDITION_CODE_LIGHT_SNOW_SHOWERS 14
-#define CONDITION_CODE_BLOWING_SNOW 15
-#define CONDITION_CODE_SNOW 16
-#define CONDITION_CODE_HAIL 17
-#define CONDITION_CODE_SLEET 18
-#define CONDITION_CODE_DUST 19
-#define CONDITION_CODE_FOGGY 20
-#define CONDITION_CODE_HAZE 21
-#define CONDITION_CODE_SMOKY 22
-#define CONDITION_CODE_BLUSTERY 23
-#define CONDITION_CODE_WINDY 24
-#define CONDITION_CODE_COLD 25
-#define CONDITION_CODE_CLOUDY 26
-#define CONDITION_CODE_MOSTLY_CLOUDY_NIGHT 27
-#define CONDITION_CODE_MOSTLY_CLOUDY_DAY 28
-#define CONDITION_CODE_PARTLY_CLOUDY_NIGHT 29
-#define CONDITION_CODE_PARTLY_CLOUDY_DAY 30
-#define CONDITION_CODE_CLEAR_NIGHT 31
-#define CONDITION_CODE_SUNNY 32
-#define CONDITION_CODE_FAIR_NIGHT 33
-#define CONDITION_CODE_FAIR_DAY 34
-#define CONDITION_CODE_MIXED_RAIN_AND_HAIL 35
-#define CONDITION_CODE_HOT 36
-#define CONDITION_CODE_ISOLATED_THUNDERSTORMS 37
-#define CONDITION_CODE_SCATTERED_THUNDERSTORMS 38
-#define CONDITION_CODE_SCATTERED_THUNDERSTORMS_ALIAS 39
-#define CONDITION_CODE_SCATTERED_SHOWERS 40
-#define CONDITION_CODE_HEAVY_SNOW 41
-#define CONDITION_CODE_SCATTERED_SNOW_SHOWERS 42
-#define CONDITION_CODE_HEAVY_SNOW_ALIAS 43
-#define CONDITION_CODE_PARTLY_CLOUDY 44
-#define CONDITION_CODE_THUNDERSHOWERS 45
-#define CONDITION_CODE_SNOW_SHOWERS 46
-#define CONDITION_CODE_ISOLATED_THUNDERSHOWERS 47
+// Nothing shown yet.
+#define CONDITION_CODE_NONE INT_MIN
 
 // OpenWeatherMap condition codes:  http://openweathermap.org/weather-conditions
 #define OWM_CONDITION_CODE_THUNDERSTORM_MIN 200
@@ -252,15 +269,99 @@ typedef struct {
 int const MIN_WEATHER_UPDATE_INTERVAL_MS = 10 * 1000;
 int const MAX_WEATHER_UPDATE_INTERVAL_MS = 30 * 60 * 1000;
 
+// Hourly forecast pushed by the phone along with the current weather.  See packForecast in app.js for the format.
+#define FORECAST_SLOTS 12
+#define FORECAST_SLOT_BYTES 3
+#define FORECAST_SLOT_SECONDS (60 * 60)
+#define FORECAST_DAYLIGHT_FLAG 0x8000
+#define FORECAST_TEMPERATURE_UNKNOWN -128
+// Ask the phone for a new forecast once fewer than this many slots are left, counting the current one.
+#define FORECAST_LOW_WATER_SLOTS 3
+
+// A disconnect has to last this long before we show it or vibrate, and a reconnect this long before we trust it.
+#define BLUETOOTH_DISCONNECT_DEBOUNCE_MS 10000
+#define BLUETOOTH_CONNECT_DEBOUNCE_MS 3000
+// On reconnect, only ask for weather if what is on screen is older than this and the forecast does not cover us.
+#define WEATHER_STALE_SECONDS (30 * 60)
+// Scheduled weather polls are on the hour and half hour.  Drop this to 5 to test updates.
+#define WEATHER_POLL_MINUTES 30
+// While a poll deferred for inactivity is waiting to be caught up, look for activity this often.
+#define CATCH_UP_CHECK_SECONDS (5 * 60)
+// The event log, draw times and radio traffic are written out this often, as well as on the way out.
+#define STATS_SAVE_SECONDS (60 * 60)
+
+// Jobs on the scheduler.
+typedef enum {
+  JOB_WEATHER_POLL,    // forecast slot, timezone and weather poll every WEATHER_POLL_MINUTES
+  JOB_MIDNIGHT,        // date rollover
+  JOB_DAYLIGHT,        // next sunrise or sunset today
+  JOB_SECONDS_EXPIRY,  // hide the seconds hand again after a tap
+  JOB_WEATHER_RETRY,   // no reply to the last weather request yet
+  JOB_CATCH_UP,        // look for activity after a deferred poll
+  JOB_SAVE_STATS,
+} Job;
+
+// Persistent storage keys for things that are not settings.  Settings are stored under their message key.
+#define PERSIST_KEY_FORECAST 100
+#define PERSIST_KEY_LOCATION 101
+#define PERSIST_KEY_STARTUP_PROFILES 102
+#define PERSIST_KEY_EVENT_LOG 103
+#define PERSIST_KEY_FRAME_TIMES 104
+#define PERSIST_KEY_RADIO_STATS 105
+#define PERSIST_KEY_SETTINGS_STORED 106
+#define PERSIST_KEY_SECONDS_REDRAWS_SAVED 107
+
+typedef struct {
+  int16_t condition_code;
+  int8_t temperature;
+  bool is_daylight;
+} ForecastSlot;
+
+typedef struct {
+  time_t start;
+  int count;
+  char zone[sizeof("NAEDT")];  // timezone when it was received.  If it changes, we have probably moved.
+  ForecastSlot slots[FORECAST_SLOTS];
+} Forecast;
+
+// Everything drawn in a fixed spot on the dial, all by the complications layer.  The full screen layers
+// (background, hands) are not in here.
+typedef enum {
+  LAYOUT_DATE,
+  LAYOUT_TEMPERATURE,
+  LAYOUT_CONDITION,
+  LAYOUT_BATTERY,
+  LAYOUT_BATTERY_TEXT,
+  LAYOUT_BLUETOOTH,
+  LAYOUT_TIMEZONE,
+  LAYOUT_ITEM_COUNT
+} LayoutItem;
+
+typedef struct {
+  GRect frames[LAYOUT_ITEM_COUNT];
+} Layout;
+
+// Layouts are worked out once per obstruction state, then just interpolated while a peek animates.
+typedef enum {
+  LAYOUT_STATE_UNOBSTRUCTED,
+  LAYOUT_STATE_OBSTRUCTED,
+  LAYOUT_STATE_COUNT
+} LayoutState;
+
 typedef struct {
   int seconds_hand_mode;
   int seconds_hand_duration;
-  AppTimer *seconds_duration_timer; 
   time_t most_recent_tap;
+  MotionDetector motion;            // running only for SECONDS_HAND_WHILE_MOVING
+  time_t last_motion;
+  time_t seconds_hand_still_since;  // when the seconds hand went away for lack of motion, 0 while it shows
+  uint32_t seconds_redraws_saved;   // second hand redraws skipped while still, over every launch
+  uint32_t seconds_redraws_saved_at_save;
   
   int temperature_units;
   bool vibrate_on_bluetooth_disconnect;
-  bool bluetooth_connected;
+  bool bluetooth_connected;  // debounced
+  ConnectionDebouncer bluetooth_debouncer;
   int show_battery_at_percent;
   int hand_style;
   int temperature_font_size;
@@ -272,7 +373,9 @@ typedef struct {
   GFont font_hours;
   GFont font_date;
   GFont font_temperature;
+#if FEATURE_SMALL_TEMPERATURE_FONT
   GFont font_temperature_small;
+#endif
   // GFont font_temperature_medium;   The medium temperature font just reuses the font_date so no need to reload it.
   GFont font_condition;
   GFont font_battery;
@@ -294,47 +397,159 @@ typedef struct {
   int weather_quiet_time_stop;
   
   Layer *background_layer;
+  // The dial as last drawn, copied back in while the colors stay the same.  Only taken when drawing directly.
+  DirectDrawSnapshot dial;
 
-  TextLayer *date_text_layer;
-  char date_text[sizeof("Jan 31")];
+  // One layer draws every readout below at its frame in layout.
+  Layer *complications_layer;
+  uint32_t dirty_complications;  // bit per LayoutItem changed since the complications layer last drew
 
-  TextLayer *temperature_text_layer;
+  char date_text[sizeof("Jan 31")];
   char temperature_text[sizeof("-999°")];
-
-  TextLayer *condition_text_layer;
   char condition_text[sizeof("C")];
-
-  Layer *battery_layer;
-  TextLayer *battery_text_layer;
   char battery_text[sizeof("C")];
-
-  TextLayer *bluetooth_text_layer;
   char bluetooth_text[sizeof("b")];
-  
-  TextLayer *timezone_text_layer;
+#if FEATURE_TIMEZONE
   char timezone_text[sizeof("NAEDT")];  //  Longest one I could find was 5 chars. 
+#endif
 
-  GPath *hour_hand_path;
-  GPath *minute_hand_path;
+  GPath hour_hand_path;
+  GPath minute_hand_path;
 
   Layer *hands_layer;
   Layer *second_hand_layer;
 
-  AppTimer *weather_update_timer;
+  // Ticks that only move the second hand put back the pixels it covered and draw it again, rather than drawing
+  // the whole scene.  Anything else that changes means a full frame.
+  SaveUnder second_hand_save_under;
+  bool full_frame;
+
   int weather_update_backoff_interval;
   int expected_weather_message_id;
+
+  Forecast forecast;
+
+  // Condition being shown, so the icon can flip between day and night on its own.
+  int condition_code;
+  bool is_daylight;
+
+  // Where the phone last said we were, and today's sunrise and sunset there.
+  bool has_location;
+  SolarLocation location;
+  SolarDay solar_day;
+  bool solar_day_is_dst;
+
+  RoundTripStats round_trip;
+  ActivityGate activity_gate;
+  CircuitBreaker circuit_breaker;
+  time_t weather_received_at;
+  Scheduler scheduler;
+
+  Layout layouts[LAYOUT_STATE_COUNT];
+  GRect obstructed_area;  // the area layouts[LAYOUT_STATE_OBSTRUCTED] was computed for
+  Layout layout;          // frames the layers have right now
+  Layout layout_from;     // where the current peek animation started
+  LayoutState layout_to;
+  uint32_t moving_items;  // bit per LayoutItem whose frame differs between layout_from and layout_to
 } WatchfaceWindow;
 
 static Window *g_watchface_window = NULL;
 
 static void force_immediate_time_update(Window* watchface_window, bool bUpdateTime, bool bUpdateTickTimerService, bool bUpdateDurationTimer);
+static void schedule_daylight(Window *watchface_window);
+static void save_seconds_redraws_saved(WatchfaceWindow *this);
+
+// Call along with marking any layer but the second hand dirty.
+static void need_full_frame(WatchfaceWindow *this) {
+  this->full_frame = true;
+}
+
+// Whether this frame only moves the second hand, so the rest of the scene is still in the frame buffer.
+static bool seconds_only_frame(WatchfaceWindow *this) {
+  return !this->full_frame && this->second_hand_save_under.valid;
+}
 
+// cause is REDRAW_CAUSE at the call site, so the redraw tracer can say who asked.
+static void mark_complication_dirty(WatchfaceWindow *this, LayoutItem item, char const *cause) {
+  REDRAW_MUTATION("complications", cause);
+  need_full_frame(this);
+  // One mark per frame is enough; the layer redraws every readout anyway.
+  if (this->dirty_complications == 0 && this->complications_layer != NULL) {
+    REDRAW_MARK_DIRTY(this->complications_layer, cause);
+  }
+  this->dirty_complications |= 1 << item;
+}
+
+static void mark_all_complications_dirty(WatchfaceWindow *this, char const *cause) {
+  for (int i = 0; i < LAYOUT_ITEM_COUNT; ++i) {
+    mark_complication_dirty(this, i, cause);
+  }
+}
+
+// Only redraws when the text actually changed, so callers can set it as often as they like.
+static void set_complication_text(WatchfaceWindow *this, LayoutItem item, char *buffer, size_t size, char const *text,
+                                  char const *cause) {
+  if (strncmp(buffer, text, size - 1) != 0) {
+    strncpy(buffer, text, size - 1);
+    buffer[size - 1] = '\0';
+    mark_complication_dirty(this, item, cause);
+  }
+}
+
+
+
+// Hour ticks stop this far in from the edge of the screen.
+#define TICK_INSET 10
+#define TICK_RAY_LENGTH 111
+
+static GPoint ray_point(GPoint center, int32_t angle, int32_t length) {
+  return (GPoint) {
+    .x = (int16_t)(sin_lookup(angle) * length / TRIG_MAX_RATIO) + center.x,
+    .y = (int16_t)(-cos_lookup(angle) * length / TRIG_MAX_RATIO) + center.y,
+  };
+}
 
+// How far a ray from the center at angle goes before leaving a rect centered on it.
+static int32_t ray_to_rect_edge(int32_t angle, int32_t half_width, int32_t half_height) {
+  int32_t sin = sin_lookup(angle);
+  int32_t cos = cos_lookup(angle);
+  int32_t length = INT32_MAX;
+
+  if (sin != 0) {
+    length = half_width * TRIG_MAX_RATIO / (sin < 0 ? -sin : sin);
+  }
+  if (cos != 0) {
+    int32_t to_top_or_bottom = half_height * TRIG_MAX_RATIO / (cos < 0 ? -cos : cos);
+    if (to_top_or_bottom < length) {
+      length = to_top_or_bottom;
+    }
+  }
+  return length;
+}
 
 static void update_background(Layer *layer, GContext *ctx) {
   WatchfaceWindow *this = window_get_user_data(layer_get_window(layer));
+  REDRAW_DRAW_BEGIN();
+  ALLOC_TRACE_STEADY_BEGIN();
+  if (seconds_only_frame(this)) {
+    ALLOC_TRACE_END();
+    REDRAW_DRAW_END();
+    return;
+  }
+  FRAME_TIME_BEGIN(FRAME_PROC_BACKGROUND);
   GRect bounds = layer_get_bounds(layer);
   GPoint center = grect_center_point(&bounds);
+  DirectDraw draw;
+
+  direct_draw_begin(&draw, ctx);
+  if (direct_draw_snapshot_blit(&this->dial, &draw)) {
+    direct_draw_end(&draw);
+    FRAME_TIME_END(FRAME_PROC_BACKGROUND);
+    ALLOC_TRACE_END();
+    REDRAW_DRAW_END();
+    return;
+  }
+  direct_draw_end(&draw);
 
 #ifdef PBL_COLOR
   graphics_context_set_antialiased(ctx, true);
@@ -342,30 +557,31 @@ static void update_background(Layer *layer, GContext *ctx) {
 #endif
 
   graphics_context_set_fill_color(ctx, this->color_background);
-  graphics_context_set_stroke_color(ctx, this->color_foreground_1);
   graphics_fill_rect(ctx, layer_get_bounds(layer), 0, GCornerNone);
 
-  int16_t ray_length = 111;
   int ray_angles[8] = { 5, 10, 20, 25, 35, 40, 50, 55 };
 
+  // The ticks are what is left of rays from the center once the inset circle or rect is taken out, so only
+  // draw that part rather than the whole ray and painting over it.
+  direct_draw_begin(&draw, ctx);
   for (int i = 0; i < 8; ++i) {
-    GPoint ray_endpoint = {
-      .x = (int16_t)(sin_lookup(TRIG_MAX_ANGLE * ray_angles[i] / 60) * (int32_t)ray_length / TRIG_MAX_RATIO) + center.x,
-      .y = (int16_t)(-cos_lookup(TRIG_MAX_ANGLE * ray_angles[i] / 60) * (int32_t)ray_length / TRIG_MAX_RATIO) + center.y,
-    };
-
-    graphics_draw_line(ctx, ray_endpoint, center);
-  }
-
-  graphics_context_set_fill_color(ctx, this->color_background);
-  graphics_context_set_stroke_color(ctx, this->color_background);
+    int32_t angle = TRIG_MAX_ANGLE * ray_angles[i] / 60;
 #if defined(PBL_ROUND)
-  // Draw background color circle to cover hour rays
-  graphics_fill_circle(ctx, center, bounds.size.h/2 - 10);
+    int32_t tick_start = bounds.size.h / 2 - TICK_INSET;
 #else
-  // Draw background color rectangle to cover hour rays
-  graphics_fill_rect(ctx, GRect(10, 10, bounds.size.w - 20, bounds.size.h - 20), 0, GCornerNone);
+    int32_t tick_start = ray_to_rect_edge(angle, bounds.size.w / 2 - TICK_INSET, bounds.size.h / 2 - TICK_INSET);
 #endif
+    int32_t tick_end = ray_to_rect_edge(angle, bounds.size.w / 2, bounds.size.h / 2);
+    if (tick_end > TICK_RAY_LENGTH) {
+      tick_end = TICK_RAY_LENGTH;
+    }
+
+    if (tick_start < tick_end) {
+      direct_draw_line(&draw, ray_point(center, angle, tick_start), ray_point(center, angle, tick_end),
+                       this->color_foreground_1);
+    }
+  }
+  direct_draw_end(&draw);
   
   // Draw hours
   graphics_context_set_text_color(ctx, this->color_foreground_1);
@@ -373,6 +589,13 @@ static void update_background(Layer *layer, GContext *ctx) {
   graphics_draw_text(ctx, "3", this->font_hours, GRect(bounds.size.w - 31, (bounds.size.h / 2) - 15, 30, 24), GTextOverflowModeWordWrap, GTextAlignmentRight, NULL);
   graphics_draw_text(ctx, "6", this->font_hours, GRect((bounds.size.w / 2) - 15, bounds.size.h - 26, 30, 24), GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
   graphics_draw_text(ctx, "9", this->font_hours, GRect(1, (bounds.size.h / 2) - 15, 30, 24), GTextOverflowModeWordWrap, GTextAlignmentLeft, NULL);
+
+  direct_draw_begin(&draw, ctx);
+  direct_draw_snapshot_take(&this->dial, &draw);
+  direct_draw_end(&draw);
+  FRAME_TIME_END(FRAME_PROC_BACKGROUND);
+  ALLOC_TRACE_END();
+  REDRAW_DRAW_END();
 }
 
 static void update_date(Window *watchface_window) {
@@ -381,139 +604,43 @@ static void update_date(Window *watchface_window) {
   time_t now = time(NULL);
   struct tm *t = localtime(&now);
  
-  strftime(this->date_text, sizeof(this->date_text), "%a %d", t);
-  text_layer_set_text(this->date_text_layer, this->date_text);
-  text_layer_set_text_color(this->date_text_layer, this->color_foreground_1);
+  char date_text[sizeof(this->date_text)];
+  strftime(date_text, sizeof(date_text), "%a %d", t);
+  set_complication_text(this, LAYOUT_DATE, this->date_text, sizeof(this->date_text), date_text, REDRAW_CAUSE);
 }
 
 static void update_timezone(Window *watchface_window, char* tz) {
+#if FEATURE_TIMEZONE
   WatchfaceWindow *this = window_get_user_data(watchface_window);
+
+  LOG_DEBUG("update timezone to %s", tz);
   
-  APP_LOG(APP_LOG_LEVEL_DEBUG, "update timezone to %s", tz);
-  
-  strncpy(this->timezone_text, tz,  sizeof(this->timezone_text));
-  text_layer_set_text(this->timezone_text_layer, this->timezone_text);
-  text_layer_set_text_color(this->timezone_text_layer, this->color_foreground_1);
+  set_complication_text(this, LAYOUT_TIMEZONE, this->timezone_text, sizeof(this->timezone_text), tz, REDRAW_CAUSE);
+#endif
 }
 
 static void update_temperature(Window *watchface_window, int temperature) {
   WatchfaceWindow *this = window_get_user_data(watchface_window);
 
   char const *format;
-  GRect temperature_text_layer_frame = layer_get_frame(text_layer_get_layer(this->temperature_text_layer));
   if (temperature < 0) {
     format = temperature >= -999 ? "%d°" : "";
   } else {
     format = temperature <= 999 ? "%d°" : "";
   }
 
-  snprintf(this->temperature_text, sizeof(this->temperature_text), format, temperature);
-  text_layer_set_text(this->temperature_text_layer, this->temperature_text);
-  APP_LOG(APP_LOG_LEVEL_DEBUG, "Updating Temp to : %s", this->temperature_text);
-  layer_set_frame(text_layer_get_layer(this->temperature_text_layer), temperature_text_layer_frame);
-  text_layer_set_text_color(this->temperature_text_layer, this->color_foreground_1);
+  char temperature_text[sizeof(this->temperature_text)];
+  snprintf(temperature_text, sizeof(temperature_text), format, temperature);
+  LOG_DEBUG("Updating Temp to : %s", temperature_text);
+  set_complication_text(this, LAYOUT_TEMPERATURE, this->temperature_text, sizeof(this->temperature_text),
+                        temperature_text, REDRAW_CAUSE);
 }
 
-static void condition_code_to_icon_yahoo(Window *watchface_window, int condition_code, bool is_daylight) {
-  WatchfaceWindow *this = window_get_user_data(watchface_window);
-
-  char* icon = NULL;
-  
-  // Set symbol using icon font
-  switch (condition_code) {
-    case CONDITION_CODE_REFRESH:
-      icon = ICON_REFRESH;
-      break;
-    case CONDITION_CODE_TORNADO:
-      icon = ICON_TORNADO;
-      break;
-    case CONDITION_CODE_TROPICAL_STORM:
-    case CONDITION_CODE_HURRICANE:
-      icon = ICON_HURRICANE;
-      break;
-    case CONDITION_CODE_THUNDERSTORMS:
-    case CONDITION_CODE_SEVERE_THUNDERSTORMS:
-    case CONDITION_CODE_ISOLATED_THUNDERSTORMS:
-    case CONDITION_CODE_SCATTERED_THUNDERSTORMS:
-    case CONDITION_CODE_SCATTERED_THUNDERSTORMS_ALIAS:
-    case CONDITION_CODE_THUNDERSHOWERS:
-    case CONDITION_CODE_ISOLATED_THUNDERSHOWERS:
-      icon = ICON_THUNDERSTORM;
-      break;
-    case CONDITION_CODE_FREEZING_RAIN:
-    case CONDITION_CODE_FREEZING_DRIZZLE:
-    case CONDITION_CODE_MIXED_RAIN_AND_SNOW:
-    case CONDITION_CODE_MIXED_RAIN_AND_SLEET:
-    case CONDITION_CODE_HAIL:
-    case CONDITION_CODE_SLEET:
-      icon = ICON_FREEZING_RAIN;
-      break;
-    case CONDITION_CODE_SHOWERS:
-    case CONDITION_CODE_SHOWERS_ALIAS:
-    case CONDITION_CODE_SCATTERED_SHOWERS:
-    case CONDITION_CODE_DRIZZLE:
-    case CONDITION_CODE_MIXED_RAIN_AND_HAIL:
-      icon = ICON_RAIN;
-      break;
-    case CONDITION_CODE_SNOW:
-    case CONDITION_CODE_SNOW_FLURRIES:
-    case CONDITION_CODE_MIXED_SNOW_AND_SLEET:
-    case CONDITION_CODE_LIGHT_SNOW_SHOWERS:
-    case CONDITION_CODE_BLOWING_SNOW:
-    case CONDITION_CODE_HEAVY_SNOW:
-    case CONDITION_CODE_SCATTERED_SNOW_SHOWERS:
-    case CONDITION_CODE_HEAVY_SNOW_ALIAS:
-    case CONDITION_CODE_SNOW_SHOWERS:
-      icon = ICON_SNOW;
-      break;
-    case CONDITION_CODE_DUST:
-    case CONDITION_CODE_FOGGY:
-    case CONDITION_CODE_HAZE:
-    case CONDITION_CODE_SMOKY:
-      icon = ICON_FOG;
-      break;
-    case CONDITION_CODE_BLUSTERY:
-    case CONDITION_CODE_WINDY:
-      icon = ICON_WINDY;
-      break;
-    case CONDITION_CODE_COLD:
-      icon = ICON_COLD;
-      break;
-    case CONDITION_CODE_CLOUDY:
-    case CONDITION_CODE_MOSTLY_CLOUDY_DAY:
-    case CONDITION_CODE_MOSTLY_CLOUDY_NIGHT:
-      icon = ICON_CLOUDY;
-      break;
-    case CONDITION_CODE_PARTLY_CLOUDY:
-    case CONDITION_CODE_PARTLY_CLOUDY_DAY:
-    case CONDITION_CODE_PARTLY_CLOUDY_NIGHT:
-      icon = (is_daylight ? ICON_PARTLY_CLOUDY_DAY : ICON_PARTLY_CLOUDY_NIGHT);
-      break;
-    case CONDITION_CODE_SUNNY:
-    case CONDITION_CODE_FAIR_DAY:
-    case CONDITION_CODE_CLEAR_NIGHT:
-    case CONDITION_CODE_FAIR_NIGHT:
-      icon = (is_daylight ? ICON_CLEAR_DAY : ICON_CLEAR_NIGHT );
-      break;
-    case CONDITION_CODE_HOT:
-      icon = ICON_HOT;
-      break;
-    default:
-      icon = ICON_UNKNOWN;
-      break;
-  }
-  strncpy(this->condition_text, icon, sizeof(this->condition_text));
-
-}
- 
-
 // OpenWeatherMap condition codes:  http://openweathermap.org/weather-conditions
 
-static void condition_code_to_icon_openweathermap(Window *watchface_window, int condition_code, bool is_daylight) {
-  WatchfaceWindow *this = window_get_user_data(watchface_window);
-  
+static char *condition_code_to_icon(int condition_code, bool is_daylight) {
   char* icon = NULL;
-  APP_LOG(APP_LOG_LEVEL_DEBUG, "condition code = %d %d", condition_code, is_daylight);
+  LOG_DEBUG("condition code = %d %d", condition_code, is_daylight);
   
   if (condition_code >= OWM_CONDITION_CODE_THUNDERSTORM_MIN && condition_code <= OWM_CONDITION_CODE_THUNDERSTORM_MAX) // thunderstorms
     icon = ICON_THUNDERSTORM;
@@ -565,20 +692,7 @@ static void condition_code_to_icon_openweathermap(Window *watchface_window, int
           break;
       }
   }
-  strncpy(this->condition_text, icon, sizeof(this->condition_text));
-
-}
-
-
-
-static void condition_code_to_icon(Window *watchface_window, int condition_code, bool is_daylight) {
-  WatchfaceWindow *this = window_get_user_data(watchface_window);
-
-  if (this->weather_source == WEATHER_SOURCE_YAHOO)
-    condition_code_to_icon_yahoo(watchface_window, condition_code, is_daylight);
-  else
-    condition_code_to_icon_openweathermap(watchface_window, condition_code, is_daylight);
- 
+  return icon;
 }
 
 
@@ -589,74 +703,147 @@ static void mark_as_syncing(Window* watchface_window, bool syncing) {
 #else
   WatchfaceWindow *this = window_get_user_data(watchface_window);
 
-  strncpy(this->bluetooth_text, syncing ? ICON_REFRESH : ICON_NONE , sizeof(this->bluetooth_text));
+  set_complication_text(this, LAYOUT_BLUETOOTH, this->bluetooth_text, sizeof(this->bluetooth_text),
+                        syncing ? ICON_REFRESH : ICON_NONE, REDRAW_CAUSE);
 #endif
 }
 
-static void update_condition(Window *watchface_window, int condition_code, bool is_daylight) {
+static void update_solar_day(WatchfaceWindow *this, struct tm *local_time) {
+  if (this->has_location) {
+    this->solar_day = solar_day_compute(&this->location, local_time->tm_yday, utc_offset_minutes(time(NULL)));
+    this->solar_day_is_dst = local_time->tm_isdst;
+  }
+}
+
+static void show_condition(Window *watchface_window, int condition_code, bool is_daylight) {
   WatchfaceWindow *this = window_get_user_data(watchface_window);
-  
+
+  // Once we know where we are, day and night are worked out here rather than taken from the phone, which may
+  // have told us hours ago.
+  if (this->has_location) {
+    struct tm *t = local_time_peek();
+    is_daylight = solar_is_daylight(&this->solar_day, t->tm_hour * 60 + t->tm_min);
+  }
+  this->condition_code = condition_code;
+  this->is_daylight = is_daylight;
+
+  set_complication_text(this, LAYOUT_CONDITION, this->condition_text, sizeof(this->condition_text),
+                        condition_code_to_icon(condition_code, is_daylight), REDRAW_CAUSE);
+}
+
+static void update_condition(Window *watchface_window, int condition_code, bool is_daylight) {
   mark_as_syncing(watchface_window, false);
-  condition_code_to_icon(watchface_window, condition_code, is_daylight);
-  text_layer_set_text(this->condition_text_layer, this->condition_text);
-  text_layer_set_text_color(this->condition_text_layer, this->color_foreground_1);
+  show_condition(watchface_window, condition_code, is_daylight);
 }
 
+// Flips the condition icon between day and night at sunrise and sunset, without asking the phone.
+static void update_daylight(Window *watchface_window, struct tm *local_time) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
 
-  
-static void log_reason(char* info, AppMessageResult reason) {
-  char reason_string[1000];
-  reason_string[0] = 0;
-  if (reason == APP_MSG_OK) {
-    strcat(reason_string, "OK");
-  } else {
-    if (reason & APP_MSG_OK) {
-      strcat(reason_string, "OK.");
-    }
-    if (reason & APP_MSG_SEND_TIMEOUT) {
-      strcat(reason_string, "Send Timeout.");
-    }
-    if (reason & APP_MSG_SEND_REJECTED) {
-      strcat(reason_string, "Rejected.");
-    }
-    if (reason & APP_MSG_NOT_CONNECTED) {
-      strcat(reason_string, "Not Connected.");
-    }
-    if (reason & APP_MSG_APP_NOT_RUNNING) {
-      strcat(reason_string, "App Not Running.");
-    }
-    if (reason & APP_MSG_INVALID_ARGS) {
-      strcat(reason_string, "Invalid Args.");
-    }
-    if (reason & APP_MSG_BUSY) {
-      strcat(reason_string, "Busy.");
-    }
-    if (reason & APP_MSG_BUFFER_OVERFLOW) {
-      strcat(reason_string, "Buffer Overflow.");
-    }
-    if (reason & APP_MSG_ALREADY_RELEASED) {
-      strcat(reason_string, "Already Released.");
-    } 
-    if (reason & APP_MSG_OUT_OF_MEMORY) {
-      strcat(reason_string, "Out of Memory.");
-    }
-    if (reason & APP_MSG_INTERNAL_ERROR) {
-      strcat(reason_string, "Internal Error.");
-    } 
+  if (!this->has_location || this->condition_code == CONDITION_CODE_NONE) {
+    return;
+  }
+
+  if (local_time->tm_isdst != this->solar_day_is_dst) {
+    update_solar_day(this, local_time);
+  }
+
+  if (solar_is_daylight(&this->solar_day, local_time->tm_hour * 60 + local_time->tm_min) != this->is_daylight) {
+    show_condition(watchface_window, this->condition_code, this->is_daylight);
   }
-  APP_LOG(APP_LOG_LEVEL_DEBUG, "%s %x %s", info, reason, reason_string); 
 }
 
-static void cancel_weather_update_timer(WatchfaceWindow* this) {
+static void location_received(Window *watchface_window, Message const *message) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
+
+  this->location = (SolarLocation) { .latitude = message->latitude, .longitude = message->longitude };
+  this->has_location = true;
+  persist_write_data(PERSIST_KEY_LOCATION, &this->location, sizeof(this->location));
+
+  update_solar_day(this, local_time_peek());
+  schedule_daylight(watchface_window);
+}
+
+static void forecast_received(Window *watchface_window, Message const *message) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
+  Forecast *forecast = &this->forecast;
+  int count = message->forecast_length / FORECAST_SLOT_BYTES;
+
+  if (count > FORECAST_SLOTS) {
+    count = FORECAST_SLOTS;
+  }
+
+  for (int i = 0; i < count; ++i) {
+    uint8_t const *slot = message->forecast + i * FORECAST_SLOT_BYTES;
+    uint16_t code = slot[0] | (slot[1] << 8);
+
+    forecast->slots[i] = (ForecastSlot) {
+      .condition_code = code & ~FORECAST_DAYLIGHT_FLAG,
+      .temperature = (int8_t)slot[2],
+      .is_daylight = (code & FORECAST_DAYLIGHT_FLAG) != 0,
+    };
+  }
+  forecast->start = message->forecast_start;
+  forecast->count = count;
+  strncpy(forecast->zone, local_time_peek()->tm_zone, sizeof(forecast->zone));
+
+  // Keep it across restarts so coming back from an app does not cost a trip to the phone.
+  persist_write_data(PERSIST_KEY_FORECAST, forecast, sizeof(*forecast));
+}
+
+// Shows the forecast slot for the current time if we have one.  Returns false if the phone should be asked for
+// a new forecast, either because we are running out of slots or because we have changed timezones.
+static bool update_weather_from_forecast(Window *watchface_window, struct tm *local_time) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
+  Forecast const *forecast = &this->forecast;
+  time_t now = time(NULL);
+
+  if (forecast->count == 0 || now < forecast->start) {
+    return false;
+  }
+
+  int slot = (now - forecast->start) / FORECAST_SLOT_SECONDS;
+  if (slot >= forecast->count) {
+    return false;
+  }
+
+  ForecastSlot const *current = &forecast->slots[slot];
+  show_condition(watchface_window, current->condition_code, current->is_daylight);
+  update_temperature(watchface_window, current->temperature == FORECAST_TEMPERATURE_UNKNOWN ? INT_MIN : current->temperature);
+
+  return (forecast->count - slot >= FORECAST_LOW_WATER_SLOTS) && (strcmp(local_time->tm_zone, forecast->zone) == 0);
+}
+
+
   
-   // In case there is already a timer, turn it off
-  if (this->weather_update_timer) {
-    //APP_LOG(APP_LOG_LEVEL_DEBUG, "getting ready to close weather_timer");
-    app_timer_cancel(this->weather_update_timer);
-    this->weather_update_timer = NULL;
-    //APP_LOG(APP_LOG_LEVEL_DEBUG, "done with resetting timer");
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+static char const *app_message_result_name(AppMessageResult reason) {
+  switch (reason) {
+    case APP_MSG_OK: return "OK";
+    case APP_MSG_SEND_TIMEOUT: return "Send Timeout";
+    case APP_MSG_SEND_REJECTED: return "Rejected";
+    case APP_MSG_NOT_CONNECTED: return "Not Connected";
+    case APP_MSG_APP_NOT_RUNNING: return "App Not Running";
+    case APP_MSG_INVALID_ARGS: return "Invalid Args";
+    case APP_MSG_BUSY: return "Busy";
+    case APP_MSG_BUFFER_OVERFLOW: return "Buffer Overflow";
+    case APP_MSG_ALREADY_RELEASED: return "Already Released";
+    case APP_MSG_OUT_OF_MEMORY: return "Out of Memory";
+    case APP_MSG_INTERNAL_ERROR: return "Internal Error";
+    default: return "";
   }
 }
+#endif
+
+// Failures always go in the event log; the text is only there in debug builds.
+static void log_reason(char* info, AppMessageResult reason) {
+  event_log_add(EVENT_SEND_FAILED, reason);
+  LOG_DEBUG("%s %x %s", info, reason, app_message_result_name(reason));
+}
+
+static void cancel_weather_retry(WatchfaceWindow* this) {
+  scheduler_cancel(&this->scheduler, JOB_WEATHER_RETRY);
+}
 
 
 // Drastic measures...  If we get stuck to where we can no longer get messages, then restart the watchface
@@ -664,12 +851,14 @@ static void restart_watchface(void* watchface_window) {
   WatchfaceWindow *this = window_get_user_data(watchface_window);
   time_t now = time(NULL);
 
-  strncpy(this->bluetooth_text, ICON_RESTART, sizeof(this->bluetooth_text));
+  set_complication_text(this, LAYOUT_BLUETOOTH, this->bluetooth_text, sizeof(this->bluetooth_text), ICON_RESTART, REDRAW_CAUSE);
   
   // normally it will restart on it's own, but occasionally, that doesn't seem to happen.  Set timer
   // to wake up after X seconds in that case.
   wakeup_schedule(now + 5, 0, false); 
-  APP_LOG(APP_LOG_LEVEL_ERROR, "restarting watchface to recover from Pebble communications bug");
+  event_log_add(EVENT_RESTART, APP_MSG_BUSY);
+  radio_stats_outcome(RADIO_RESTART);
+  LOG_ERROR("restarting watchface to recover from Pebble communications bug");
   window_stack_pop_all(false);
 }
 
@@ -681,9 +870,9 @@ static void send_weather_request(void *watchface_window) {
   if (!this->bluetooth_connected)
     return; // short circuit and stop looking for weather if bluetooth is currently disconnected
 
-  // Set up a timer in case we do not get an update
-  //APP_LOG(APP_LOG_LEVEL_DEBUG, "About to set weather update timer");
-  this->weather_update_timer = app_timer_register(this->weather_update_backoff_interval, send_weather_request, watchface_window);
+  // Try again in case we do not get an update
+  scheduler_at(&this->scheduler, JOB_WEATHER_RETRY, time(NULL) + this->weather_update_backoff_interval / 1000,
+               send_weather_request);
   this->weather_update_backoff_interval *= 2;
   if (this->weather_update_backoff_interval > MAX_WEATHER_UPDATE_INTERVAL_MS) {
     this->weather_update_backoff_interval = MAX_WEATHER_UPDATE_INTERVAL_MS;
@@ -692,6 +881,8 @@ static void send_weather_request(void *watchface_window) {
   DictionaryIterator *iterator;
   if ((result = app_message_outbox_begin(&iterator)) != APP_MSG_OK) {
     log_reason("unable to begin outbox", result); 
+    round_trip_begin_failed(&this->round_trip, result);
+    radio_stats_outcome(RADIO_BEGIN_FAILED);
     //  There is a bug documented in  https://forums.pebble.com/t/how-to-recover-from-app-msg-busy-after-bluetooth-reconnects/22948 
     //    where we get a BUSY that we never recover from after bluetooth reconnect.   So, let's reboot the app to recover.
     if (result == APP_MSG_BUSY) restart_watchface(watchface_window);
@@ -699,19 +890,26 @@ static void send_weather_request(void *watchface_window) {
     dict_write_int32(iterator, KEY_MESSAGE_TYPE, MESSAGE_TYPE_WEATHER);
     dict_write_int32(iterator, KEY_MESSAGE_ID, ++this->expected_weather_message_id);
     dict_write_int32(iterator, MESSAGE_KEY_WEATHER_SOURCE, this->weather_source);
-    APP_LOG(APP_LOG_LEVEL_DEBUG, "In C function send_weather_request temperature units : %i and source = %d", this->temperature_units, this->weather_source);
+    LOG_DEBUG("In C function send_weather_request temperature units : %i and source = %d", this->temperature_units, this->weather_source);
     dict_write_int32(iterator, MESSAGE_KEY_TEMPERATURE_UNITS, this->temperature_units);
-    if ((result = app_message_outbox_send()) != APP_MSG_OK) 
+    dict_write_uint8(iterator, KEY_SETTINGS_STORED, persist_exists(PERSIST_KEY_SETTINGS_STORED));
+    // Until it is ended, dict_size is the whole outbox rather than what was written.
+    uint32_t size = dict_write_end(iterator);
+    round_trip_request_sent(&this->round_trip, this->expected_weather_message_id, size);
+    radio_stats_sent(MESSAGE_TYPE_WEATHER, size);
+    if ((result = app_message_outbox_send()) != APP_MSG_OK) {
       log_reason("unable to send outbox", result);
+      round_trip_send_failed(&this->round_trip, this->expected_weather_message_id, result);
+      radio_stats_send_failed(result);
+    } else {
+      event_log_add(EVENT_WEATHER_REQUESTED, this->expected_weather_message_id);
+    }
   }    
   mark_as_syncing(watchface_window, true);
 
 }
 
-static void update_battery_state(Layer *layer, GContext *ctx) {
-  WatchfaceWindow *this = window_get_user_data(layer_get_window(layer));
-
-  BatteryChargeState battery_state = battery_state_service_peek();
+static void update_battery(WatchfaceWindow *this, BatteryChargeState battery_state) {
   char* icon = NULL;
   
   if (battery_state.is_charging) { // Set symbol using icon font
@@ -721,9 +919,12 @@ static void update_battery_state(Layer *layer, GContext *ctx) {
   } else {
     icon = ICON_NONE;
   }
-  strncpy(this->battery_text, icon, sizeof(this->battery_text));
+  set_complication_text(this, LAYOUT_BATTERY_TEXT, this->battery_text, sizeof(this->battery_text), icon, REDRAW_CAUSE);
+  mark_complication_dirty(this, LAYOUT_BATTERY, REDRAW_CAUSE);
+}
 
-  text_layer_set_text(this->battery_text_layer, this->battery_text);
+static void draw_battery_gauge(WatchfaceWindow *this, GContext *ctx, GRect frame) {
+  BatteryChargeState battery_state = battery_state_service_peek();
 
   if (battery_state.charge_percent > this->show_battery_at_percent && !battery_state.is_charging && !battery_state.is_plugged) {
     return; // Battery does not need shown
@@ -731,146 +932,191 @@ static void update_battery_state(Layer *layer, GContext *ctx) {
 
   graphics_context_set_stroke_color(ctx, this->color_foreground_1);
   graphics_context_set_fill_color(ctx, this->color_foreground_1);
-  graphics_draw_rect(ctx, GRect(0, 0, 14, 8));
-  graphics_fill_rect(ctx, GRect(2, 2, (battery_state.charge_percent / 10), 4), 0, GCornerNone);
+  graphics_draw_rect(ctx, frame);
+  graphics_fill_rect(ctx, GRect(frame.origin.x + 2, frame.origin.y + 2, (battery_state.charge_percent / 10), 4), 0, GCornerNone);
 }
 
 
 static void do_async_weather_update(Window* watchface_window) {
    WatchfaceWindow *this = window_get_user_data(watchface_window);
   
-   cancel_weather_update_timer(this);
+   cancel_weather_retry(this);
+   activity_gate_fetched(&this->activity_gate);
    this->weather_update_backoff_interval = MIN_WEATHER_UPDATE_INTERVAL_MS;
    send_weather_request(watchface_window);  
 }
 
 
+// For the polls the breaker stands in front of: the scheduled ones and the catch ups for those deferred.
+static void do_guarded_weather_update(Window *watchface_window) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
+
+  circuit_breaker_probe_sent(&this->circuit_breaker, time(NULL));
+  do_async_weather_update(watchface_window);
+}
+
 static void update_bluetooth(Window *watchface_window, bool bluetooth_connected) {
   WatchfaceWindow *this = window_get_user_data(watchface_window);
 
-  strncpy(this->bluetooth_text, (bluetooth_connected ? ICON_NONE : ICON_BLUETOOTH_DISCONNECT), sizeof(this->bluetooth_text));
+  set_complication_text(this, LAYOUT_BLUETOOTH, this->bluetooth_text, sizeof(this->bluetooth_text),
+                        bluetooth_connected ? ICON_NONE : ICON_BLUETOOTH_DISCONNECT, REDRAW_CAUSE);
  
   this->bluetooth_connected = bluetooth_connected;
   
-  text_layer_set_text(this->bluetooth_text_layer, this->bluetooth_text);
-  
-  if (bluetooth_connected)  {// if we just got reconnected, then update the weather
+  // If we just got reconnected, then update the weather, unless what we have is still good.
+  if (bluetooth_connected && !update_weather_from_forecast(watchface_window, local_time_peek())
+      && time(NULL) - this->weather_received_at >= WEATHER_STALE_SECONDS)  {
     do_async_weather_update(watchface_window);
   }
 }
 
+// Hand outlines pointing at 12 around the center, for each hand style.  The GPaths only point at these; rotation
+// and position are kept in the GPath, so nothing needs allocating to draw the hands.
+static GPoint s_traditional_hour_points[] = { {7, 0}, {0, -50}, {-7, 0} };
+static GPoint s_traditional_minute_points[] = { {7, 0}, {0, -75}, {-7, 0} };
+static GPoint s_space_hour_points[] = { {4, 0}, {4, -45}, {-4, -45}, {-4, 0} };
+static GPoint s_space_minute_points[] = { {4, 0}, {4, -70}, {-4, -70}, {-4, 0} };
+
+static void set_hand_paths(WatchfaceWindow *this) {
+  if (this->hand_style == 2) { // Space
+    this->hour_hand_path = (GPath) { .num_points = ARRAY_LENGTH(s_space_hour_points),
+                                     .points = s_space_hour_points };
+    this->minute_hand_path = (GPath) { .num_points = ARRAY_LENGTH(s_space_minute_points),
+                                       .points = s_space_minute_points };
+  } else { // Traditional
+    this->hour_hand_path = (GPath) { .num_points = ARRAY_LENGTH(s_traditional_hour_points),
+                                     .points = s_traditional_hour_points };
+    this->minute_hand_path = (GPath) { .num_points = ARRAY_LENGTH(s_traditional_minute_points),
+                                       .points = s_traditional_minute_points };
+  }
+}
+
 static void update_hands(Layer *layer, GContext *ctx) {
   WatchfaceWindow *this = window_get_user_data(layer_get_window(layer));
+  REDRAW_DRAW_BEGIN();
+  ALLOC_TRACE_STEADY_BEGIN();
+  if (seconds_only_frame(this)) {
+    ALLOC_TRACE_END();
+    REDRAW_DRAW_END();
+    return;
+  }
+  FRAME_TIME_BEGIN(FRAME_PROC_HANDS);
 
   GRect bounds = layer_get_bounds(this->hands_layer);
   GPoint center = grect_center_point(&bounds);
 
   time_t now = time(NULL);
   struct tm *t = localtime(&now);
+  DirectDraw draw;
 
 #ifdef PBL_COLOR
   graphics_context_set_antialiased(ctx, true);
 #endif
 
-  // destroy old hands
-  gpath_destroy(this->hour_hand_path);
-  gpath_destroy(this->minute_hand_path);
+  direct_draw_begin(&draw, ctx);
+  gpath_move_to(&this->hour_hand_path, center);
+  gpath_move_to(&this->minute_hand_path, center);
 
   if (this->hand_style == 1) // Traditional
   {
-    GPathInfo hour_hand_points = { 3, (GPoint []){ {7, 0}, {0, -50}, {-7, 0} } };
-    GPathInfo minute_hand_points = { 3, (GPoint []) { {7, 0}, {0, -75}, {-7, 0} } };
-
-    // create new hands
-    this->hour_hand_path = gpath_create(&hour_hand_points);
-    this->minute_hand_path = gpath_create(&minute_hand_points);
-    gpath_move_to(this->hour_hand_path, center);
-    gpath_move_to(this->minute_hand_path, center);
-
     // hour hand
-    graphics_context_set_stroke_color(ctx, this->color_background);
-    graphics_context_set_fill_color(ctx, this->color_foreground_2);
-    gpath_rotate_to(this->hour_hand_path, (TRIG_MAX_ANGLE * (((t->tm_hour % 12) * 6) + (t->tm_min / 10))) / (12 * 6));
-    gpath_draw_filled(ctx, this->hour_hand_path);
-    gpath_draw_outline(ctx, this->hour_hand_path);
+    gpath_rotate_to(&this->hour_hand_path, (TRIG_MAX_ANGLE * (((t->tm_hour % 12) * 6) + (t->tm_min / 10))) / (12 * 6));
+    direct_draw_path_filled(&draw, &this->hour_hand_path, this->color_foreground_2);
+    direct_draw_path_outline(&draw, &this->hour_hand_path, this->color_background);
 
     // draw circle above hour hand, under minute hand
-    graphics_context_set_stroke_color(ctx, this->color_background);
-    graphics_draw_circle(ctx, center, 6);
+    direct_draw_circle(&draw, center, 6, this->color_background);
 
     // minute hand
-    graphics_context_set_stroke_color(ctx, this->color_background);
-    graphics_context_set_fill_color(ctx, this->color_foreground_2);
-    gpath_rotate_to(this->minute_hand_path, TRIG_MAX_ANGLE * t->tm_min / 60);
-    gpath_draw_filled(ctx, this->minute_hand_path);
-    gpath_draw_outline(ctx, this->minute_hand_path);
+    gpath_rotate_to(&this->minute_hand_path, TRIG_MAX_ANGLE * t->tm_min / 60);
+    direct_draw_path_filled(&draw, &this->minute_hand_path, this->color_foreground_2);
+    direct_draw_path_outline(&draw, &this->minute_hand_path, this->color_background);
 
     // dot in the middle
-    graphics_context_set_fill_color(ctx, this->color_foreground_2);
-    graphics_fill_circle(ctx, center, 5);
-    graphics_context_set_stroke_color(ctx, this->color_background);
-    graphics_draw_circle(ctx, center, 3);
-    graphics_context_set_fill_color(ctx, this->color_background);
-    graphics_fill_circle(ctx, center, 1);
+    direct_draw_fill_circle(&draw, center, 5, this->color_foreground_2);
+    direct_draw_circle(&draw, center, 3, this->color_background);
+    direct_draw_fill_circle(&draw, center, 1, this->color_background);
   }
   else if (this->hand_style == 2) // Space
   {
-    GPathInfo hour_hand_points = { 4, (GPoint []) { {4, 0}, {4, -45}, {-4, -45}, {-4, 0} } };
-    GPathInfo minute_hand_points = { 4, (GPoint []) { {4, 0}, {4, -70}, {-4, -70}, {-4, 0} } };
-
-    // create new hands
-    this->hour_hand_path = gpath_create(&hour_hand_points);
-    this->minute_hand_path = gpath_create(&minute_hand_points);
-    gpath_move_to(this->hour_hand_path, center);
-    gpath_move_to(this->minute_hand_path, center);
-
     // hour hand
-    graphics_context_set_stroke_color(ctx, this->color_foreground_2);
-    graphics_context_set_fill_color(ctx, this->color_background);
-    gpath_rotate_to(this->hour_hand_path, (TRIG_MAX_ANGLE * (((t->tm_hour % 12) * 6) + (t->tm_min / 10))) / (12 * 6));
-    gpath_draw_filled(ctx, this->hour_hand_path);
-    gpath_draw_outline(ctx, this->hour_hand_path);
+    gpath_rotate_to(&this->hour_hand_path, (TRIG_MAX_ANGLE * (((t->tm_hour % 12) * 6) + (t->tm_min / 10))) / (12 * 6));
+    direct_draw_path_filled(&draw, &this->hour_hand_path, this->color_background);
+    direct_draw_path_outline(&draw, &this->hour_hand_path, this->color_foreground_2);
 
     // minute hand
-    graphics_context_set_stroke_color(ctx, this->color_foreground_2);
-    graphics_context_set_fill_color(ctx, this->color_background);
-    gpath_rotate_to(this->minute_hand_path, TRIG_MAX_ANGLE * t->tm_min / 60);
-    gpath_draw_filled(ctx, this->minute_hand_path);
-    gpath_draw_outline(ctx, this->minute_hand_path);
+    gpath_rotate_to(&this->minute_hand_path, TRIG_MAX_ANGLE * t->tm_min / 60);
+    direct_draw_path_filled(&draw, &this->minute_hand_path, this->color_background);
+    direct_draw_path_outline(&draw, &this->minute_hand_path, this->color_foreground_2);
 
     // disc in the middle
-    graphics_context_set_fill_color(ctx, this->color_background);
-    graphics_fill_circle(ctx, center, 7);
-    graphics_context_set_stroke_color(ctx, this->color_foreground_2);
-    graphics_draw_circle(ctx, center, 8);
+    direct_draw_fill_circle(&draw, center, 7, this->color_background);
+    direct_draw_circle(&draw, center, 8, this->color_foreground_2);
   }
+  direct_draw_end(&draw);
+  FRAME_TIME_END(FRAME_PROC_HANDS);
+  ALLOC_TRACE_END();
+  REDRAW_DRAW_END();
 }
 
 
 
 static void update_seconds(Layer *layer, GContext *ctx) {
   WatchfaceWindow *this = window_get_user_data(layer_get_window(layer));
+  REDRAW_DRAW_BEGIN();
+  ALLOC_TRACE_STEADY_BEGIN();
+  FRAME_TIME_BEGIN(FRAME_PROC_SECONDS);
   
 #ifdef PBL_COLOR
   graphics_context_set_antialiased(ctx, true);
 #endif
   
-  if (SHOW_SECONDS_HAND(this->seconds_hand_mode)) {
-    GRect bounds = layer_get_bounds(layer);
-    GPoint center = grect_center_point(&bounds);
-    int16_t second_hand_length = bounds.size.w / 2;
+  bool show = SHOW_SECONDS_HAND(this->seconds_hand_mode);
+  GRect bounds = layer_get_bounds(layer);
+  GPoint center = grect_center_point(&bounds);
+  int16_t second_hand_length = bounds.size.w / 2;
 
-    time_t now = time(NULL);
-    struct tm *t = localtime(&now);
-    int32_t second_angle = TRIG_MAX_ANGLE * t->tm_sec / 60;
-    GPoint second_hand = {
-      .x = (int16_t)(sin_lookup(second_angle) * (int32_t)second_hand_length / TRIG_MAX_RATIO) + center.x,
-      .y = (int16_t)(-cos_lookup(second_angle) * (int32_t)second_hand_length / TRIG_MAX_RATIO) + center.y,
-    };
+  time_t now = time(NULL);
+  struct tm *t = localtime(&now);
+  int32_t second_angle = TRIG_MAX_ANGLE * t->tm_sec / 60;
+  GPoint second_hand = {
+    .x = (int16_t)(sin_lookup(second_angle) * (int32_t)second_hand_length / TRIG_MAX_RATIO) + center.x,
+    .y = (int16_t)(-cos_lookup(second_angle) * (int32_t)second_hand_length / TRIG_MAX_RATIO) + center.y,
+  };
 
-    graphics_context_set_stroke_color(ctx, this->color_foreground_3);
-    graphics_draw_line(ctx, second_hand, center);
+  // The layer covers the window, so its coordinates are frame buffer coordinates.  On a full frame the hand was
+  // painted over already; otherwise take the last one away.  Either way, save what the new one will cover.
+  DirectDraw draw;
+  direct_draw_begin(&draw, ctx);
+  GBitmap *frame_buffer = draw.frame_buffer != NULL ? draw.frame_buffer : graphics_capture_frame_buffer(ctx);
+  if (frame_buffer != NULL) {
+    if (this->full_frame) {
+      save_under_invalidate(&this->second_hand_save_under);
+    } else {
+      save_under_restore(&this->second_hand_save_under, frame_buffer);
+    }
+    if (show) {
+      // One pixel either side for antialiasing.
+      save_under_capture(&this->second_hand_save_under, frame_buffer, center, second_hand, 1);
+    }
+    if (frame_buffer != draw.frame_buffer) {
+      graphics_release_frame_buffer(ctx, frame_buffer);
+    }
+  } else {
+    save_under_invalidate(&this->second_hand_save_under);
   }
+  this->full_frame = false;
+
+  if (show) {
+    direct_draw_line(&draw, second_hand, center, this->color_foreground_3);
+  }
+  direct_draw_end(&draw);
+  // Topmost, so drawn last.
+  startup_profile_mark(STARTUP_PHASE_FIRST_FRAME);
+  ALLOC_TRACE_READY();
+  FRAME_TIME_END(FRAME_PROC_SECONDS);
+  ALLOC_TRACE_END();
+  REDRAW_DRAW_END();
 }
 
 
@@ -885,56 +1131,159 @@ static bool inQuietTime(WatchfaceWindow *this, int hour) {
     quiet = (hour >= this->weather_quiet_time_start) && (hour < this->weather_quiet_time_stop);
   else  // this would be like start at 11pm and stop at 6am
     quiet = (hour >= this->weather_quiet_time_start) || (hour < this->weather_quiet_time_stop);
-  // APP_LOG(APP_LOG_LEVEL_DEBUG, "checking for inQuietTime (%d %d %d) ==  %d", this->weather_quiet_time, this->weather_quiet_time_start, this->weather_quiet_time_stop, quiet);     
+  // LOG_DEBUG("checking for inQuietTime (%d %d %d) ==  %d", this->weather_quiet_time, this->weather_quiet_time_start, this->weather_quiet_time_stop, quiet);     
   return quiet;  
 }
 
+// Only drawing happens here.  Anything that has to happen at a given time is a job on the scheduler.
 static void update_time(Window *watchface_window, struct tm *local_time) {
   WatchfaceWindow *this = window_get_user_data(watchface_window);
 
   //if (SHOW_SECONDS_HAND(this->seconds_hand_mode)) {
-    layer_mark_dirty(this->second_hand_layer);
+    REDRAW_MARK_DIRTY(this->second_hand_layer, REDRAW_CAUSE);
   //}
 
+  if (local_time->tm_sec == 0) { // Top of minute
+    need_full_frame(this);
+    REDRAW_MARK_DIRTY(this->hands_layer, REDRAW_CAUSE);
+    REDRAW_LOG();
+    ALLOC_TRACE_LOG();
+  }
+}
+
+static void refresh_timezone(Window *watchface_window, struct tm *local_time) {
+#if FEATURE_TIMEZONE
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
+
   if (this->show_timezone && (strcmp(local_time->tm_zone, this->timezone_text) != 0)) {
     update_timezone(watchface_window, local_time->tm_zone);
-  } 
+  }
+#endif
+}
 
-  if (local_time->tm_sec == 0) { // Top of minute
-    layer_mark_dirty(this->hands_layer);
+// The next time after local_time that the local clock reads a whole multiple of minutes past the hour.
+static time_t next_local_boundary(struct tm const *local_time, int minutes) {
+  return time(NULL) + (minutes - local_time->tm_min % minutes) * 60 - local_time->tm_sec;
+}
+
+static time_t next_local_midnight(struct tm const *local_time) {
+  return time(NULL) + 24 * 60 * 60 - (local_time->tm_hour * 60 + local_time->tm_min) * 60 - local_time->tm_sec;
+}
 
-    if (local_time->tm_min == 0 && local_time->tm_hour == 0) { // Midnight
-        update_date(watchface_window);
+static void daylight_due(void *watchface_window) {
+  update_daylight(watchface_window, local_time_peek());
+  schedule_daylight(watchface_window);
+}
+
+// Sunrise or sunset, whichever comes next today.  Tomorrow's is scheduled at midnight.
+static void schedule_daylight(Window *watchface_window) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
+  struct tm *local_time = local_time_peek();
+  int minute = local_time->tm_hour * 60 + local_time->tm_min;
+  int next = MINUTES_PER_DAY;
+
+  if (this->has_location) {
+    if (this->solar_day.sunrise > minute && this->solar_day.sunrise < next) {
+      next = this->solar_day.sunrise;
     }
-    
-#if 0
-    // this is for testing updates... comment out for actual releases  ... provides update every 5 minutes
-   APP_LOG(APP_LOG_LEVEL_DEBUG, "countdown to weather update %d", local_time->tm_min % 5);
+    if (this->solar_day.sunset > minute && this->solar_day.sunset < next) {
+      next = this->solar_day.sunset;
+    }
+  }
 
-   if ((local_time->tm_min % 5 == 0) && !inQuietTime(this, local_time->tm_hour)) { // Top and bottom of hour
-      APP_LOG(APP_LOG_LEVEL_DEBUG, "doing call for weather in debug mode");
-#else
-    if ((local_time->tm_min == 30 || local_time->tm_min == 0) && !inQuietTime(this, local_time->tm_hour)) { // Top and bottom of hour
-#endif
-      do_async_weather_update(watchface_window);
+  if (next == MINUTES_PER_DAY) {
+    scheduler_cancel(&this->scheduler, JOB_DAYLIGHT);
+  } else {
+    scheduler_at(&this->scheduler, JOB_DAYLIGHT, time(NULL) + (next - minute) * 60 - local_time->tm_sec, daylight_due);
+  }
+}
+
+static void midnight_due(void *watchface_window) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
+  struct tm *local_time = local_time_peek();
+
+  update_date(watchface_window);
+  update_solar_day(this, local_time);
+  update_daylight(watchface_window, local_time);
+  schedule_daylight(watchface_window);
+  scheduler_at(&this->scheduler, JOB_MIDNIGHT, next_local_midnight(local_time), midnight_due);
+}
+
+static void catch_up_due(void *watchface_window) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
+
+  if (inQuietTime(this, local_time_peek()->tm_hour) || !circuit_breaker_allow(&this->circuit_breaker, time(NULL))) {
+    return;  // the first poll after quiet time or with the breaker letting it through looks again
+  }
+  if (activity_gate_take_catch_up(&this->activity_gate)) {
+    LOG_DEBUG("catching up on weather skipped while inactive");
+    do_guarded_weather_update(watchface_window);
+  } else if (this->activity_gate.catch_up_pending) {
+    scheduler_at(&this->scheduler, JOB_CATCH_UP, time(NULL) + CATCH_UP_CHECK_SECONDS, catch_up_due);
+  }
+}
+
+static void save_stats_due(void *watchface_window) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
 
+  event_log_save();
+  frame_time_save();
+  radio_stats_save();
+  save_seconds_redraws_saved(this);
+  scheduler_at(&this->scheduler, JOB_SAVE_STATS, time(NULL) + STATS_SAVE_SECONDS, save_stats_due);
+}
+
+static void weather_poll_due(void *watchface_window) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
+  struct tm *local_time = local_time_peek();
+
+  scheduler_at(&this->scheduler, JOB_WEATHER_POLL, next_local_boundary(local_time, WEATHER_POLL_MINUTES),
+               weather_poll_due);
+
+  // A daylight saving change or a trip moves the timezone, local midnight and today's sunrise and sunset.  They
+  // only ever move on the hour or half hour.
+  refresh_timezone(watchface_window, local_time);
+  update_daylight(watchface_window, local_time);
+  schedule_daylight(watchface_window);
+  scheduler_at(&this->scheduler, JOB_MIDNIGHT, next_local_midnight(local_time), midnight_due);
+
+  if (!update_weather_from_forecast(watchface_window, local_time) && !inQuietTime(this, local_time->tm_hour)) {
+    // Unless the forecast still covers us
+    // The gate first, so a poll it defers is caught up on later even while the breaker is holding polls back.
+    if (activity_gate_allow(&this->activity_gate) && circuit_breaker_allow(&this->circuit_breaker, time(NULL))) {
+      do_guarded_weather_update(watchface_window);
+    } else if (this->activity_gate.catch_up_pending && !scheduler_pending(&this->scheduler, JOB_CATCH_UP)) {
+      scheduler_at(&this->scheduler, JOB_CATCH_UP, time(NULL) + CATCH_UP_CHECK_SECONDS, catch_up_due);
     }
   }
 }
 
 static void handle_tick(struct tm *tick_time, TimeUnits units_changed) {
+  ALLOC_TRACE_STEADY_BEGIN();
   update_time(g_watchface_window, tick_time);
+  ALLOC_TRACE_END();
 }
 
 static void handle_battery_state(BatteryChargeState battery_state) {
   WatchfaceWindow *this = window_get_user_data(g_watchface_window);
-  layer_mark_dirty(this->battery_layer);
+  ALLOC_TRACE_STEADY_BEGIN();
+  update_battery(this, battery_state);
+  ALLOC_TRACE_END();
 }
 
 static void handle_bluetooth(bool bluetooth_connected) {
   WatchfaceWindow *this = window_get_user_data(g_watchface_window);
 
-  update_bluetooth(g_watchface_window, bluetooth_connected);
+  ALLOC_TRACE_BEGIN();
+  connection_debouncer_update(&this->bluetooth_debouncer, bluetooth_connected);
+  ALLOC_TRACE_END();
+}
+
+static void bluetooth_settled(bool bluetooth_connected, void *watchface_window) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
+
+  update_bluetooth(watchface_window, bluetooth_connected);
+  event_log_add(EVENT_BLUETOOTH, bluetooth_connected);
 
   if (!bluetooth_connected && this->vibrate_on_bluetooth_disconnect) {
     vibes_double_pulse();
@@ -946,7 +1295,7 @@ static void watchface_tick_timer_service_subscribe(Window *watchface_window) {
 
   tick_timer_service_unsubscribe();
 
-  //APP_LOG (APP_LOG_LEVEL_DEBUG, "updating tick timer service %02x %d", this->seconds_hand_mode, SHOW_SECONDS_HAND(this->seconds_hand_mode));
+  //LOG_DEBUG("updating tick timer service %02x %d", this->seconds_hand_mode, SHOW_SECONDS_HAND(this->seconds_hand_mode));
   if (SHOW_SECONDS_HAND(this->seconds_hand_mode)) {
     tick_timer_service_subscribe(SECOND_UNIT, handle_tick);
   }
@@ -955,21 +1304,54 @@ static void watchface_tick_timer_service_subscribe(Window *watchface_window) {
   }
 }
 
-static Layer *battery_layer_create(int midX, int midY) {
-  Layer *battery_layer = layer_create(GRect(midX - 7, 35, 14, 8));
-  layer_set_update_proc(battery_layer, update_battery_state);
-  return battery_layer;
+static void draw_complication_text(WatchfaceWindow *this, GContext *ctx, LayoutItem item, char const *text, GFont font) {
+  if (text[0] != '\0') {
+    graphics_draw_text(ctx, text, font, this->layout.frames[item], GTextOverflowModeWordWrap, GTextAlignmentCenter, NULL);
+  }
+}
+
+static void update_complications(Layer *layer, GContext *ctx) {
+  WatchfaceWindow *this = window_get_user_data(layer_get_window(layer));
+  REDRAW_DRAW_BEGIN();
+  ALLOC_TRACE_STEADY_BEGIN();
+  if (seconds_only_frame(this)) {
+    ALLOC_TRACE_END();
+    REDRAW_DRAW_END();
+    return;
+  }
+  FRAME_TIME_BEGIN(FRAME_PROC_COMPLICATIONS);
+
+  graphics_context_set_text_color(ctx, this->color_foreground_1);
+  draw_complication_text(this, ctx, LAYOUT_DATE, this->date_text, this->font_date);
+  draw_complication_text(this, ctx, LAYOUT_TEMPERATURE, this->temperature_text, this->font_temperature);
+  draw_complication_text(this, ctx, LAYOUT_CONDITION, this->condition_text, this->font_condition);
+  draw_complication_text(this, ctx, LAYOUT_BATTERY_TEXT, this->battery_text, this->font_battery);
+  draw_complication_text(this, ctx, LAYOUT_BLUETOOTH, this->bluetooth_text, this->font_bluetooth);
+#if FEATURE_TIMEZONE
+  draw_complication_text(this, ctx, LAYOUT_TIMEZONE, this->timezone_text, this->font_date);
+#endif
+  draw_battery_gauge(this, ctx, this->layout.frames[LAYOUT_BATTERY]);
+
+  this->dirty_complications = 0;
+  FRAME_TIME_END(FRAME_PROC_COMPLICATIONS);
+  ALLOC_TRACE_END();
+  REDRAW_DRAW_END();
 }
 
 GFont get_weather_font(WatchfaceWindow *this) {
   switch (this->temperature_font_size) {
+#if FEATURE_SMALL_TEMPERATURE_FONT
     case 1: // small font;
       if (this->font_temperature_small == NULL)
-         this->font_temperature_small =  fonts_load_custom_font(resource_get_handle(RESOURCE_ID_FONT_EPITET_REGULAR_12)); 
+         this->font_temperature_small =  ALLOC_FONTS_LOAD_CUSTOM_FONT(resource_get_handle(RESOURCE_ID_FONT_EPITET_REGULAR_12)); 
       return this->font_temperature_small;
     break;
+#else
+    case 1: // no small font on this platform
+      return this->font_date;
+#endif
     default: // no font picked.  Default to medium font, but log an error first
-      APP_LOG(APP_LOG_LEVEL_ERROR, "trying to set weather font, but value out of range %d", this->temperature_font_size);      
+      LOG_ERROR("trying to set weather font, but value out of range %d", this->temperature_font_size);      
     case 2: // medium font  (which is the same font used for date)
        return this->font_date;
     break;
@@ -978,27 +1360,52 @@ GFont get_weather_font(WatchfaceWindow *this) {
 }
 
 
-static TextLayer *watchface_text_layer_create(GRect layer_bounds, GFont layer_font, GColor layer_color) {
-  TextLayer *new_text_layer = text_layer_create(layer_bounds);
-  text_layer_set_font(new_text_layer, layer_font);
-  text_layer_set_background_color(new_text_layer, GColorClear);
-  text_layer_set_text_color(new_text_layer, layer_color);
-  text_layer_set_text_alignment(new_text_layer, GTextAlignmentCenter);
-  return new_text_layer;
+
+
+// Every tick but the one on the minute is a redraw saved while the watch is still.  Counts the time still up to
+// now, and carries on counting from now if the hand stays away.
+static void count_seconds_redraws_saved(WatchfaceWindow *this) {
+  if (this->seconds_hand_still_since != 0) {
+    time_t now = time(NULL);
+    uint32_t still = now - this->seconds_hand_still_since;
+    this->seconds_redraws_saved += still - still / 60;
+    this->seconds_hand_still_since = now;
+  }
 }
 
+static void save_seconds_redraws_saved(WatchfaceWindow *this) {
+  count_seconds_redraws_saved(this);
+  if (this->seconds_redraws_saved != this->seconds_redraws_saved_at_save) {
+    persist_write_int(PERSIST_KEY_SECONDS_REDRAWS_SAVED, this->seconds_redraws_saved);
+    this->seconds_redraws_saved_at_save = this->seconds_redraws_saved;
+  }
+}
 
+static void seconds_hand_moving(WatchfaceWindow *this) {
+  count_seconds_redraws_saved(this);
+  this->seconds_hand_still_since = 0;
+  LOG_DEBUG("seconds hand back, %lu redraws saved so far", this->seconds_redraws_saved);
+}
 
+static void turn_off_seconds_after_timer(void* watchface_window) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
 
-static void turn_off_seconds_after_timer(void* watch_window) {
-  WatchfaceWindow* this = (WatchfaceWindow*)watch_window;
-  
-  this->seconds_duration_timer = NULL;
   if (this->seconds_hand_mode == SECONDS_HAND_FOR_FIXED_DURATION_ON) {
     this->seconds_hand_mode = SECONDS_HAND_FOR_FIXED_DURATION_OFF;
     force_immediate_time_update(g_watchface_window, true, true, false);
+  } else if (this->seconds_hand_mode == SECONDS_HAND_WHILE_MOVING_ON) {
+    // Motion only notes the time, so see whether there was any since this was set.
+    time_t still_at = this->last_motion + this->seconds_hand_duration * 60;
+    if (time(NULL) < still_at) {
+      scheduler_at(&this->scheduler, JOB_SECONDS_EXPIRY, still_at, turn_off_seconds_after_timer);
+      return;
+    }
+    // Nobody has moved the watch in a while, so nobody is watching the seconds.
+    this->seconds_hand_mode = SECONDS_HAND_WHILE_MOVING_OFF;
+    this->seconds_hand_still_since = time(NULL);
+    force_immediate_time_update(g_watchface_window, true, true, false);
   } else {
-    APP_LOG(APP_LOG_LEVEL_ERROR, "received request to turn off seconds based on timer but currently in wrong mode %d", this->seconds_hand_mode);
+    LOG_ERROR("received request to turn off seconds based on timer but currently in wrong mode %d", this->seconds_hand_mode);
   }
 }
 
@@ -1006,13 +1413,10 @@ static void turn_off_seconds_after_timer(void* watch_window) {
 
 static void register_seconds_duration_timer(Window* watchface_window) {
   WatchfaceWindow *this = window_get_user_data(watchface_window);
-  int duration = this->seconds_hand_duration * 60000;
-  
-  if (this->seconds_duration_timer)  { // if it already exists, reschedule it.
-      app_timer_reschedule(this->seconds_duration_timer, duration);  
-   } else {
-      this->seconds_duration_timer = app_timer_register(duration, turn_off_seconds_after_timer, this);
-  }
+
+  // Replaces the deadline if it is already running.
+  scheduler_at(&this->scheduler, JOB_SECONDS_EXPIRY, time(NULL) + this->seconds_hand_duration * 60,
+               turn_off_seconds_after_timer);
 }
 
 
@@ -1030,11 +1434,36 @@ static void force_immediate_time_update(Window* watchface_window, bool bUpdateTi
 }
 
 
+// From the motion detector, every couple of seconds while the watch moves, and from a tap.
+static void seconds_hand_motion(void *watchface_window) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
+  ALLOC_TRACE_STEADY_BEGIN();
+
+  this->last_motion = time(NULL);
+  if (this->seconds_hand_mode == SECONDS_HAND_WHILE_MOVING_OFF) {
+    this->seconds_hand_mode = SECONDS_HAND_WHILE_MOVING_ON;
+    seconds_hand_moving(this);
+    force_immediate_time_update(watchface_window, true, true, true);
+  }
+  ALLOC_TRACE_END();
+}
+
+static void update_motion_detector(Window *watchface_window) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
+
+  if (MOTION_NEEDED(this->seconds_hand_mode)) {
+    motion_detector_start(&this->motion, seconds_hand_motion, watchface_window);
+  } else {
+    motion_detector_stop(&this->motion);
+  }
+}
+
 static void tap_received(AccelAxisType axis, int32_t direction) {
   // A tap event occured
   WatchfaceWindow *this = window_get_user_data(g_watchface_window);
   time_t now = time(NULL);
   bool double_tap = false;
+  ALLOC_TRACE_STEADY_BEGIN();
   
   bool bUpdateTime = false;
   bool bUpdateTickTimerService = false;
@@ -1042,10 +1471,17 @@ static void tap_received(AccelAxisType axis, int32_t direction) {
   
   double_tap = (now - this->most_recent_tap < 2);
   this->most_recent_tap = now;
-  //APP_LOG(APP_LOG_LEVEL_DEBUG, "tap %d %lx", axis, direction);
+
+  activity_gate_tap(&this->activity_gate);
+  // Quiet time and the breaker first, so a tap while either holds polls back leaves the catch up for later.
+  if (!inQuietTime(this, local_time_peek()->tm_hour) && circuit_breaker_allow(&this->circuit_breaker, now)
+      && activity_gate_take_catch_up(&this->activity_gate)) {
+    do_guarded_weather_update(g_watchface_window);
+  }
+  //LOG_DEBUG("tap %d %lx", axis, direction);
   // ignore double, triple taps, based on if time is less than a second apart
   if (double_tap) {
-    //APP_LOG(APP_LOG_LEVEL_DEBUG, "ignored tap");
+    //LOG_DEBUG("ignored tap");
   } else {
   
     switch (this->seconds_hand_mode) {
@@ -1058,6 +1494,10 @@ static void tap_received(AccelAxisType axis, int32_t direction) {
       case SECONDS_HAND_FOR_FIXED_DURATION_ON:  // already showing for fixed duration... Restart the timer
         bUpdateDurationTimer = true;
       break;
+      case SECONDS_HAND_WHILE_MOVING_OFF:      // a flick is motion too, though the motion detector has likely seen it
+      case SECONDS_HAND_WHILE_MOVING_ON:
+        seconds_hand_motion(g_watchface_window);
+      break;
       case SECONDS_HAND_TOGGLE_TAP_OFF:        // currently not showing seconds hand.  Start showing it.
         this->seconds_hand_mode = SECONDS_HAND_TOGGLE_TAP_ON;
         bUpdateTime = true;
@@ -1069,13 +1509,13 @@ static void tap_received(AccelAxisType axis, int32_t direction) {
         bUpdateTickTimerService = true;
       break;
       default:
-        APP_LOG(APP_LOG_LEVEL_ERROR, "received tap when state does not expect one.  Current mode = %02x", this->seconds_hand_mode);
+        LOG_ERROR("received tap when state does not expect one.  Current mode = %02x", this->seconds_hand_mode);
       break;
     }
     
     force_immediate_time_update(g_watchface_window, bUpdateTime, bUpdateTickTimerService, bUpdateDurationTimer);
   }
-  
+  ALLOC_TRACE_END();
 }
 
 
@@ -1084,104 +1524,236 @@ static void tap_service_subscribe(WatchfaceWindow* this) {
 }
 
 
+// Frames for everything on the dial when only unobstructed_bounds can be seen.  Anything that would end up under
+// the obstruction moves up just far enough to stay visible; everything else stays put.
+static Layout compute_layout(GRect bounds, GRect unobstructed_bounds) {
+  int midX = bounds.size.w / 2;
+  int midY = bounds.size.h / 2;
+  int bottom = unobstructed_bounds.origin.y + unobstructed_bounds.size.h;
+
+  Layout layout = { .frames = {
+    [LAYOUT_DATE] = GRect(midX - 30, midY*2- 50, 60, 20),
+    [LAYOUT_TEMPERATURE] = GRect(midX/4, midY + 6, 44, 20),
+    [LAYOUT_CONDITION] = GRect(midX/4, midY - 21, 44, 30),
+    [LAYOUT_BATTERY] = GRect(midX - 7, 35, 14, 8),
+    [LAYOUT_BATTERY_TEXT] = GRect(midX +9, 34, 18, 14),
+    [LAYOUT_BLUETOOTH] = GRect(midX + 10, midY - 22, 50, 50),
+    [LAYOUT_TIMEZONE] = GRect(midX - 30, 47, 60, 20),
+  }};
+
+  for (int i = 0; i < LAYOUT_ITEM_COUNT; ++i) {
+    GRect *frame = &layout.frames[i];
+    if (frame->origin.y + frame->size.h > bottom) {
+      frame->origin.y = bottom - frame->size.h;
+    }
+  }
+  return layout;
+}
+
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+static void set_layout_frame(WatchfaceWindow *this, LayoutItem item, GRect frame) {
+  if (!grect_equal(&frame, &this->layout.frames[item])) {
+    this->layout.frames[item] = frame;
+    mark_complication_dirty(this, item, REDRAW_CAUSE);
+  }
+}
+
+static void unobstructed_area_will_change(GRect final_unobstructed_screen_area, void *watchface_window) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
+  GRect bounds = layer_get_bounds(window_get_root_layer(watchface_window));
+
+  need_full_frame(this);
+  if (grect_equal(&final_unobstructed_screen_area, &bounds)) {
+    this->layout_to = LAYOUT_STATE_UNOBSTRUCTED;
+  } else {
+    this->layout_to = LAYOUT_STATE_OBSTRUCTED;
+    if (!grect_equal(&final_unobstructed_screen_area, &this->obstructed_area)) {
+      this->layouts[LAYOUT_STATE_OBSTRUCTED] = compute_layout(bounds, final_unobstructed_screen_area);
+      this->obstructed_area = final_unobstructed_screen_area;
+    }
+  }
+
+  // Work out once which items move at all, so the animation steps only touch those.
+  this->layout_from = this->layout;
+  this->moving_items = 0;
+  for (int i = 0; i < LAYOUT_ITEM_COUNT; ++i) {
+    if (!grect_equal(&this->layout_from.frames[i], &this->layouts[this->layout_to].frames[i])) {
+      this->moving_items |= 1 << i;
+    }
+  }
+}
+
+static void unobstructed_area_change(AnimationProgress progress, void *watchface_window) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
+
+  for (int i = 0; i < LAYOUT_ITEM_COUNT; ++i) {
+    if (this->moving_items & (1 << i)) {
+      GRect from = this->layout_from.frames[i];
+      GRect to = this->layouts[this->layout_to].frames[i];
+
+      from.origin.x += (to.origin.x - from.origin.x) * (int32_t)progress / ANIMATION_NORMALIZED_MAX;
+      from.origin.y += (to.origin.y - from.origin.y) * (int32_t)progress / ANIMATION_NORMALIZED_MAX;
+      set_layout_frame(this, i, from);
+    }
+  }
+}
+
+static void unobstructed_area_did_change(void *watchface_window) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
+
+  need_full_frame(this);
+  for (int i = 0; i < LAYOUT_ITEM_COUNT; ++i) {
+    if (this->moving_items & (1 << i)) {
+      set_layout_frame(this, i, this->layouts[this->layout_to].frames[i]);
+    }
+  }
+  this->moving_items = 0;
+}
+#endif
+
 static void watchface_window_load(Window *watchface_window) {
   WatchfaceWindow *this = window_get_user_data(watchface_window);
 
   Layer *root_layer = window_get_root_layer(watchface_window);
   GRect bounds = layer_get_bounds(root_layer);
-  int midX = bounds.size.w / 2;
-  int midY = bounds.size.h / 2;
 
-  this->font_hours = fonts_load_custom_font(resource_get_handle(RESOURCE_ID_FONT_EPITET_REGULAR_24));
-  this->font_date = fonts_load_custom_font(resource_get_handle(RESOURCE_ID_FONT_EPITET_REGULAR_15));
+  // We may be launched with a peek already showing.
+  this->layouts[LAYOUT_STATE_UNOBSTRUCTED] = compute_layout(bounds, bounds);
+  this->layout = this->layouts[LAYOUT_STATE_UNOBSTRUCTED];
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+  GRect unobstructed_bounds = layer_get_unobstructed_bounds(root_layer);
+  if (!grect_equal(&unobstructed_bounds, &bounds)) {
+    this->obstructed_area = unobstructed_bounds;
+    this->layouts[LAYOUT_STATE_OBSTRUCTED] = compute_layout(bounds, unobstructed_bounds);
+    this->layout = this->layouts[LAYOUT_STATE_OBSTRUCTED];
+  }
+#endif
+
+  this->font_hours = ALLOC_FONTS_LOAD_CUSTOM_FONT(resource_get_handle(RESOURCE_ID_FONT_EPITET_REGULAR_24));
+  this->font_date = ALLOC_FONTS_LOAD_CUSTOM_FONT(resource_get_handle(RESOURCE_ID_FONT_EPITET_REGULAR_15));
+#if FEATURE_SMALL_TEMPERATURE_FONT
   this->font_temperature_small = NULL;
+#endif
   this->font_temperature = get_weather_font(this);
-  this->font_condition = fonts_load_custom_font(resource_get_handle(RESOURCE_ID_FONT_ICONS_24));
-  this->font_battery = fonts_load_custom_font(resource_get_handle(RESOURCE_ID_FONT_ICONS_12));
-  this->font_bluetooth = fonts_load_custom_font(resource_get_handle(RESOURCE_ID_FONT_ICONS_36));
+  this->font_condition = ALLOC_FONTS_LOAD_CUSTOM_FONT(resource_get_handle(RESOURCE_ID_FONT_ICONS_24));
+  this->font_battery = ALLOC_FONTS_LOAD_CUSTOM_FONT(resource_get_handle(RESOURCE_ID_FONT_ICONS_12));
+  this->font_bluetooth = ALLOC_FONTS_LOAD_CUSTOM_FONT(resource_get_handle(RESOURCE_ID_FONT_ICONS_36));
 
   this->color_background = GColorFromHEX(this->bg_color); 
   this->color_foreground_1 = GColorFromHEX(this->fg1_color);
   this->color_foreground_2 = GColorFromHEX(this->fg2_color);
   this->color_foreground_3 = GColorFromHEX(this->fg3_color);
 
-  this->background_layer = layer_create(bounds);
+  this->background_layer = ALLOC_LAYER_CREATE(bounds);
   layer_set_update_proc(this->background_layer, update_background);
   layer_add_child(root_layer, this->background_layer);
 
-  this->date_text_layer = watchface_text_layer_create(GRect(midX - 30, midY*2- 50, 60, 20), this->font_date, this->color_foreground_1);
-  layer_add_child(root_layer, text_layer_get_layer(this->date_text_layer));
-
-  this->temperature_text_layer = watchface_text_layer_create(GRect(midX/4, midY + 6, 44, 20), this->font_temperature, this->color_foreground_1);
-  layer_add_child(root_layer, text_layer_get_layer(this->temperature_text_layer));
-
-  this->condition_text_layer = watchface_text_layer_create(GRect(midX/4, midY - 21, 44, 30), this->font_condition, this->color_foreground_1);
-  layer_add_child(root_layer, text_layer_get_layer(this->condition_text_layer));
-
-  this->battery_layer = battery_layer_create(midX, midY);  // midX - 7, 35, 14, 8
-  layer_add_child(root_layer, this->battery_layer);
-
-  this->battery_text_layer = watchface_text_layer_create(GRect(midX +9, 34, 18, 14), this->font_battery, this->color_foreground_1);
-  layer_add_child(root_layer, text_layer_get_layer(this->battery_text_layer));
-
-  this->bluetooth_text_layer = watchface_text_layer_create(GRect(midX + 10, midY - 22, 50, 50), this->font_bluetooth, this->color_foreground_1);
-  layer_add_child(root_layer, text_layer_get_layer(this->bluetooth_text_layer));
-  
-  this->timezone_text_layer = watchface_text_layer_create(GRect(midX - 30, 47, 60, 20), this->font_date, this->color_foreground_1);
-  layer_add_child(root_layer, text_layer_get_layer(this->timezone_text_layer));
+  this->complications_layer = ALLOC_LAYER_CREATE(bounds);
+  layer_set_update_proc(this->complications_layer, update_complications);
+  layer_add_child(root_layer, this->complications_layer);
   
   this->bluetooth_connected = false;
 
-  this->hands_layer = layer_create(bounds);
+  set_hand_paths(this);
+  this->hands_layer = ALLOC_LAYER_CREATE(bounds);
   layer_set_update_proc(this->hands_layer, update_hands);
   layer_add_child(root_layer, this->hands_layer);
   
-  this->second_hand_layer = layer_create(bounds);
+  this->second_hand_layer = ALLOC_LAYER_CREATE(bounds);
   layer_set_update_proc(this->second_hand_layer, update_seconds);
   layer_add_child(root_layer, this->second_hand_layer);
   
   if (TAP_SENSOR_NEEDED(this->seconds_hand_mode)) {
     tap_service_subscribe(this);
   }
+  update_motion_detector(watchface_window);
+  startup_profile_mark(STARTUP_PHASE_LOAD);
 }
   
 
 
+// Whatever covered us, a notification or the launcher, has left the frame buffer with it.
+static void handle_focus(bool in_focus) {
+  WatchfaceWindow *this = window_get_user_data(g_watchface_window);
+
+  if (in_focus) {
+    need_full_frame(this);
+    layer_mark_dirty(window_get_root_layer(g_watchface_window));
+  }
+}
+
 static void watchface_window_appear(Window *watchface_window) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
   ConnectionHandlers handlers = {handle_bluetooth, NULL};
 
-  update_time(watchface_window, local_time_peek());
+  need_full_frame(this);
+  app_focus_service_subscribe_handlers((AppFocusHandlers) { .did_focus = handle_focus });
+
+  struct tm *local_time = local_time_peek();
+
+  // Someone just looked, so start off showing the seconds and let stillness turn them off.
+  this->last_motion = time(NULL);
+  if (this->seconds_hand_mode == SECONDS_HAND_WHILE_MOVING_OFF) {
+    this->seconds_hand_mode = SECONDS_HAND_WHILE_MOVING_ON;
+    seconds_hand_moving(this);
+  }
+  if (this->seconds_hand_mode == SECONDS_HAND_WHILE_MOVING_ON) {
+    register_seconds_duration_timer(watchface_window);
+  }
+
+  update_time(watchface_window, local_time);
+  refresh_timezone(watchface_window, local_time);
+  update_weather_from_forecast(watchface_window, local_time);
   watchface_tick_timer_service_subscribe(watchface_window);
 
+  scheduler_at(&this->scheduler, JOB_WEATHER_POLL, next_local_boundary(local_time, WEATHER_POLL_MINUTES),
+               weather_poll_due);
+  scheduler_at(&this->scheduler, JOB_MIDNIGHT, next_local_midnight(local_time), midnight_due);
+  schedule_daylight(watchface_window);
+  if (!scheduler_pending(&this->scheduler, JOB_SAVE_STATS)) {
+    scheduler_at(&this->scheduler, JOB_SAVE_STATS, time(NULL) + STATS_SAVE_SECONDS, save_stats_due);
+  }
+
+  update_battery(this, battery_state_service_peek());
   battery_state_service_subscribe(handle_battery_state);
 
-  update_bluetooth(watchface_window, connection_service_peek_pebble_app_connection());
+  bool bluetooth_connected = connection_service_peek_pebble_app_connection();
+  connection_debouncer_init(&this->bluetooth_debouncer, bluetooth_connected, BLUETOOTH_DISCONNECT_DEBOUNCE_MS,
+                            BLUETOOTH_CONNECT_DEBOUNCE_MS, bluetooth_settled, watchface_window);
+  update_bluetooth(watchface_window, bluetooth_connected);
   connection_service_subscribe(handlers);
+
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+  unobstructed_area_service_subscribe((UnobstructedAreaHandlers) {
+    .will_change = unobstructed_area_will_change,
+    .change = unobstructed_area_change,
+    .did_change = unobstructed_area_did_change,
+  }, watchface_window);
+#endif
+  startup_profile_mark(STARTUP_PHASE_APPEAR);
 }
 
 static void watchface_window_disappear(Window *watchface_window) {
   WatchfaceWindow *this = window_get_user_data(watchface_window);
   
+  app_focus_service_unsubscribe();
   connection_service_unsubscribe();
+  connection_debouncer_cancel(&this->bluetooth_debouncer);
   battery_state_service_unsubscribe();
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+  unobstructed_area_service_unsubscribe();
+#endif
   tick_timer_service_unsubscribe();
   if (TAP_SENSOR_NEEDED(this->seconds_hand_mode)) {
     accel_tap_service_unsubscribe();
   }
+  motion_detector_stop(&this->motion);
 }
 
 static void watchface_window_unload(Window *watchface_window) {
   WatchfaceWindow *this = window_get_user_data(watchface_window);
 
-  if (this->seconds_duration_timer) {
-    app_timer_cancel(this->seconds_duration_timer);
-    this->seconds_duration_timer = NULL;
-  }
-  
-  cancel_weather_update_timer(this);
-
-  gpath_destroy(this->hour_hand_path);
-  gpath_destroy(this->minute_hand_path);
+  scheduler_stop(&this->scheduler);
 
   layer_destroy(this->second_hand_layer);
   this->second_hand_layer = NULL;
@@ -1189,37 +1761,23 @@ static void watchface_window_unload(Window *watchface_window) {
   layer_destroy(this->hands_layer);
   this->hands_layer = NULL;
 
-  text_layer_destroy(this->bluetooth_text_layer);
-  this->bluetooth_text_layer = NULL;
-
-  text_layer_destroy(this->battery_text_layer);
-  this->battery_text_layer = NULL;
-
-  layer_destroy(this->battery_layer);
-  this->battery_layer = NULL;
-
-  text_layer_destroy(this->condition_text_layer);
-  this->condition_text_layer = NULL;
-
-  text_layer_destroy(this->temperature_text_layer);
-  this->temperature_text_layer = NULL;
-
-  text_layer_destroy(this->date_text_layer);
-  this->date_text_layer = NULL;
-  
-  text_layer_destroy(this->timezone_text_layer);
-  this->timezone_text_layer = NULL;
+  layer_destroy(this->complications_layer);
+  this->complications_layer = NULL;
+  this->dirty_complications = 0;
 
   layer_destroy(this->background_layer);
   this->background_layer = NULL;
+  direct_draw_snapshot_free(&this->dial);
 
   fonts_unload_custom_font(this->font_bluetooth);
   this->font_bluetooth = NULL;
 
+#if FEATURE_SMALL_TEMPERATURE_FONT
   if (this->font_temperature_small != NULL) {
     fonts_unload_custom_font(this->font_temperature_small);
     this->font_temperature_small = NULL;
   }
+#endif
   this->font_temperature = NULL;
   
   fonts_unload_custom_font(this->font_battery);
@@ -1235,8 +1793,33 @@ static void watchface_window_unload(Window *watchface_window) {
   this->font_hours = NULL;
 }
 
+// Answers ready when no weather request does, so the phone still hears whether settings are stored.
+static void send_ready(void) {
+  DictionaryIterator *iterator;
+  AppMessageResult result;
+
+  if ((result = app_message_outbox_begin(&iterator)) != APP_MSG_OK) {
+    log_reason("unable to begin outbox for ready", result);
+    radio_stats_outcome(RADIO_BEGIN_FAILED);
+    return;
+  }
+  dict_write_int32(iterator, KEY_MESSAGE_TYPE, MESSAGE_TYPE_READY);
+  dict_write_uint8(iterator, KEY_SETTINGS_STORED, persist_exists(PERSIST_KEY_SETTINGS_STORED));
+  radio_stats_sent(MESSAGE_TYPE_READY, dict_write_end(iterator));
+  if ((result = app_message_outbox_send()) != APP_MSG_OK) {
+    log_reason("unable to send ready", result);
+    radio_stats_send_failed(result);
+  }
+}
+
 static void ready_received(void *watchface_window) {
-  do_async_weather_update(watchface_window);
+  startup_profile_mark(STARTUP_PHASE_READY);
+
+  if (!update_weather_from_forecast(watchface_window, local_time_peek())) {
+    do_async_weather_update(watchface_window);
+  } else {
+    send_ready();
+  }
 
   update_date(watchface_window);
 }
@@ -1244,11 +1827,45 @@ static void ready_received(void *watchface_window) {
 static void weather_received(void *watchface_window, Message const *message) {
   WatchfaceWindow *this = window_get_user_data(watchface_window);
 
+  round_trip_reply_received(&this->round_trip, message->message_id, message->size);
+  round_trip_log(&this->round_trip);
+
+  event_log_add(EVENT_WEATHER_RECEIVED, message->message_id);
+  startup_profile_mark(STARTUP_PHASE_FIRST_WEATHER);
+  startup_profile_save(PERSIST_KEY_STARTUP_PROFILES);
+
   if (message->message_id == this->expected_weather_message_id) {
-    cancel_weather_update_timer(this);
+    cancel_weather_retry(this);
 
+    if (message->latitude != LOCATION_NOT_SENT || message->longitude != LOCATION_NOT_SENT) {
+      location_received(watchface_window, message);
+    }
     update_condition(watchface_window, message->condition_code, message->is_daylight);
     update_temperature(watchface_window, message->temperature);
+
+    if (message->forecast_length > 0) {
+      forecast_received(watchface_window, message);
+    }
+    circuit_breaker_success(&this->circuit_breaker);
+    this->weather_received_at = time(NULL);
+  }
+}
+
+// The phone could not get the weather.  Stop the retry timer if the breaker says we have been failing long enough
+// for it to be pointless.
+static void error_received(void *watchface_window, Message const *message) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
+
+  round_trip_reply_received(&this->round_trip, message->message_id, message->size);
+  event_log_add(EVENT_WEATHER_ERROR, message->error_kind);
+
+  if (message->message_id == this->expected_weather_message_id) {
+    mark_as_syncing(watchface_window, false);
+    circuit_breaker_failure(&this->circuit_breaker, message->error_kind, time(NULL));
+    if (this->circuit_breaker.state == BREAKER_OPEN) {
+      cancel_weather_retry(this);
+    }
+    circuit_breaker_log(&this->circuit_breaker);
   }
 }
 
@@ -1256,7 +1873,10 @@ static void weather_received(void *watchface_window, Message const *message) {
 
 static void settings_received(void *watchface_window, Message const *message) {
   WatchfaceWindow *this = window_get_user_data(watchface_window);
-  
+
+  event_log_add(EVENT_SETTINGS_RECEIVED, 0);  
+  persist_write_bool(PERSIST_KEY_SETTINGS_STORED, true);
+  need_full_frame(this);  // colors and hand style change under the second hand
   bool bUpdateTime = false;
   bool bUpdateTickTimer = true;
   bool bUpdateTapSensor = true;
@@ -1295,18 +1915,20 @@ static void settings_received(void *watchface_window, Message const *message) {
   if (this->show_timezone != message->show_timezone) {
     this->show_timezone = message->show_timezone;
     persist_write_bool(MESSAGE_KEY_SHOW_TIMEZONE, this->show_timezone);
-    update_timezone(watchface_window, "");  // just make it null.   It will update on the next tick if we want to see the timezone
+    update_timezone(watchface_window, "");  // just make it null, then fill it back in if we want to see the timezone
+    refresh_timezone(watchface_window, local_time_peek());
   }
   
   if (this->show_battery_at_percent != message->show_battery_at_percent) {
     this->show_battery_at_percent = message->show_battery_at_percent;
     persist_write_int(MESSAGE_KEY_SHOW_BATTERY_AT_PERCENT, this->show_battery_at_percent);
-    layer_mark_dirty(this->battery_layer);
+    mark_complication_dirty(this, LAYOUT_BATTERY, REDRAW_CAUSE);
   }
 
   if (this->hand_style != message->hand_style) {
     this->hand_style = message->hand_style;
     persist_write_int(MESSAGE_KEY_HAND_STYLE, this->hand_style);
+    set_hand_paths(this);
     bUpdateTime = true;
   }
   
@@ -1314,21 +1936,24 @@ static void settings_received(void *watchface_window, Message const *message) {
     this->temperature_font_size = message->temperature_font_size;
     persist_write_int(MESSAGE_KEY_TEMPERATURE_SIZE, this->temperature_font_size);
     this->font_temperature = get_weather_font(this);
-    text_layer_set_font(this->temperature_text_layer, this->font_temperature);
+    mark_complication_dirty(this, LAYOUT_TEMPERATURE, REDRAW_CAUSE);
   }
   
   if (this->bg_color != message->bg_color) {
     this->bg_color = message->bg_color;
     persist_write_int(MESSAGE_KEY_BG_COLOR, this->bg_color);
     this->color_background = GColorFromHEX(message->bg_color);
-    layer_mark_dirty(this->background_layer);
+    direct_draw_snapshot_invalidate(&this->dial);
+    REDRAW_MARK_DIRTY(this->background_layer, REDRAW_CAUSE);
   }
   
   if (this->fg1_color != message->fg1_color) {
     this->fg1_color = message->fg1_color;
     persist_write_int(MESSAGE_KEY_FG1_COLOR, this->fg1_color);
     this->color_foreground_1 = GColorFromHEX(message->fg1_color);
-    layer_mark_dirty(this->background_layer);
+    direct_draw_snapshot_invalidate(&this->dial);
+    REDRAW_MARK_DIRTY(this->background_layer, REDRAW_CAUSE);
+    mark_all_complications_dirty(this, REDRAW_CAUSE);
     bUpdateWeather = true;
 
     update_date(watchface_window);
@@ -1375,33 +2000,94 @@ static void settings_received(void *watchface_window, Message const *message) {
   if (bUpdateTapSensor && TAP_SENSOR_NEEDED(this->seconds_hand_mode)) {
     tap_service_subscribe(this);
   }
+  update_motion_detector(watchface_window);
  
 }
 
-static void set_clay_message(Message *message)
+static void set_clay_message(Message *message, WatchfaceWindow const *this)
 // In the original HTML based settings code, we set our settings messsage with a message type.
 //  However, so far, I have not found a unique way to flag CLAY based settings, so anytime we get a Clay based setting,
 //  we flag this message as having come from Clay.
+//
+// The phone only sends the settings that changed, so the first settings key starts the message off with the
+// current values.  Anything it did not send then reads as unchanged.  Call this before storing the key's value.
 {
+  if (message->message_type == MESSAGE_TYPE_SETTINGS) {
+    return;
+  }
   message->message_type = MESSAGE_TYPE_SETTINGS;  
+  message->seconds_hand_mode = this->seconds_hand_mode;
+  message->temperature_units = this->temperature_units;
+  message->vibrate_on_bluetooth_disconnect = this->vibrate_on_bluetooth_disconnect;
+  message->show_battery_at_percent = this->show_battery_at_percent;
+  message->hand_style = this->hand_style;
+  message->bg_color = this->bg_color;
+  message->fg1_color = this->fg1_color;
+  message->fg2_color = this->fg2_color;
+  message->fg3_color = this->fg3_color;
+  message->temperature_font_size = this->temperature_font_size;
+  message->weather_quiet_time = this->weather_quiet_time;
+  message->weather_quiet_time_start = this->weather_quiet_time_start;
+  message->weather_quiet_time_stop = this->weather_quiet_time_stop;
+  message->seconds_hand_duration = this->seconds_hand_duration;
+  message->weather_source = this->weather_source;
+  message->show_timezone = this->show_timezone;
 }
 
   
+// The phone asked for the event log, oldest entry first.
+static void event_log_requested(void *watchface_window) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
+  EventLogEntry entries[EVENT_LOG_ENTRIES];
+  int count = event_log_read(entries);
+  DictionaryIterator *iterator;
+  AppMessageResult result;
+
+  if ((result = app_message_outbox_begin(&iterator)) != APP_MSG_OK) {
+    log_reason("unable to begin outbox for event log", result);
+    radio_stats_outcome(RADIO_BEGIN_FAILED);
+    return;
+  }
+  dict_write_int32(iterator, KEY_MESSAGE_TYPE, MESSAGE_TYPE_EVENT_LOG);
+  dict_write_data(iterator, KEY_EVENT_LOG, (uint8_t const *)entries, count * sizeof(entries[0]));
+  count_seconds_redraws_saved(this);
+  dict_write_uint32(iterator, KEY_SECONDS_REDRAWS_SAVED, this->seconds_redraws_saved);
+  radio_stats_sent(MESSAGE_TYPE_EVENT_LOG, dict_write_end(iterator));
+  if ((result = app_message_outbox_send()) != APP_MSG_OK) {
+    log_reason("unable to send event log", result);
+    radio_stats_send_failed(result);
+  }
+}
+
 static void outbox_sent(DictionaryIterator *iterator, void *context) {
-  //APP_LOG(APP_LOG_LEVEL_DEBUG, "outbox sent");
+  //LOG_DEBUG("outbox sent");
+  radio_stats_outcome(RADIO_SENT);
 }
 
 
 
 
-static void outbox_failed(DictionaryIterator *iterator, AppMessageResult reason, void *context) {
+static void outbox_failed(DictionaryIterator *iterator, AppMessageResult reason, void *watchface_window) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
+
+  Tuple *type = dict_find(iterator, KEY_MESSAGE_TYPE);
+  Tuple *id = dict_find(iterator, KEY_MESSAGE_ID);
+
   log_reason("outbox failed to send", reason);
+  // Only weather requests are round trips.  The event log going out is not one.
+  if (type && type->value->int32 == MESSAGE_TYPE_WEATHER && id) {
+    round_trip_send_failed(&this->round_trip, id->value->int32, reason);
+  }
+  radio_stats_send_failed(reason);
 }
 
 
 static void inbox_received(DictionaryIterator *iterator, void *watchface_window) {
+  WatchfaceWindow *this = window_get_user_data(watchface_window);
   Message message;
+  ALLOC_TRACE_BEGIN();
   memset(&message, 0xff, sizeof(message));
+  message.size = dict_size(iterator);
 
   for (Tuple *tuple = dict_read_first(iterator); tuple != NULL; tuple = dict_read_next(iterator)) {
 
@@ -1421,76 +2107,93 @@ static void inbox_received(DictionaryIterator *iterator, void *watchface_window)
       case KEY_IS_DAYLIGHT:
         message.is_daylight = tuple->value->int32;
         break;
+      case KEY_FORECAST:
+        message.forecast = tuple->value->data;
+        message.forecast_length = tuple->length;
+        break;
+      case KEY_FORECAST_START:
+        message.forecast_start = tuple->value->int32;
+        break;
+      case KEY_LATITUDE:
+        message.latitude = tuple->value->int32;
+        break;
+      case KEY_LONGITUDE:
+        message.longitude = tuple->value->int32;
+        break;
+      case KEY_ERROR_KIND:
+        message.error_kind = tuple->value->int32;
+        break;
       case MESSAGE_KEY_SHOW_SECONDS_HAND:
+        set_clay_message(&message, this);
         message.seconds_hand_mode = atoi(tuple->value->cstring);
-        set_clay_message(&message);
         break;
      case MESSAGE_KEY_SECONDS_HAND_DURATION:
+        set_clay_message(&message, this);
         message.seconds_hand_duration = tuple->value->int32;
-        set_clay_message(&message);
         break;
       case MESSAGE_KEY_TEMPERATURE_UNITS:
+        set_clay_message(&message, this);
         message.temperature_units = atoi(tuple->value->cstring);
-        set_clay_message(&message);
         break;
       case MESSAGE_KEY_VIBRATE_ON_BLUETOOTH_DISCONNECT:
+        set_clay_message(&message, this);
         message.vibrate_on_bluetooth_disconnect = tuple->value->int32;
-        set_clay_message(&message);
       break;
       case MESSAGE_KEY_SHOW_TIMEZONE:
+        set_clay_message(&message, this);
         message.show_timezone = tuple->value->int32;
-        set_clay_message(&message);
       break;
       case MESSAGE_KEY_SHOW_BATTERY_AT_PERCENT:
+        set_clay_message(&message, this);
         message.show_battery_at_percent = tuple->value->int32;
-        set_clay_message(&message);
         break;
       case MESSAGE_KEY_HAND_STYLE:
+        set_clay_message(&message, this);
         message.hand_style = atoi(tuple->value->cstring);
-        set_clay_message(&message);
         break;
       case MESSAGE_KEY_TEMPERATURE_SIZE:
+        set_clay_message(&message, this);
         message.temperature_font_size = atoi(tuple->value->cstring);
-        set_clay_message(&message);
         break;
       case MESSAGE_KEY_BG_COLOR:
+        set_clay_message(&message, this);
         message.bg_color = tuple->value->uint32;
-        set_clay_message(&message);
         break;    
       case MESSAGE_KEY_FG1_COLOR:
+        set_clay_message(&message, this);
         message.fg1_color = tuple->value->uint32;
-        set_clay_message(&message);
         break;    
       case MESSAGE_KEY_FG2_COLOR:
+        set_clay_message(&message, this);
         message.fg2_color = tuple->value->uint32;
-        set_clay_message(&message);
         break;    
       case MESSAGE_KEY_FG3_COLOR:
+        set_clay_message(&message, this);
         message.fg3_color = tuple->value->uint32;
-        set_clay_message(&message);
         break;    
       case MESSAGE_KEY_WEATHER_QUIET_TIME:
+        set_clay_message(&message, this);
         message.weather_quiet_time = tuple->value->int32;
-        set_clay_message(&message);
         break;   
       case MESSAGE_KEY_WEATHER_QUIET_TIME_START:
+        set_clay_message(&message, this);
         message.weather_quiet_time_start = tuple->value->int32;
-        set_clay_message(&message);
         break;
       case MESSAGE_KEY_WEATHER_QUIET_TIME_STOP:
+        set_clay_message(&message, this);
         message.weather_quiet_time_stop = tuple->value->int32;
-        set_clay_message(&message);
         break;
       case MESSAGE_KEY_WEATHER_SOURCE:
+        set_clay_message(&message, this);
         message.weather_source = atoi(tuple->value->cstring);
-        set_clay_message(&message);
         break;
       default:
-        APP_LOG(APP_LOG_LEVEL_ERROR, "Application received unknown key: %lu", tuple->key);
+        LOG_ERROR("Application received unknown key: %lu", tuple->key);
         break;
     }
   }
 
+  radio_stats_received(message.message_type, message.size);
   switch (message.message_type) {
     case MESSAGE_TYPE_READY:
       ready_received(watchface_window);
@@ -1501,21 +2204,29 @@ static void inbox_received(DictionaryIterator *iterator, void *watchface_window)
     case MESSAGE_TYPE_SETTINGS:
        settings_received(watchface_window, &message);
        break;
+    case MESSAGE_TYPE_EVENT_LOG:
+      event_log_requested(watchface_window);
+      break;
+    case MESSAGE_TYPE_ERROR:
+      error_received(watchface_window, &message);
+      break;
     default:
-      APP_LOG(APP_LOG_LEVEL_ERROR, "Application received message of unknown type: %d ", message.message_type);
+      LOG_ERROR("Application received message of unknown type: %d ", message.message_type);
       break;
   }
+  ALLOC_TRACE_END();
 }
 
 Window *watchface_window_create() {
   Window *watchface_window = window_create();
 
-  WatchfaceWindow *this = malloc(sizeof(*this));
+  // Static rather than on the heap, which on aplite is short enough as it is.  There is only ever one.
+  static WatchfaceWindow s_watchface;
+  WatchfaceWindow *this = &s_watchface;
   *this = (__typeof(*this)) {
     // IMPORTANT: Keep default values in sync with watchface_window.js.
     .seconds_hand_mode = persist_read_int_or_default(MESSAGE_KEY_SHOW_SECONDS_HAND, SECONDS_HAND_OFF),
     .seconds_hand_duration = persist_read_int_or_default(MESSAGE_KEY_SECONDS_HAND_DURATION, 2 ),
-    .seconds_duration_timer = NULL,
     .most_recent_tap = 0,
     
     .temperature_units = persist_read_int_or_default(MESSAGE_KEY_TEMPERATURE_UNITS, TEMPERATURE_UNITS_FAHRENHEIT),
@@ -1536,41 +2247,55 @@ Window *watchface_window_create() {
     .font_hours = NULL,
     .font_date = NULL,
     .font_temperature = NULL,
+#if FEATURE_SMALL_TEMPERATURE_FONT
     .font_temperature_small = NULL,
+#endif
     .font_condition = NULL,
     .font_battery = NULL,
     .font_bluetooth = NULL,
 
     .background_layer = NULL,
 
-    .date_text_layer = NULL,
+    .complications_layer = NULL,
+    .dirty_complications = 0,
     .date_text = "",
-
-    .temperature_text_layer = NULL,
     .temperature_text = "",
-
-    .condition_text_layer = NULL,
     .condition_text = "",
-
-    .battery_layer = NULL,
-    .battery_text_layer = NULL,
     .battery_text = "",
-
-    .bluetooth_text_layer = NULL,
     .bluetooth_text = "",
     
     .show_timezone = persist_read_bool_or_default(MESSAGE_KEY_SHOW_TIMEZONE, false),
-    .timezone_text_layer = NULL,
+#if FEATURE_TIMEZONE
     .timezone_text = "",
+#endif
 
     .hands_layer = NULL,
     .second_hand_layer = NULL,
 
-    .weather_update_timer = NULL,
     .weather_update_backoff_interval = -1,
     .expected_weather_message_id = 0,
+
+    .condition_code = CONDITION_CODE_NONE,
+    .has_location = false,
   };
+  if (persist_exists(PERSIST_KEY_FORECAST)) {
+    persist_read_data(PERSIST_KEY_FORECAST, &this->forecast, sizeof(this->forecast));
+  }
+  if (persist_exists(PERSIST_KEY_LOCATION)) {
+    this->has_location = persist_read_data(PERSIST_KEY_LOCATION, &this->location, sizeof(this->location)) == sizeof(this->location);
+    update_solar_day(this, local_time_peek());
+  }
+  scheduler_init(&this->scheduler, watchface_window);
+  event_log_load(PERSIST_KEY_EVENT_LOG);
+  frame_time_load(PERSIST_KEY_FRAME_TIMES);
+  radio_stats_load(PERSIST_KEY_RADIO_STATS);
+  this->seconds_redraws_saved = persist_read_int(PERSIST_KEY_SECONDS_REDRAWS_SAVED);
+  this->seconds_redraws_saved_at_save = this->seconds_redraws_saved;
+  event_log_add(EVENT_LAUNCH, 0);
+  startup_profile_mark(STARTUP_PHASE_SETTINGS);
   window_set_user_data(watchface_window, this);
+  // The scene is drawn in full by our own layers, and left alone on ticks that only move the second hand.
+  window_set_background_color(watchface_window, GColorClear);
 
   window_set_window_handlers(watchface_window, (WindowHandlers) {
     .load = watchface_window_load,
@@ -1585,6 +2310,7 @@ Window *watchface_window_create() {
   app_message_register_outbox_failed(outbox_failed);
  //app_message_open(app_message_inbox_size_maximum(), app_message_outbox_size_maximum());
    app_message_open(1000,1000);
+  startup_profile_mark(STARTUP_PHASE_APP_MESSAGE);
 
   g_watchface_window = watchface_window;
   return watchface_window;
@@ -1593,10 +2319,14 @@ Window *watchface_window_create() {
 void watchface_window_destroy(Window *watchface_window) {
   g_watchface_window = NULL;
 
-  app_message_deregister_callbacks();
+  event_log_save();
+  frame_time_save();
+  radio_stats_save();
+  save_seconds_redraws_saved(window_get_user_data(watchface_window));
+  // In case the weather never came.
+  startup_profile_save(PERSIST_KEY_STARTUP_PROFILES);
 
-  WatchfaceWindow *this = window_get_user_data(watchface_window);
-  free(this);
+  app_message_deregister_callbacks();
 
   window_destroy(watchface_window);
 }
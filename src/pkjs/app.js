@@ -1,32 +1,32 @@
 /*jslint sub: true*/
 
-// Import the Clay package
-var Clay = require('pebble-clay');
-// Load our Clay configuration file
-var clayConfig = require('./config');
-// Initialize Clay
-var clay = new Clay(clayConfig);
+// First thing, so the time to ready covers loading everything below.
+var launchTime = Date.now();
+
+// Weather providers and the logic for picking between them
+var providers = require('./providers');
+// Counts what we send and receive
+var radio = require('./radio');
+// Sends to the watch, retrying until it acknowledges
+var outbox = require('./outbox');
 
 // Message types.
 var MESSAGE_TYPE_READY = 0;
 var MESSAGE_TYPE_WEATHER = 1;
 var MESSAGE_TYPE_SETTINGS = 2;
+var MESSAGE_TYPE_EVENT_LOG = 3;
+var MESSAGE_TYPE_ERROR = 4;
+var MESSAGE_TYPE_NAMES = ["ready", "weather", "settings", "event log", "error"];
 
 // Temperature units.
 var TEMPERATURE_UNITS_CELSIUS = 0;
 var TEMPERATURE_UNITS_FAHRENHEIT = 1;
 
-var WEATHER_SOURCE_OPENWEATHERMAP = 1;
-var WEATHER_SOURCE_YAHOO = 2;
-
-function sendXhr(url, http_method, callback) {
-  var xhr = new XMLHttpRequest();
-  xhr.onload = function () {
-    callback(this.responseText);
-  };
-  xhr.open(http_method, url);
-  xhr.send();
-}
+// Hourly forecast pushed to the watch.  Each slot is 3 bytes: the condition code as a little endian uint16 with
+// the top bit set for daylight, then the temperature as an int8.  Keep in sync with watchface_window.c.
+var FORECAST_SLOTS = 12;
+var FORECAST_DAYLIGHT_FLAG = 0x8000;
+var FORECAST_TEMPERATURE_UNKNOWN = -128;
 
 function parseTemperature(temperature, actualTemperatureUnits, requestedTemperatureUnits) {
   temperature = parseInt(temperature, 10);
@@ -45,7 +45,7 @@ function parseTemperature(temperature, actualTemperatureUnits, requestedTemperat
   }
 
   if (actualTemperatureUnits != "F") {
-    console.log("Yahoo Weather API returned temperature in unknown units: " + actualTemperatureUnits);
+    console.log("Weather provider returned temperature in unknown units: " + actualTemperatureUnits);
     return 1 << 31;
   }
 
@@ -60,123 +60,346 @@ function parseTemperature(temperature, actualTemperatureUnits, requestedTemperat
   }
 }
 
-function parseTime(dateValue, timeString) {
-  var dateTime = new Date(dateValue);
-  var match = timeString.match(/(\d+):(\d+)\s*(am|pm)?/);
+function readFromLocalStorage(key, defaultValue) {
+  var value = localStorage.getItem(key);
+  return value === null ? defaultValue : JSON.parse(value);
+}
 
-  dateTime.setHours(parseInt(match[1], 10));
-  switch (match[3].toLowerCase()) {
-    case 'am':
-      if (dateTime.getHours() == 12) {
-        dateTime.setHours(0);
-      }
-      break;
-    case 'pm':
-      if (dateTime.getHours() != 12) {
-        dateTime.setHours(dateTime.getHours() + 12);
-      }
-      break;
-    default:
-      // No correction needed.
+function writeToLocalStorage(key, value) {
+  localStorage.setItem(key, JSON.stringify(value));
+}
+
+// The watch works out sunrise and sunset itself from our position, in 1/10000 of a degree.  It keeps the last
+// one it was given, so only send it once per session and again if we move far enough to matter.
+var LOCATION_SCALE = 10000;
+var LOCATION_RESEND_DELTA = 0.1 * LOCATION_SCALE;
+var sentLocation = null;
+
+function locationToSend(position) {
+  var location = {
+    latitude: Math.round(position.coords.latitude * LOCATION_SCALE),
+    longitude: Math.round(position.coords.longitude * LOCATION_SCALE)
+  };
+
+  if (sentLocation &&
+      Math.abs(location.latitude - sentLocation.latitude) < LOCATION_RESEND_DELTA &&
+      Math.abs(location.longitude - sentLocation.longitude) < LOCATION_RESEND_DELTA) {
+    return null;
   }
+  return location;
+}
+
+function packForecast(hourly, temperatureUnits) {
+  var nowseconds = Date.now() / 1000;
+  var bytes = [];
+  var start = 0;
 
-  dateTime.setMinutes(parseInt(match[2], 10));
-  dateTime.setSeconds(0);
+  // Skip slots that have already ended.
+  hourly = hourly.filter(function(slot) { return slot.time + 60 * 60 > nowseconds; }).slice(0, FORECAST_SLOTS);
+  hourly.forEach(function(slot, i) {
+    var code = slot.conditionCode | (slot.isDaylight ? FORECAST_DAYLIGHT_FLAG : 0);
+    var temperature = Math.round(parseTemperature(slot.temperature, slot.temperatureUnits, temperatureUnits));
 
-  return dateTime.valueOf();
+    if (!(temperature > FORECAST_TEMPERATURE_UNKNOWN && temperature <= 127)) {
+      temperature = FORECAST_TEMPERATURE_UNKNOWN;
+    }
+    if (i === 0) {
+      start = slot.time;
+    }
+    bytes.push(code & 0xff, (code >> 8) & 0xff, temperature & 0xff);
+  });
+  return { start: start, bytes: bytes };
 }
 
-function readFromLocalStorage(key, defaultValue) {
-  var value = localStorage.getItem(key);
-  return value === null ? defaultValue : JSON.parse(value);
+// Where the time goes for one weather request, from the watch asking until the watch has the answer.
+function logWeatherTiming(timing) {
+  console.log("Weather timing: position " + (timing.positionTime - timing.startTime) + "ms, " +
+              "request " + timing.requestMs + "ms, parse " + timing.parseMs + "ms (" + timing.responseBytes + " bytes), " +
+              "build " + (timing.sendTime - timing.resultTime) + "ms, delivery " + (timing.ackTime - timing.sendTime) + "ms, " +
+              "total " + (timing.ackTime - timing.startTime) + "ms");
 }
 
-function writeToLocalStorage(key, value) {
-  localStorage.setItem(key, JSON.stringify(value));
+// Weather and weather errors answer the same request, so a newer one of either replaces an older one not yet sent.
+var WEATHER_SLOT = "weather";
+
+// Tell the watch why there is no weather, so it can stop retrying instead of waiting out its timer.
+function sendWeatherError(messageId, error) {
+  console.log("Unable to get weather: " + error);
+  outbox.send("error", {
+    'KEY_MESSAGE_TYPE': MESSAGE_TYPE_ERROR,
+    'KEY_MESSAGE_ID': messageId,
+    'KEY_ERROR_KIND': error.kind || providers.ERROR_PROVIDER
+  }, { slot: WEATHER_SLOT, id: messageId });
 }
 
-function queryWeather(messageId, temperatureUnits, weatherSource, position) {
+function queryWeather(messageId, temperatureUnits, weatherSource, timing, position) {
+  timing.positionTime = Date.now();
 
-  var url;
-  var myAPIKey = '31196cb8a000e808be9f27de97a6f2e1';
-  if (weatherSource == WEATHER_SOURCE_YAHOO)
-  {
-    var query = encodeURIComponent('select astronomy, item.condition, units.temperature from weather.forecast where woeid in (select place.woeid from flickr.places where api_key="a4cd191f6a5f639df681211751f8c74e" AND lat="' + position.coords.latitude + '" AND lon="' + position.coords.longitude + '")');
-    url = 'https://query.yahooapis.com/v1/public/yql?q=' + query + '&format=json';
-    console.log ("requesting "+url);
-  
-    sendXhr(url, 'GET', function(responseText) {
-      var responseJson = JSON.parse(responseText);
-      var channel = responseJson.query.results.channel;
-      var now = Date.now();
-  
-      Pebble.sendAppMessage({
-        'KEY_MESSAGE_TYPE': MESSAGE_TYPE_WEATHER,
-        'KEY_MESSAGE_ID': messageId,
-        'KEY_CONDITION_CODE': parseInt(channel.item.condition.code, 10),
-        'KEY_TEMPERATURE': parseTemperature(channel.item.condition.temp, channel.units.temperature, temperatureUnits),
-        'KEY_IS_DAYLIGHT': +(parseTime(now, channel.astronomy.sunrise) <= now && now <= parseTime(now, channel.astronomy.sunset))
-      });
-    });
-  } else {  // default to using OpenWeatherMap
-     // Construct URL
-    url = 'http://api.openweathermap.org/data/2.5/weather?lat=' +
-        position.coords.latitude + '&lon=' + position.coords.longitude + '&appid=' + myAPIKey;
-  
-    // Send request to OpenWeatherMap
-    sendXhr(url, 'GET', 
-      function(responseText) {
-        // responseText contains a JSON object with weather info
-        var json = JSON.parse(responseText);
-        var nowseconds = Date.now() / 1000;  // now returns in ms, but OpenWeatherMap returns sunrise and sunset in seconds.
-        var sunrise = parseInt(json.sys.sunrise);
-        var sunset = parseInt(json.sys.sunset);
-        
-        Pebble.sendAppMessage({
-          'KEY_MESSAGE_TYPE': MESSAGE_TYPE_WEATHER,
-          'KEY_MESSAGE_ID': messageId,
-          'KEY_CONDITION_CODE': parseInt(json.weather[0].id, 10),
-          'KEY_TEMPERATURE': parseTemperature(json.main.temp, "K", temperatureUnits),
-          'KEY_IS_DAYLIGHT': +(sunrise <= nowseconds && nowseconds <= sunset)
-         
-        });
-  
-      }      
-    );
-      
+  providers.fetchWeather(position, weatherSource, function(error, result, provider, providerTiming) {
+    if (error) {
+      sendWeatherError(messageId, error);
+      return;
+    }
+    try {
+      sendWeather(messageId, temperatureUnits, timing, position, result, provider, providerTiming);
+    } catch (e) {
+      sendWeatherError(messageId, providers.weatherError(providers.ERROR_PROVIDER, "unable to use weather: " + e));
+    }
+  });
+}
+
+function sendWeather(messageId, temperatureUnits, timing, position, result, provider, providerTiming) {
+  console.log("Weather provided by " + provider.id);
+  timing.resultTime = Date.now();
+  timing.requestMs = providerTiming.requestMs;
+  timing.parseMs = providerTiming.parseMs;
+  timing.responseBytes = providerTiming.responseBytes;
+
+  var message = {
+    'KEY_MESSAGE_TYPE': MESSAGE_TYPE_WEATHER,
+    'KEY_MESSAGE_ID': messageId,
+    'KEY_CONDITION_CODE': result.conditionCode,
+    'KEY_TEMPERATURE': parseTemperature(result.temperature, result.temperatureUnits, temperatureUnits),
+    'KEY_IS_DAYLIGHT': +result.isDaylight
+  };
+
+  // The watch walks through the forecast on its own and only asks again when it runs low.
+  if (result.hourly) {
+    var forecast = packForecast(result.hourly, temperatureUnits);
+    if (forecast.bytes.length > 0) {
+      message['KEY_FORECAST_START'] = forecast.start;
+      message['KEY_FORECAST'] = forecast.bytes;
+    }
+  }
+
+  var location = locationToSend(position);
+  if (location) {
+    message['KEY_LATITUDE'] = location.latitude;
+    message['KEY_LONGITUDE'] = location.longitude;
   }
+
+  timing.sendTime = Date.now();
+  outbox.send("weather", message, {
+    slot: WEATHER_SLOT,
+    id: messageId,
+    ack: function() {
+      if (location) {
+        sentLocation = location;
+      }
+      timing.ackTime = Date.now();
+      logWeatherTiming(timing);
+    }
+  });
 }
 
-function onPositionError(error) {
+function onPositionError(messageId, error) {
   // TODO(maksym): Report geolocation request failure in settings.
-  console.log("Failed to obtain geographical location.");
+  sendWeatherError(messageId, providers.weatherError(providers.ERROR_NO_LOCATION,
+                                                     "failed to obtain geographical location: " + error.message));
 }
 
 function sendWeatherRequest(messageID, temperatureUnits, weatherSource) {
   // KH:  Looked into Sean's suggestion to be notified of position updates instead of polling, but that
   //  appeared to use more battery as the updates were constantly coming in.
-  navigator.geolocation.getCurrentPosition(queryWeather.bind(null, messageID, temperatureUnits, weatherSource), onPositionError, {
+  var timing = { startTime: Date.now() };
+
+  navigator.geolocation.getCurrentPosition(queryWeather.bind(null, messageID, temperatureUnits, weatherSource, timing), onPositionError.bind(null, messageID), {
     timeout: 15000,
     maximumAge: 1000 * 60 * 60 * 8
   });
 
 }
 
+// The watch keeps a binary log of recent events in 8 byte entries: seconds since the epoch as a little endian
+// uint32, the event id as a uint16 and an int16 argument.  Keep in sync with event_log.h.
+var EVENT_LOG_ENTRY_BYTES = 8;
+var EVENT_NAMES = [
+  null,
+  "launch",
+  "weather requested",
+  "weather received",
+  "send failed",
+  "bluetooth",
+  "settings received",
+  "restart",
+  "weather deferred",
+  "weather error",
+  "weather polling stopped"
+];
+
+function logEventLog(bytes, secondsRedrawsSaved) {
+  if (secondsRedrawsSaved !== undefined) {
+    console.log("Second hand redraws saved while the watch was still: " + secondsRedrawsSaved);
+  }
+  console.log("Watch event log, " + bytes.length / EVENT_LOG_ENTRY_BYTES + " entries:");
+  for (var i = 0; i + EVENT_LOG_ENTRY_BYTES <= bytes.length; i += EVENT_LOG_ENTRY_BYTES) {
+    var time = (bytes[i] | (bytes[i + 1] << 8) | (bytes[i + 2] << 16) | (bytes[i + 3] << 24)) >>> 0;
+    var id = bytes[i + 4] | (bytes[i + 5] << 8);
+    var arg = ((bytes[i + 6] | (bytes[i + 7] << 8)) << 16) >> 16;
+    console.log("  " + new Date(time * 1000).toISOString() + " " + (EVENT_NAMES[id] || "event " + id) + " " + arg);
+  }
+}
+
+// Clay and our config are only needed once the settings page is opened, so they are loaded then rather than at
+// launch, where they would hold up the ready message and with it the first weather.  We handle the config page
+// events ourselves so only changed settings go to the watch.
+var clay = null;
+
+function getClay() {
+  if (!clay) {
+    var loadTime = Date.now();
+    var Clay = require('pebble-clay');
+    clay = new Clay(require('./config'), null, { autoHandleEvents: false });
+    console.log("Clay loaded in " + (Date.now() - loadTime) + "ms");
+  }
+  return clay;
+}
+
+// How long from launch until we told the watch we are ready, and until it acknowledged, over the last few launches.
+var READY_TIMES_STORAGE_KEY = 'readyTimes';
+var READY_TIMES_KEPT = 10;
+
+function logReadyTime(readyMs, ackedMs) {
+  var times = readFromLocalStorage(READY_TIMES_STORAGE_KEY, []);
+  var total = 0;
+
+  times.push({ ready: readyMs, acked: ackedMs });
+  times = times.slice(-READY_TIMES_KEPT);
+  writeToLocalStorage(READY_TIMES_STORAGE_KEY, times);
+  times.forEach(function(time) {
+    total += time.acked;
+  });
+  console.log("Launch to ready " + readyMs + "ms, acknowledged at " + ackedMs + "ms (" +
+              Math.round(total / times.length) + "ms average over the last " + times.length + " launches)");
+}
+
+// Settings the watch has acknowledged, keyed by message key id.  Kept per watch, since each watch stores its own.
+function ackedSettingsKey() {
+  return 'ackedSettings.' + Pebble.getWatchToken();
+}
+
+// Only the settings that differ from what the watch last acknowledged.  The watch treats missing keys as unchanged.
+function changedSettings(settings, acked) {
+  var changed = {};
+  var count = 0;
+
+  Object.keys(settings).forEach(function(key) {
+    if (!acked.hasOwnProperty(key) || JSON.stringify(acked[key]) !== JSON.stringify(settings[key])) {
+      changed[key] = settings[key];
+      ++count;
+    }
+  });
+  return count > 0 ? changed : null;
+}
+
+// Sends settings and records them as acknowledged once they are.  nack, if given, hears when they could not be sent.
+function sendSettings(settings, nack) {
+  // Settings changed again before the last ones got through go out together.
+  outbox.send("settings", settings, {
+    merge: true,
+    ack: function() {
+      // Read again, since other settings may have been acknowledged while these were out.
+      var stored = readFromLocalStorage(ackedSettingsKey(), {});
+      Object.keys(settings).forEach(function(key) {
+        stored[key] = settings[key];
+      });
+      writeToLocalStorage(ackedSettingsKey(), stored);
+    },
+    nack: function(error) {
+      console.log("Failed to send settings: " + JSON.stringify(error));
+      if (nack) {
+        nack(error);
+      }
+    }
+  });
+}
+
+// The watch says in its answer to ready and in weather requests whether it has settings from us stored.  When it
+// has lost them, to a reinstall or a reset, what we recorded as acknowledged is no longer there, so forget it and
+// send all of it again.
+function checkSettingsStored(payload) {
+  if (!payload.hasOwnProperty('KEY_SETTINGS_STORED') || payload['KEY_SETTINGS_STORED']) {
+    return;
+  }
+  var acked = readFromLocalStorage(ackedSettingsKey(), {});
+  if (Object.keys(acked).length === 0) {
+    return;
+  }
+  console.log("Watch has no settings stored, sending all " + Object.keys(acked).length + " again");
+  writeToLocalStorage(ackedSettingsKey(), {});
+  sendSettings(acked, function() {
+    // Put back what did not get through, so the watch's next report tries again.
+    var stored = readFromLocalStorage(ackedSettingsKey(), {});
+    Object.keys(acked).forEach(function(key) {
+      if (!stored.hasOwnProperty(key)) {
+        stored[key] = acked[key];
+      }
+    });
+    writeToLocalStorage(ackedSettingsKey(), stored);
+  });
+}
+
+Pebble.addEventListener('showConfiguration', function(event) {
+  Pebble.openURL(getClay().generateUrl());
+});
+
+Pebble.addEventListener('webviewclosed', function(event) {
+  if (!event || !event.response) {
+    return;  // cancelled
+  }
+
+  var settings = getClay().getSettings(event.response);
+  var acked = readFromLocalStorage(ackedSettingsKey(), {});
+  var changed = changedSettings(settings, acked);
+
+  if (!changed) {
+    console.log("Settings unchanged, nothing to send");
+    return;
+  }
+  console.log("Sending " + Object.keys(changed).length + " of " + Object.keys(settings).length + " settings");
+  sendSettings(changed);
+});
+
 Pebble.addEventListener('ready', function(event) {
-  Pebble.sendAppMessage({
+  var readyMs = Date.now() - launchTime;
+
+  outbox.send("ready", {
     'KEY_MESSAGE_TYPE': MESSAGE_TYPE_READY
+  }, {
+    ack: function() {
+      logReadyTime(readyMs, Date.now() - launchTime);
+      // Set requestEventLog in localStorage to have the watch dump its event log on every launch.
+      if (readFromLocalStorage('requestEventLog', false)) {
+        outbox.send("event log", {
+          'KEY_MESSAGE_TYPE': MESSAGE_TYPE_EVENT_LOG
+        });
+      }
+    }
   });
+  // Set logRadioStats in localStorage to see the daily radio totals on every launch.
+  if (readFromLocalStorage('logRadioStats', false)) {
+    radio.logHistory();
+  }
 });
 
 Pebble.addEventListener('appmessage', function(event) {
   var messageType = event.payload['KEY_MESSAGE_TYPE'];
+  radio.received(MESSAGE_TYPE_NAMES[messageType] || "unknown", event.payload);
+  checkSettingsStored(event.payload);
   switch (messageType) {
+    case MESSAGE_TYPE_READY:
+      break;  // the watch answering ready when it needs no weather
     case MESSAGE_TYPE_WEATHER:
       //var str = JSON.stringify(event);
       //console.log("event = "+ str);
       console.log("PebbleKit JS sending weather request with with message id of " + event.payload['KEY_MESSAGE_ID'] + " and units of " + event.payload['TEMPERATURE_UNITS'] + "and weather source of " + event.payload['WEATHER_SOURCE']);
+      // The watch only takes the answer to its latest request.
+      outbox.cancel(WEATHER_SLOT);
       sendWeatherRequest(event.payload['KEY_MESSAGE_ID'], event.payload['TEMPERATURE_UNITS'], event.payload['WEATHER_SOURCE']);
       break;
+    case MESSAGE_TYPE_EVENT_LOG:
+      logEventLog(event.payload['KEY_EVENT_LOG'] || [], event.payload['KEY_SECONDS_REDRAWS_SAVED']);
+      break;
     default:
       console.log("PebbleKit JS received message of unknown type: " + messageType);
       break;
@@ -49,6 +49,10 @@ module.exports = [
             "label" : "Turn On Temporarily When Tapped",
             "value" : "5"
           },
+          {
+            "label" : "Only While Moving",
+            "value" : "7"
+          },
 
         ]
       },
@@ -56,7 +60,7 @@ module.exports = [
         "type": "slider",
         "messageKey": "SECONDS_HAND_DURATION",
         "defaultValue": 2,
-        "label": "How many minutes to keep showing seconds after tapping",
+        "label": "How many minutes to keep showing seconds after tapping or moving",
         "min": 1,
         "max": 60
         }
@@ -88,6 +92,7 @@ module.exports = [
            "type": "radiogroup",
            "messageKey": "TEMPERATURE_SIZE",
            "label": "Temperature Font Size",
+           "capabilities": ["NOT_PLATFORM_APLITE"],
            "defaultValue" : "2",
            "options": [
              { 
@@ -113,6 +118,10 @@ module.exports = [
              { 
                "label": "Yahoo", 
                "value": "2"
+             },
+             { 
+               "label": "Fastest Available", 
+               "value": "3"
              }
            ]
          },   
@@ -144,6 +153,7 @@ module.exports = [
           "type": "toggle",
           "messageKey": "SHOW_TIMEZONE",
           "label": "Show Current TimeZone",
+          "capabilities": ["NOT_PLATFORM_APLITE"],
           "defaultValue": false
         }
   
@@ -0,0 +1,163 @@
+/*jslint sub: true*/
+
+// Outbound AppMessages to the watch, one at a time, retried with backoff until the watch acknowledges them.
+//
+// Messages go in slots.  A slot holds at most one message waiting to go out, so a newer message replaces an older
+// one still waiting in the same slot; weather and weather errors share a slot, since either one answers the same
+// request.  A message can carry an id, and a message whose id the watch has already acknowledged in that slot is
+// dropped rather than sent again.  Messages whose keys add up, like settings, can be merged instead of replaced; one
+// that fails while a newer one waits to be merged hands that one whatever keys it lacks.
+//
+// Delivery latency and retries are counted per message type by radio.js.
+
+// Counts what we send
+var radio = require('./radio');
+
+var RETRY_BASE_MS = 500;
+var RETRY_MAX_MS = 16000;
+var MAX_RETRIES = 5;
+
+var queue = [];        // waiting to go out, oldest first
+var inFlight = null;   // sent and not yet acknowledged or failed
+var retryTimer = null;
+var ackedIds = {};     // slot to the id of the last message the watch acknowledged in it
+
+function entryIn(slot) {
+  for (var i = 0; i < queue.length; i++) {
+    if (queue[i].slot === slot) {
+      return queue[i];
+    }
+  }
+  return null;
+}
+
+function callAll(callbacks, event) {
+  callbacks.forEach(function(callback) {
+    callback(event);
+  });
+}
+
+function retryDelay(retries) {
+  return Math.min(RETRY_BASE_MS * Math.pow(2, retries - 1), RETRY_MAX_MS);
+}
+
+function sendNext() {
+  if (inFlight || retryTimer || queue.length === 0) {
+    return;
+  }
+
+  var entry = queue.shift();
+  inFlight = entry;
+  entry.sentTime = Date.now();
+  radio.sendAppMessage(entry.type, entry.message, function(event) {
+    inFlight = null;
+    if (entry.id !== undefined) {
+      ackedIds[entry.slot] = entry.id;
+    }
+    radio.delivered(entry.type, Date.now() - entry.queuedTime, entry.retries);
+    if (entry.retries > 0) {
+      console.log("Outbox: " + entry.type + " delivered after " + entry.retries + " retries, " +
+                  (Date.now() - entry.queuedTime) + "ms");
+    }
+    callAll(entry.acks, event);
+    sendNext();
+  }, function(event) {
+    var waiting = entryIn(entry.slot);
+    inFlight = null;
+    if (waiting && waiting.merge && !entry.cancelled) {
+      // Keys added to the slot while this one was out go with it, so only the keys they leave out are missing.
+      Object.keys(entry.message).forEach(function(key) {
+        if (!waiting.message.hasOwnProperty(key)) {
+          waiting.message[key] = entry.message[key];
+        }
+      });
+      waiting.acks = entry.acks.concat(waiting.acks);
+      waiting.nacks = entry.nacks.concat(waiting.nacks);
+      waiting.queuedTime = entry.queuedTime;
+    } else if (waiting || entry.cancelled) {
+      // Something newer for the same slot came along while this one was out, or the slot was cancelled.
+      radio.superseded(entry.type);
+      callAll(entry.nacks, { superseded: true });
+    } else if (entry.retries >= MAX_RETRIES) {
+      console.log("Outbox: giving up on " + entry.type + " after " + entry.retries + " retries: " +
+                  JSON.stringify(event && event.error));
+      radio.gaveUp(entry.type);
+      callAll(entry.nacks, event);
+    } else {
+      entry.retries++;
+      queue.unshift(entry);
+      retryTimer = setTimeout(function() {
+        retryTimer = null;
+        sendNext();
+      }, retryDelay(entry.retries));
+    }
+    sendNext();
+  });
+}
+
+// Queues message to go to the watch.  type names it in the radio totals.  options, all optional:
+//   slot   messages in the same slot replace each other while waiting; defaults to type
+//   id     drop the message if the watch has already acknowledged this id in the slot
+//   merge  merge into the waiting message in the slot, newer keys winning, rather than replace it
+//   ack    called once the watch acknowledges it
+//   nack   called if it is replaced or cannot be delivered, with { superseded: true } when replaced
+function send(type, message, options) {
+  options = options || {};
+  var slot = options.slot || type;
+
+  if (options.id !== undefined && ackedIds[slot] === options.id) {
+    console.log("Outbox: dropping " + type + " " + options.id + ", already acknowledged");
+    return;
+  }
+
+  var entry = {
+    type: type,
+    slot: slot,
+    id: options.id,
+    merge: !!options.merge,
+    message: message,
+    acks: options.ack ? [options.ack] : [],
+    nacks: options.nack ? [options.nack] : [],
+    queuedTime: Date.now(),
+    retries: 0
+  };
+
+  var waiting = entryIn(slot);
+  if (waiting) {
+    queue.splice(queue.indexOf(waiting), 1);
+    if (options.merge) {
+      Object.keys(message).forEach(function(key) {
+        waiting.message[key] = message[key];
+      });
+      entry.message = waiting.message;
+      entry.acks = waiting.acks.concat(entry.acks);
+      entry.nacks = waiting.nacks.concat(entry.nacks);
+      entry.queuedTime = waiting.queuedTime;
+    } else {
+      radio.superseded(waiting.type);
+      callAll(waiting.nacks, { superseded: true });
+    }
+  }
+  queue.push(entry);
+  sendNext();
+}
+
+// Forgets whatever is waiting in slot, when the watch has moved on and no longer wants it.  A message in the slot
+// already out is not retried if it fails.
+function cancel(slot) {
+  var waiting = entryIn(slot);
+
+  if (inFlight && inFlight.slot === slot) {
+    inFlight.cancelled = true;
+  }
+  if (waiting) {
+    queue.splice(queue.indexOf(waiting), 1);
+    radio.superseded(waiting.type);
+    callAll(waiting.nacks, { superseded: true });
+  }
+}
+
+module.exports = {
+  send: send,
+  cancel: cancel
+};
@@ -0,0 +1,394 @@
+/*jslint sub: true*/
+
+// Weather providers.
+//
+// Each provider knows how to build the request URL for a position and how to parse the response into a
+// normalized result, so app.js never has to care which service answered:
+//
+//   { conditionCode: <OpenWeatherMap condition id>, temperature: <number>, temperatureUnits: "K" | "F", isDaylight: <bool>,
+//     hourly: [ { time: <unix seconds>, conditionCode, temperature, temperatureUnits, isDaylight }, ... ] }
+//
+// hourly is only there for providers that can return a forecast in the same request.
+//
+// Condition codes are always normalized to the OpenWeatherMap ids (http://openweathermap.org/weather-conditions),
+// which is the only scheme the watch has to map to icons.
+
+// Counts request and response bytes
+var radio = require('./radio');
+
+var WEATHER_SOURCE_OPENWEATHERMAP = 1;
+var WEATHER_SOURCE_YAHOO = 2;
+var WEATHER_SOURCE_FASTEST = 3;
+
+// Why the weather could not be had, as reported to the watch.  Keep in sync with circuit_breaker.h.
+var ERROR_NO_LOCATION = 1;
+var ERROR_NO_NETWORK = 2;
+var ERROR_PROVIDER = 3;
+var ERROR_RATE_LIMITED = 4;
+
+var HTTP_TOO_MANY_REQUESTS = 429;
+
+// Errors handed to callbacks.  They read as their message when logged.
+function weatherError(kind, message) {
+  return {
+    kind: kind,
+    message: message,
+    toString: function() { return message; }
+  };
+}
+
+// How long to wait on the preferred provider before also asking the next best one.
+var HEDGE_DELAY_MS = 4000;
+var XHR_TIMEOUT_MS = 15000;
+
+// A provider that cannot return the hourly forecast costs the watch extra requests later on, so it has to be
+// about this much faster than one that can before it gets picked.
+var NO_FORECAST_PENALTY_MS = 10000;
+
+// Weight given to the newest sample in the latency and failure rate moving averages.
+var STATS_SMOOTHING = 0.3;
+var STATS_STORAGE_KEY = 'providerStats';
+
+// Set this in localStorage to a loopback URL serving OpenWeatherMap One Call shaped JSON to test and benchmark offline.
+var FIXTURE_URL_STORAGE_KEY = 'fixtureProviderUrl';
+
+var OWM_API_KEY = '31196cb8a000e808be9f27de97a6f2e1';
+var OWM_CONDITION_UNKNOWN = 999;
+
+// Yahoo condition code (https://developer.yahoo.com/weather/documentation.html#codes) to the closest
+// OpenWeatherMap id.  Picked so that the watch shows the same icon the old Yahoo mapping did.
+var YAHOO_TO_OWM_CONDITION = [
+  900, 901, 902, 212, 211, 616, 616, 611, 616, 300,  //  0 -  9
+  616, 521, 521, 600, 620, 601, 601, 906, 616, 761,  // 10 - 19
+  741, 721, 711, 905, 905, 903, 804, 804, 804, 802,  // 20 - 29
+  802, 800, 800, 800, 800, 500, 904, 210, 211, 211,  // 30 - 39
+  521, 602, 621, 602, 802, 201, 621, 210             // 40 - 47
+];
+
+function sendXhr(url, http_method, callback) {
+  var xhr = new XMLHttpRequest();
+  xhr.onload = function () {
+    var succeeded = this.status >= 200 && this.status < 300;
+    radio.xhrDone(url.length, this.responseText ? this.responseText.length : 0, !succeeded);
+    if (succeeded) {
+      callback(null, this.responseText);
+    } else {
+      callback(weatherError(this.status == HTTP_TOO_MANY_REQUESTS ? ERROR_RATE_LIMITED : ERROR_PROVIDER,
+                            "HTTP status " + this.status), this.responseText);
+    }
+  };
+  xhr.onerror = function () {
+    radio.xhrDone(url.length, 0, true);
+    callback(weatherError(ERROR_NO_NETWORK, "network error"), null);
+  };
+  xhr.ontimeout = function () {
+    radio.xhrDone(url.length, 0, true);
+    callback(weatherError(ERROR_NO_NETWORK, "timed out"), null);
+  };
+  xhr.open(http_method, url);
+  xhr.timeout = XHR_TIMEOUT_MS;
+  xhr.send();
+  return xhr;
+}
+
+function parseTime(dateValue, timeString) {
+  var dateTime = new Date(dateValue);
+  var match = timeString.match(/(\d+):(\d+)\s*(am|pm)?/);
+
+  dateTime.setHours(parseInt(match[1], 10));
+  switch (match[3].toLowerCase()) {
+    case 'am':
+      if (dateTime.getHours() == 12) {
+        dateTime.setHours(0);
+      }
+      break;
+    case 'pm':
+      if (dateTime.getHours() != 12) {
+        dateTime.setHours(dateTime.getHours() + 12);
+      }
+      break;
+    default:
+      // No correction needed.
+  }
+
+  dateTime.setMinutes(parseInt(match[2], 10));
+  dateTime.setSeconds(0);
+
+  return dateTime.valueOf();
+}
+
+function parseOpenWeatherMapCondition(weather) {
+  return parseInt(weather.id, 10);
+}
+
+function parseOpenWeatherMap(responseText) {
+  var json = JSON.parse(responseText);
+  var nowseconds = Date.now() / 1000;  // now returns in ms, but OpenWeatherMap returns sunrise and sunset in seconds.
+  var sunrise = parseInt(json.sys.sunrise, 10);
+  var sunset = parseInt(json.sys.sunset, 10);
+
+  return {
+    conditionCode: parseOpenWeatherMapCondition(json.weather[0]),
+    temperature: json.main.temp,
+    temperatureUnits: "K",
+    isDaylight: sunrise <= nowseconds && nowseconds <= sunset
+  };
+}
+
+// The One Call API returns current conditions plus 48 hourly slots in one request.
+function parseOpenWeatherMapOneCall(responseText) {
+  var json = JSON.parse(responseText);
+  var current = json.current;
+
+  return {
+    conditionCode: parseOpenWeatherMapCondition(current.weather[0]),
+    temperature: current.temp,
+    temperatureUnits: "K",
+    isDaylight: current.sunrise <= current.dt && current.dt <= current.sunset,
+    hourly: json.hourly.map(function(hour) {
+      return {
+        time: hour.dt,
+        conditionCode: parseOpenWeatherMapCondition(hour.weather[0]),
+        temperature: hour.temp,
+        temperatureUnits: "K",
+        isDaylight: /d$/.test(hour.weather[0].icon)   // icon ids end in 'd' for day and 'n' for night
+      };
+    })
+  };
+}
+
+function parseYahoo(responseText) {
+  var channel = JSON.parse(responseText).query.results.channel;
+  var now = Date.now();
+  var owmCode = YAHOO_TO_OWM_CONDITION[parseInt(channel.item.condition.code, 10)];
+
+  return {
+    conditionCode: owmCode === undefined ? OWM_CONDITION_UNKNOWN : owmCode,
+    temperature: channel.item.condition.temp,
+    temperatureUnits: channel.units.temperature,
+    isDaylight: parseTime(now, channel.astronomy.sunrise) <= now && now <= parseTime(now, channel.astronomy.sunset)
+  };
+}
+
+var openWeatherMapOneCallProvider = {
+  id: 'openweathermap-onecall',
+  source: WEATHER_SOURCE_OPENWEATHERMAP,
+  hasForecast: true,
+  url: function(position) {
+    return 'http://api.openweathermap.org/data/2.5/onecall?lat=' + position.coords.latitude +
+        '&lon=' + position.coords.longitude + '&exclude=minutely,daily,alerts&appid=' + OWM_API_KEY;
+  },
+  parse: parseOpenWeatherMapOneCall
+};
+
+var openWeatherMapProvider = {
+  id: 'openweathermap',
+  source: WEATHER_SOURCE_OPENWEATHERMAP,
+  hasForecast: false,
+  url: function(position) {
+    return 'http://api.openweathermap.org/data/2.5/weather?lat=' +
+        position.coords.latitude + '&lon=' + position.coords.longitude + '&appid=' + OWM_API_KEY;
+  },
+  parse: parseOpenWeatherMap
+};
+
+// Yahoo stopped working as of 8/23/2016.  Kept so it can still win if it ever comes back; the ranking keeps it
+// at the bottom while it keeps failing.
+var yahooProvider = {
+  id: 'yahoo',
+  source: WEATHER_SOURCE_YAHOO,
+  hasForecast: false,
+  url: function(position) {
+    var query = encodeURIComponent('select astronomy, item.condition, units.temperature from weather.forecast where woeid in (select place.woeid from flickr.places where api_key="a4cd191f6a5f639df681211751f8c74e" AND lat="' + position.coords.latitude + '" AND lon="' + position.coords.longitude + '")');
+    return 'https://query.yahooapis.com/v1/public/yql?q=' + query + '&format=json';
+  },
+  parse: parseYahoo
+};
+
+function fixtureProvider(baseUrl) {
+  return {
+    id: 'fixture',
+    source: null,
+    hasForecast: true,
+    url: function(position) {
+      return baseUrl + '?lat=' + position.coords.latitude + '&lon=' + position.coords.longitude;
+    },
+    parse: parseOpenWeatherMapOneCall
+  };
+}
+
+function availableProviders() {
+  var providers = [openWeatherMapOneCallProvider, openWeatherMapProvider, yahooProvider];
+  var fixtureUrl = localStorage.getItem(FIXTURE_URL_STORAGE_KEY);
+
+  if (fixtureUrl) {
+    providers.push(fixtureProvider(fixtureUrl));
+  }
+  return providers;
+}
+
+function readStats() {
+  var value = localStorage.getItem(STATS_STORAGE_KEY);
+  return value === null ? {} : JSON.parse(value);
+}
+
+// Failures that say nothing about the provider, like the phone being offline, are left out.
+function recordOutcome(providerId, latencyMs, error) {
+  if (error && error.kind === ERROR_NO_NETWORK) {
+    return;
+  }
+
+  var succeeded = !error;
+  var allStats = readStats();
+  var stats = allStats[providerId];
+
+  if (!stats) {
+    stats = allStats[providerId] = { latency: latencyMs, failureRate: succeeded ? 0 : 1, samples: 0 };
+  }
+  stats.latency += STATS_SMOOTHING * (latencyMs - stats.latency);
+  stats.failureRate += STATS_SMOOTHING * ((succeeded ? 0 : 1) - stats.failureRate);
+  stats.samples++;
+  localStorage.setItem(STATS_STORAGE_KEY, JSON.stringify(allStats));
+}
+
+// Expected time to a usable answer.  Each failure is charged as a request left to time out, so a provider that
+// fails one time in ten costs its latency plus a tenth of XHR_TIMEOUT_MS.  Providers we have never heard back from
+// sort first so that they get measured.
+function providerScore(provider, stats) {
+  var penalty = provider.hasForecast ? 0 : NO_FORECAST_PENALTY_MS;
+  if (!stats) {
+    return penalty;
+  }
+  return stats.latency + stats.failureRate * XHR_TIMEOUT_MS + penalty;
+}
+
+function rankProviders(providers) {
+  var allStats = readStats();
+  return providers.slice().sort(function(a, b) {
+    return providerScore(a, allStats[a.id]) - providerScore(b, allStats[b.id]);
+  });
+}
+
+// Starts providers[0] right away and each following provider after delaysMs[i], until one of them produces a
+// valid result.  The first valid result wins; requests already in flight are left to finish so their latency
+// still feeds the ranking, but their answers are dropped.
+function requestFirstValid(providers, delaysMs, position, callback) {
+  var finished = false;
+  var outstanding = providers.length;
+  var timers = [];
+  var lastError = null;
+
+  function start(provider) {
+    var startTime = Date.now();
+
+    sendXhr(provider.url(position), 'GET', function(error, responseText) {
+      var result = null;
+      var responseTime = Date.now();
+      var timing = {
+        requestMs: responseTime - startTime,
+        parseMs: 0,
+        responseBytes: responseText ? responseText.length : 0
+      };
+
+      if (!error) {
+        try {
+          result = provider.parse(responseText);
+        } catch (e) {
+          error = weatherError(ERROR_PROVIDER, "unable to parse response: " + e);
+        }
+        timing.parseMs = Date.now() - responseTime;
+      }
+      recordOutcome(provider.id, timing.requestMs, error);
+      outstanding--;
+
+      if (finished) {
+        return;
+      }
+      if (error) {
+        console.log("Weather provider " + provider.id + " failed: " + error);
+        lastError = error;
+        startNextNow();
+      } else {
+        finish(null, result, provider, timing);
+      }
+    });
+  }
+
+  function finish(error, result, provider, timing) {
+    finished = true;
+    timers.forEach(function(timer) {
+      if (timer) {
+        clearTimeout(timer);
+      }
+    });
+    callback(error, result, provider, timing);
+  }
+
+  // A failure should not wait out the hedge delay of whoever is next in line.
+  function startNextNow() {
+    for (var i = 0; i < timers.length; i++) {
+      if (timers[i]) {
+        clearTimeout(timers[i]);
+        timers[i] = null;
+        start(providers[i]);
+        return;
+      }
+    }
+    if (outstanding === 0) {
+      finish(lastError || weatherError(ERROR_PROVIDER, "no weather provider available"), null, null);
+    }
+  }
+
+  providers.forEach(function(provider, i) {
+    if (delaysMs[i] > 0) {
+      timers[i] = setTimeout(function() {
+        timers[i] = null;
+        start(provider);
+      }, delaysMs[i]);
+    } else {
+      timers[i] = null;
+      start(provider);
+    }
+  });
+}
+
+// callback(error, result, provider, timing) where timing has requestMs, parseMs and responseBytes for the winner.
+//
+// WEATHER_SOURCE_FASTEST races the two best ranked providers.  Otherwise the providers for the chosen source are
+// asked first, and the best ranked of the rest is hedged in, each one HEDGE_DELAY_MS after the one before.
+function fetchWeather(position, weatherSource, callback) {
+  var ranked = rankProviders(availableProviders());
+  var providers;
+  var delaysMs;
+
+  if (weatherSource == WEATHER_SOURCE_FASTEST) {
+    providers = ranked.slice(0, 2);
+    delaysMs = [0, 0];
+  } else {
+    var preferred = ranked.filter(function(provider) { return provider.source == weatherSource; });
+    var others = ranked.filter(function(provider) { return provider.source != weatherSource; });
+    if (preferred.length === 0) {
+      preferred = [openWeatherMapOneCallProvider];
+      others = others.filter(function(provider) { return provider !== openWeatherMapOneCallProvider; });
+    }
+    providers = preferred.concat(others.slice(0, 1));
+    delaysMs = providers.map(function(provider, i) { return i * HEDGE_DELAY_MS; });
+  }
+
+  requestFirstValid(providers, delaysMs, position, callback);
+}
+
+module.exports = {
+  fetchWeather: fetchWeather,
+  sendXhr: sendXhr,
+  parseOpenWeatherMap: parseOpenWeatherMap,
+  parseOpenWeatherMapOneCall: parseOpenWeatherMapOneCall,
+  weatherError: weatherError,
+  ERROR_NO_LOCATION: ERROR_NO_LOCATION,
+  ERROR_NO_NETWORK: ERROR_NO_NETWORK,
+  ERROR_PROVIDER: ERROR_PROVIDER,
+  ERROR_RATE_LIMITED: ERROR_RATE_LIMITED,
+  WEATHER_SOURCE_OPENWEATHERMAP: WEATHER_SOURCE_OPENWEATHERMAP,
+  WEATHER_SOURCE_YAHOO: WEATHER_SOURCE_YAHOO,
+  WEATHER_SOURCE_FASTEST: WEATHER_SOURCE_FASTEST
+};
@@ -0,0 +1,165 @@
+/*jslint sub: true*/
+
+// Radio traffic accounting on the phone side.  Every AppMessage to and from the watch is counted by message type
+// and outcome, and every weather request by bytes each way, in daily totals kept in localStorage.  Together with
+// radio_stats.c on the watch this says what a day of weather actually costs.  Messages sent through outbox.js are
+// also counted by how long they took to deliver and how often they had to be retried.
+//
+// AppMessage bytes are estimated the way the watch counts them, as the size of the dictionary: a one byte count,
+// then per key a 7 byte header (key, type and length) and the value.
+
+var STORAGE_KEY = 'radioStats';
+var HISTORY_DAYS = 7;
+var DICT_HEADER_BYTES = 1;
+var TUPLE_HEADER_BYTES = 7;
+var INT_BYTES = 4;
+
+function messageBytes(message) {
+  return Object.keys(message).reduce(function(bytes, key) {
+    var value = message[key];
+    if (typeof value === 'string') {
+      return bytes + TUPLE_HEADER_BYTES + unescape(encodeURIComponent(value)).length + 1;
+    }
+    if (Array.isArray(value)) {
+      return bytes + TUPLE_HEADER_BYTES + value.length;
+    }
+    return bytes + TUPLE_HEADER_BYTES + INT_BYTES;
+  }, DICT_HEADER_BYTES);
+}
+
+function dayKey(date) {
+  return date.getFullYear() + '-' + ('0' + (date.getMonth() + 1)).slice(-2) + '-' + ('0' + date.getDate()).slice(-2);
+}
+
+function emptyDay(day) {
+  return { day: day, sent: {}, received: {}, xhr: { requests: 0, failed: 0, bytesSent: 0, bytesReceived: 0 } };
+}
+
+function logDay(day) {
+  var line = "Radio " + day.day + ":";
+  Object.keys(day.sent).forEach(function(type) {
+    var sent = day.sent[type];
+    line += " sent " + type + " " + sent.messages + " (" + sent.bytes + " bytes, " + sent.acked + " acked, " +
+            sent.failed + " failed),";
+    if (sent.delivered) {
+      line += " delivered " + sent.delivered + " (" + Math.round(sent.latencyMs / sent.delivered) + "ms average, " +
+              sent.maxLatencyMs + "ms worst, " + sent.retries + " retries, " + (sent.superseded || 0) + " superseded, " +
+              (sent.gaveUp || 0) + " given up),";
+    }
+  });
+  Object.keys(day.received).forEach(function(type) {
+    var received = day.received[type];
+    line += " received " + type + " " + received.messages + " (" + received.bytes + " bytes),";
+  });
+  line += " weather requests " + day.xhr.requests + " (" + day.xhr.failed + " failed, " + day.xhr.bytesSent +
+          " bytes up, " + day.xhr.bytesReceived + " bytes down)";
+  console.log(line);
+}
+
+// Days oldest first, ending with today.  Changes made by update are written straight back.
+function update(change) {
+  var value = localStorage.getItem(STORAGE_KEY);
+  var days = value === null ? [] : JSON.parse(value);
+  var today = dayKey(new Date());
+
+  if (days.length === 0 || days[days.length - 1].day !== today) {
+    if (days.length > 0) {
+      logDay(days[days.length - 1]);
+    }
+    days.push(emptyDay(today));
+    days = days.slice(-HISTORY_DAYS);
+  }
+  change(days[days.length - 1]);
+  localStorage.setItem(STORAGE_KEY, JSON.stringify(days));
+}
+
+function counter(counters, type) {
+  if (!counters[type]) {
+    counters[type] = { messages: 0, bytes: 0, acked: 0, failed: 0 };
+  }
+  return counters[type];
+}
+
+// Pebble.sendAppMessage, counted.  type is a name for the message in the totals.
+function sendAppMessage(type, message, ack, nack) {
+  var bytes = messageBytes(message);
+
+  update(function(day) {
+    counter(day.sent, type).messages++;
+    counter(day.sent, type).bytes += bytes;
+  });
+  Pebble.sendAppMessage(message, function(event) {
+    update(function(day) { counter(day.sent, type).acked++; });
+    if (ack) {
+      ack(event);
+    }
+  }, function(event) {
+    update(function(day) { counter(day.sent, type).failed++; });
+    if (nack) {
+      nack(event);
+    }
+  });
+}
+
+// A message from outbox.js got through, latencyMs after it was queued and after retries failed attempts.
+function delivered(type, latencyMs, retries) {
+  update(function(day) {
+    var sent = counter(day.sent, type);
+    sent.delivered = (sent.delivered || 0) + 1;
+    sent.latencyMs = (sent.latencyMs || 0) + latencyMs;
+    sent.maxLatencyMs = Math.max(sent.maxLatencyMs || 0, latencyMs);
+    sent.retries = (sent.retries || 0) + retries;
+  });
+}
+
+// A message from outbox.js was replaced by a newer one before it got through.
+function superseded(type) {
+  update(function(day) {
+    var sent = counter(day.sent, type);
+    sent.superseded = (sent.superseded || 0) + 1;
+  });
+}
+
+// A message from outbox.js ran out of retries.
+function gaveUp(type) {
+  update(function(day) {
+    var sent = counter(day.sent, type);
+    sent.gaveUp = (sent.gaveUp || 0) + 1;
+  });
+}
+
+function received(type, message) {
+  var bytes = messageBytes(message);
+
+  update(function(day) {
+    counter(day.received, type).messages++;
+    counter(day.received, type).bytes += bytes;
+  });
+}
+
+// A weather request went out with bytesSent of URL and body and came back with bytesReceived, or failed.
+function xhrDone(bytesSent, bytesReceived, failed) {
+  update(function(day) {
+    day.xhr.requests++;
+    day.xhr.bytesSent += bytesSent;
+    day.xhr.bytesReceived += bytesReceived;
+    if (failed) {
+      day.xhr.failed++;
+    }
+  });
+}
+
+function logHistory() {
+  update(function(day) {});
+  JSON.parse(localStorage.getItem(STORAGE_KEY)).forEach(logDay);
+}
+
+module.exports = {
+  sendAppMessage: sendAppMessage,
+  delivered: delivered,
+  superseded: superseded,
+  gaveUp: gaveUp,
+  received: received,
+  xhrDone: xhrDone,
+  logHistory: logHistory
+};
@@ -0,0 +1,133 @@
+/*jslint node: true*/
+
+// A loopback HTTP server answering like OpenWeatherMap, for testing and benchmarking the phone side offline.
+//
+//   /data/2.5/onecall   fixtures/owm_onecall.json, what the fixture provider in providers.js parses
+//   /data/2.5/weather   fixtures/owm_weather.json, the current weather only
+//
+// Timestamps in the fixtures are moved to the current hour, so the forecast always starts now and the sun is up.
+// Point the phone at it by setting localStorage.fixtureProviderUrl to onecallUrl.
+//
+// Run on its own with "node test/fixture_server.js [port]", or from a harness:
+//
+//   require('./fixture_server').start({ latencyMs: 200 }, function(server) { ... server.onecallUrl ... });
+//
+// Options, all optional:
+//   port           defaults to any free one
+//   latencyMs      added before every response
+//   jitterMs       up to this much more, uniformly
+//   failureRate    fraction of requests answered with HTTP 500
+//   rateLimitRate  fraction of requests answered with HTTP 429
+//   random         replaces Math.random, to make a run repeatable
+//   now            replaces Date.now when moving the timestamps, for a harness running on a clock of its own
+
+var fs = require('fs');
+var http = require('http');
+var path = require('path');
+var url = require('url');
+
+var FIXTURE_DIR = path.join(__dirname, 'fixtures');
+var HOUR_SECONDS = 3600;
+
+// Keys holding unix times, moved along with the clock.
+var TIME_KEYS = ['dt', 'sunrise', 'sunset'];
+
+function readFixture(name) {
+  return JSON.parse(fs.readFileSync(path.join(FIXTURE_DIR, name), 'utf8'));
+}
+
+var FIXTURES = {
+  onecall: readFixture('owm_onecall.json'),
+  weather: readFixture('owm_weather.json')
+};
+
+function shiftTimes(value, offsetSeconds) {
+  if (Array.isArray(value)) {
+    return value.map(function(item) { return shiftTimes(item, offsetSeconds); });
+  }
+  if (value === null || typeof value !== 'object') {
+    return value;
+  }
+  var shifted = {};
+  Object.keys(value).forEach(function(key) {
+    shifted[key] = TIME_KEYS.indexOf(key) >= 0 ? value[key] + offsetSeconds : shiftTimes(value[key], offsetSeconds);
+  });
+  return shifted;
+}
+
+// The fixture as OpenWeatherMap would answer it this hour, compact like the real thing.
+function responseBody(fixture, nowMs) {
+  var thisHour = Math.floor(nowMs / 1000 / HOUR_SECONDS) * HOUR_SECONDS;
+  var fixtureHour = fixture.current ? fixture.current.dt : fixture.dt;
+  return JSON.stringify(shiftTimes(fixture, thisHour - fixtureHour));
+}
+
+function fixtureFor(pathname) {
+  if (/\/onecall$/.test(pathname)) {
+    return FIXTURES.onecall;
+  }
+  if (/\/weather$/.test(pathname)) {
+    return FIXTURES.weather;
+  }
+  return null;
+}
+
+function start(options, callback) {
+  options = options || {};
+  var random = options.random || Math.random;
+  var now = options.now || Date.now;
+  var stats = { requests: 0, failed: 0, rateLimited: 0, notFound: 0, bytes: 0 };
+
+  var server = http.createServer(function(request, response) {
+    var fixture = fixtureFor(url.parse(request.url).pathname);
+    var delay = (options.latencyMs || 0) + random() * (options.jitterMs || 0);
+    var status = 200;
+    var body;
+
+    stats.requests++;
+    if (!fixture) {
+      status = 404;
+      body = JSON.stringify({ cod: 404, message: "not found" });
+      stats.notFound++;
+    } else if (random() < (options.failureRate || 0)) {
+      status = 500;
+      body = JSON.stringify({ cod: 500, message: "fixture failure" });
+      stats.failed++;
+    } else if (random() < (options.rateLimitRate || 0)) {
+      status = 429;
+      body = JSON.stringify({ cod: 429, message: "fixture rate limit" });
+      stats.rateLimited++;
+    } else {
+      body = responseBody(fixture, now());
+    }
+    stats.bytes += body.length;
+
+    setTimeout(function() {
+      response.writeHead(status, { 'Content-Type': 'application/json', 'Content-Length': Buffer.byteLength(body) });
+      response.end(body);
+    }, delay);
+  });
+
+  server.listen(options.port || 0, '127.0.0.1', function() {
+    var base = 'http://127.0.0.1:' + server.address().port + '/data/2.5';
+    callback({
+      onecallUrl: base + '/onecall',
+      weatherUrl: base + '/weather',
+      stats: stats,
+      close: function(done) { server.close(done); }
+    });
+  });
+  return server;
+}
+
+module.exports = {
+  start: start,
+  FIXTURES: FIXTURES
+};
+
+if (require.main === module) {
+  start({ port: parseInt(process.argv[2], 10) || 0 }, function(server) {
+    console.log("One Call:        " + server.onecallUrl);
+    console.log("Current weather: " + server.weatherUrl);
+  });
+}
@@ -0,0 +1,564 @@
+/*jslint node: true*/
+
+// Runs the host build of the watchface against the PebbleKit JS harness, over a simulated Bluetooth link and on a
+// virtual clock, so days of weather updates take seconds.  Build the watch first with make in this directory.
+//
+//   node test/host/bridge.js [--hours=72] [--seed=1] [--latency=40] [--jitter=20] [--mtu=158] [--packet-ms=15]
+//                            [--drop-rate=0] [--busy-rate=0] [--begin-busy-rate=0] [--send-timeout=5000]
+//                            [--xhr-latency=300] [--position-ms=500] [--js-start-ms=1500] [--http-failure-rate=0]
+//                            [--disconnect-every=0] [--disconnect-for=60] [--verbose=0]
+//
+// Every message either way takes --latency ms, plus --packet-ms for each --mtu bytes it needs, plus up to --jitter
+// more, and its acknowledgement the same again.  Faults, each drawn per message from a PRNG seeded with --seed:
+//
+//   --drop-rate          the message is lost, and the sender hears after --send-timeout ms
+//   --busy-rate          the other end answers APP_MSG_BUSY
+//   --begin-busy-rate    after the watch sends, its next app_message_outbox_begin fails with APP_MSG_BUSY, the
+//                        way it can after a reconnect; the watchface restarts itself over that, and is started
+//                        again, with its storage, when it asked to be woken up
+//   --disconnect-every   Bluetooth goes away every so many minutes, for --disconnect-for seconds
+//
+// PebbleKit JS starts with the watchface and is ready --js-start-ms later; the phone acknowledges what the watch
+// sends before then, but JS never sees it.  The phone does HTTP for real against the fixture server; on the virtual
+// clock a request takes --xhr-latency ms and a position --position-ms.
+//
+// Reported are the weather round trip latencies, from the watch sending a request to the answer with its id
+// reaching the watch, the bytes each update costs over the air, retries included, and the faults that went in.
+
+var childProcess = require('child_process');
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
+
+var fixtureServer = require('../fixture_server');
+var harness = require('../pkjs/harness');
+
+var HOST = path.join(__dirname, 'watchface_host');
+
+var MESSAGE_TYPE_WEATHER = 1;
+var MESSAGE_TYPE_ERROR = 4;
+
+var APP_MSG_SEND_TIMEOUT = 2;
+var APP_MSG_BUSY = 64;
+var APP_MSG_OK = 0;
+
+var TUPLE_BYTE_ARRAY = 0;
+var TUPLE_CSTRING = 1;
+var TUPLE_UINT = 2;
+var TUPLE_INT = 3;
+
+// What goes over the air besides the dictionary, and what an acknowledgement takes.
+var PACKET_HEADER_BYTES = 8;
+var ACK_BYTES = 8;
+
+var START_MS = Date.UTC(2026, 9, 18, 7, 0, 0);
+
+var DEFAULTS = {
+  hours: 72, seed: 1, latency: 40, jitter: 20, mtu: 158, 'packet-ms': 15, 'drop-rate': 0, 'busy-rate': 0,
+  'begin-busy-rate': 0, 'send-timeout': 5000, 'xhr-latency': 300, 'position-ms': 500, 'js-start-ms': 1500,
+  'http-failure-rate': 0, 'disconnect-every': 0, 'disconnect-for': 60, verbose: 0
+};
+
+function parseArgs(argv) {
+  var args = JSON.parse(JSON.stringify(DEFAULTS));
+  argv.forEach(function(arg) {
+    var match = arg.match(/^--([a-z-]+)=(.*)$/);
+    if (!match || !args.hasOwnProperty(match[1])) {
+      console.error("Unknown argument: " + arg);
+      process.exit(2);
+    }
+    args[match[1]] = parseFloat(match[2]);
+  });
+  return args;
+}
+
+// Small, seedable and good enough for drawing faults.
+function mulberry32(seed) {
+  return function() {
+    seed = (seed + 0x6d2b79f5) | 0;
+    var t = Math.imul(seed ^ (seed >>> 15), 1 | seed);
+    t = (t + Math.imul(t ^ (t >>> 7), 61 | t)) ^ t;
+    return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+  };
+}
+
+//
+// AppMessage dictionaries, laid out as on the watch.
+//
+
+function encodeDictionary(payload) {
+  var parts = [];
+  var keys = Object.keys(payload);
+  var count = Buffer.alloc(1);
+
+  count.writeUInt8(keys.length, 0);
+  parts.push(count);
+  keys.forEach(function(key) {
+    var value = payload[key];
+    var data;
+    var type;
+
+    if (Array.isArray(value)) {
+      type = TUPLE_BYTE_ARRAY;
+      data = Buffer.from(value.map(function(byte) { return byte & 0xff; }));
+    } else if (typeof value === 'string') {
+      type = TUPLE_CSTRING;
+      data = Buffer.from(value + '\0', 'utf8');
+    } else {
+      type = TUPLE_INT;
+      data = Buffer.alloc(4);
+      data.writeInt32LE(+value | 0, 0);
+    }
+    var header = Buffer.alloc(7);
+    header.writeUInt32LE(+key, 0);
+    header.writeUInt8(type, 4);
+    header.writeUInt16LE(data.length, 5);
+    parts.push(header, data);
+  });
+  return Buffer.concat(parts);
+}
+
+function decodeDictionary(bytes) {
+  var payload = {};
+  var offset = 1;
+
+  for (var i = 0; i < bytes.readUInt8(0) && offset + 7 <= bytes.length; i++) {
+    var key = bytes.readUInt32LE(offset);
+    var type = bytes.readUInt8(offset + 4);
+    var length = bytes.readUInt16LE(offset + 5);
+    var data = bytes.slice(offset + 7, offset + 7 + length);
+
+    if (type === TUPLE_INT) {
+      payload[key] = data.readIntLE(0, length);
+    } else if (type === TUPLE_UINT) {
+      payload[key] = data.readUIntLE(0, length);
+    } else if (type === TUPLE_CSTRING) {
+      payload[key] = data.toString('utf8').replace(/\0.*$/, '');
+    } else {
+      payload[key] = Array.prototype.slice.call(data);
+    }
+    offset += 7 + length;
+  }
+  return payload;
+}
+
+//
+// The virtual clock, and what is due on it on this side.
+//
+
+function createClock() {
+  var events = [];
+  var sequence = 0;
+  var clock = { nowMs: START_MS };
+
+  clock.now = function() {
+    return clock.nowMs;
+  };
+  clock.setTimeout = function(callback, ms) {
+    var extra = Array.prototype.slice.call(arguments, 2);
+    // Whole milliseconds, as the watch counts them.
+    var event = { at: clock.nowMs + Math.max(0, Math.round(ms || 0)), sequence: ++sequence, callback: callback,
+                  args: extra };
+    events.push(event);
+    return event;
+  };
+  clock.clearTimeout = function(event) {
+    if (event) {
+      event.cancelled = true;
+    }
+  };
+  clock.next = function() {
+    events = events.filter(function(event) { return !event.cancelled; });
+    events.sort(function(a, b) { return a.at - b.at || a.sequence - b.sequence; });
+    return events[0] || null;
+  };
+  clock.runNext = function() {
+    var event = events.shift();
+    event.callback.apply(null, event.args);
+  };
+  return clock;
+}
+
+//
+// The watch, as a child process taking the commands in host_stdio.c.
+//
+
+function launchWatch(startMs, persistFile, verbose) {
+  var env = Object.assign({}, process.env, {
+    HOST_START_MS: String(startMs),
+    HOST_PERSIST_FILE: persistFile,
+    HOST_LOG: verbose ? '1' : '0'
+  });
+  var child = childProcess.spawn(HOST, [], { env: env, stdio: ['pipe', 'pipe', verbose ? 'inherit' : 'ignore'] });
+  var watch = { child: child, exited: false, processExited: false, waiting: null, lines: [], partial: '' };
+
+  child.stdout.setEncoding('utf8');
+  child.stdout.on('data', function(chunk) {
+    var lines = (watch.partial + chunk).split('\n');
+    watch.partial = lines.pop();
+    lines.forEach(function(line) {
+      watch.lines.push(line);
+      if (/^AT /.test(line) && watch.waiting) {
+        var callback = watch.waiting;
+        var output = watch.lines;
+        watch.waiting = null;
+        watch.lines = [];
+        callback(output);
+      }
+    });
+  });
+  child.on('exit', function() {
+    watch.processExited = true;
+    if (watch.onProcessExit) {
+      watch.onProcessExit();
+    }
+  });
+  watch.command = function(line, callback) {
+    watch.waiting = callback;
+    child.stdin.write(line + '\n');
+  };
+  return watch;
+}
+
+//
+// Reporting.
+//
+
+function percentile(sorted, fraction) {
+  return sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * fraction))];
+}
+
+function summary(values, unit) {
+  if (values.length === 0) {
+    return "none";
+  }
+  var sorted = values.slice().sort(function(a, b) { return a - b; });
+  var total = sorted.reduce(function(sum, value) { return sum + value; }, 0);
+  function format(value) {
+    return Math.round(value) + unit;
+  }
+  return "mean " + format(total / sorted.length) + ", p50 " + format(percentile(sorted, 0.5)) +
+         ", p90 " + format(percentile(sorted, 0.9)) + ", p99 " + format(percentile(sorted, 0.99)) +
+         ", max " + format(sorted[sorted.length - 1]);
+}
+
+function run(args, fixture, clock, done) {
+  var random = mulberry32(args.seed);
+  var endMs = START_MS + args.hours * 3600 * 1000;
+  var persistFile = path.join(os.tmpdir(), 'watchface_host_' + process.pid + '.persist');
+  var localStorage = {};
+  var commands = [];
+  var watch = null;
+  var phone = null;
+  var phoneReady = false;
+  var connected = true;
+  var requests = {};  // weather request id to when the watch sent it; ids start over when the watchface does
+  var stats = {
+    latencies: [], answered: 0, requested: 0,
+    toPhone: { messages: 0, bytes: 0 }, toWatch: { messages: 0, bytes: 0 },
+    dropped: 0, busy: 0, beginBusy: 0, restarts: 0, disconnects: 0, rejected: 0, watchStats: null
+  };
+
+  function transitMs(bytes) {
+    return args.latency + Math.ceil((bytes + PACKET_HEADER_BYTES) / args.mtu) * args['packet-ms'] +
+           random() * args.jitter;
+  }
+
+  // Commands go to the watch that was running when they were made; one that has since quit does not take them.
+  function command(line, callback, target) {
+    commands.push({ line: line, callback: callback, watch: target || watch });
+  }
+
+  function commandLater(ms, line) {
+    var target = watch;
+    clock.setTimeout(function() {
+      command(line, null, target);
+    }, ms);
+  }
+
+  // The watch sent something; the phone gets it unless the link loses it.
+  function watchSent(id, bytes) {
+    var payload = decodeDictionary(bytes);
+
+    stats.toPhone.messages++;
+    stats.toPhone.bytes += bytes.length;
+    if (payload[harness.MESSAGE_KEYS.KEY_MESSAGE_TYPE] === MESSAGE_TYPE_WEATHER) {
+      var requestId = payload[harness.MESSAGE_KEYS.KEY_MESSAGE_ID];
+      if (!requests.hasOwnProperty(requestId)) {
+        requests[requestId] = clock.now();
+        stats.requested++;
+      }
+    }
+    if (random() < args['begin-busy-rate']) {
+      stats.beginBusy++;
+      command('BUSY 1');
+    }
+    if (random() < args['drop-rate']) {
+      stats.dropped++;
+      commandLater(args['send-timeout'], 'NACK ' + id + ' ' + APP_MSG_SEND_TIMEOUT);
+    } else if (random() < args['busy-rate']) {
+      stats.busy++;
+      commandLater(transitMs(bytes.length) + transitMs(ACK_BYTES), 'NACK ' + id + ' ' + APP_MSG_BUSY);
+    } else {
+      var currentPhone = phone;
+      var target = watch;
+      clock.setTimeout(function() {
+        if (connected && currentPhone === phone) {
+          if (phoneReady) {
+            phone.watchSends(harness.toKeyNames(payload));
+          }
+          clock.setTimeout(function() {
+            command('ACK ' + id, null, target);
+          }, transitMs(ACK_BYTES));
+        } else {
+          clock.setTimeout(function() {
+            command('NACK ' + id + ' ' + APP_MSG_SEND_TIMEOUT, null, target);
+          }, args['send-timeout']);
+        }
+      }, transitMs(bytes.length));
+    }
+  }
+
+  // The phone sends something; the watch gets it unless the link loses it or the watch is not running.
+  function phoneSends(payload, ack, nack) {
+    var payloadIds = harness.toKeyIds(payload);
+    var bytes = encodeDictionary(payloadIds);
+
+    stats.toWatch.messages++;
+    stats.toWatch.bytes += bytes.length;
+    if (!connected) {
+      clock.setTimeout(nack, 0, "not connected");
+    } else if (random() < args['drop-rate']) {
+      stats.dropped++;
+      clock.setTimeout(nack, args['send-timeout'], "timeout");
+    } else if (random() < args['busy-rate']) {
+      stats.busy++;
+      clock.setTimeout(nack, transitMs(bytes.length) + transitMs(ACK_BYTES), "busy");
+    } else {
+      clock.setTimeout(function() {
+        if (!connected || !watch || watch.exited) {
+          clock.setTimeout(nack, args['send-timeout'], "timeout");
+          return;
+        }
+        command('RECV ' + bytes.toString('hex'), function(lines) {
+          var inbox = lines.filter(function(line) { return /^INBOX /.test(line); })[0];
+          var result = inbox ? parseInt(inbox.split(' ')[1], 10) : -1;
+          if (result !== APP_MSG_OK) {
+            stats.rejected++;
+            clock.setTimeout(nack, transitMs(ACK_BYTES), "rejected " + result);
+            return;
+          }
+          var type = payloadIds[harness.MESSAGE_KEYS.KEY_MESSAGE_TYPE];
+          var requestId = payloadIds[harness.MESSAGE_KEYS.KEY_MESSAGE_ID];
+          if ((type === MESSAGE_TYPE_WEATHER || type === MESSAGE_TYPE_ERROR) && requests.hasOwnProperty(requestId)) {
+            stats.latencies.push(clock.now() - requests[requestId]);
+            stats.answered++;
+            delete requests[requestId];
+          }
+          clock.setTimeout(ack, transitMs(ACK_BYTES));
+        });
+      }, transitMs(bytes.length));
+    }
+  }
+
+  function startPhone() {
+    phone = harness.createPhone({
+      fixture: fixture,
+      clock: clock,
+      xhrLatencyMs: args['xhr-latency'],
+      positionMs: args['position-ms'],
+      localStorage: localStorage,
+      watch: phoneSends,
+      log: args.verbose ? function(line) { console.error("[phone] " + line); } : null
+    });
+    phoneReady = false;
+    clock.setTimeout(function(starting) {
+      if (starting === phone) {
+        phoneReady = true;
+        phone.emit('ready');
+      }
+    }, args['js-start-ms'], phone);
+  }
+
+  // The watch and PebbleKit JS start together; the phone keeps its storage and the watch its persisted data.
+  function launch(callback) {
+    watch = launchWatch(clock.now(), persistFile, args.verbose);
+    startPhone();
+    watch.command('STATS', callback);  // whatever the watch did while starting up comes back with this
+  }
+
+  function relaunch() {
+    var previous = watch;
+    localStorage = phone.localStorage.items();
+    requests = {};
+    stats.restarts++;
+    commands.unshift({
+      start: function(callback) {
+        if (previous.processExited) {
+          launch(callback);
+        } else {
+          previous.onProcessExit = function() {
+            launch(callback);
+          };
+        }
+      }
+    });
+  }
+
+  function watchOutput(lines) {
+    lines.forEach(function(line) {
+      var fields = line.split(' ');
+      if (fields[0] === 'SEND') {
+        clock.nowMs = Math.max(clock.nowMs, parseInt(fields[2], 10));
+        watchSent(fields[1], Buffer.from(fields[3] || '', 'hex'));
+      } else if (fields[0] === 'EXIT') {
+        var wakeupMs = parseInt(fields[1], 10) * 1000;
+        watch.exited = true;
+        clock.setTimeout(relaunch, Math.max(0, wakeupMs - clock.now()));
+      } else if (fields[0] === 'STATS') {
+        stats.watchStats = fields.slice(1).join(' ');
+      } else if (fields[0] === 'AT') {
+        clock.nowMs = Math.max(clock.nowMs, parseInt(fields[1], 10));
+      }
+    });
+  }
+
+  function scheduleDisconnects() {
+    if (args['disconnect-every'] <= 0) {
+      return;
+    }
+    clock.setTimeout(function() {
+      connected = false;
+      stats.disconnects++;
+      command('BT 0');
+      clock.setTimeout(function() {
+        connected = true;
+        command('BT 1');
+        scheduleDisconnects();
+      }, args['disconnect-for'] * 1000);
+    }, args['disconnect-every'] * 60 * 1000);
+  }
+
+  function finish() {
+    if (watch.exited) {
+      done(stats);
+      return;
+    }
+    watch.command('STATS', function(lines) {
+      watchOutput(lines);
+      watch.onProcessExit = function() {
+        done(stats);
+      };
+      watch.child.stdin.end('QUIT\n');
+    });
+  }
+
+  // One thing at a time: wait out real HTTP, then tell the watch what happened, then run what is due on this side,
+  // and only then let the watch run, up to whenever this side has something next.
+  function step() {
+    if (phone.xhrsOutstanding > 0) {
+      setTimeout(step, 1);
+      return;
+    }
+    var next = commands.shift();
+    if (next && next.start) {
+      next.start(function(lines) {
+        watchOutput(lines);
+        step();
+      });
+      return;
+    }
+    if (next) {
+      if (next.watch === watch && !watch.exited) {
+        watch.command(next.line, function(lines) {
+          watchOutput(lines);
+          if (next.callback) {
+            next.callback(lines);
+          }
+          setImmediate(step);
+        });
+        return;
+      }
+      if (next.callback) {
+        next.callback(['INBOX ' + 16]);  // APP_MSG_APP_NOT_RUNNING
+      }
+      setImmediate(step);
+      return;
+    }
+    var event = clock.next();
+    if (event && event.at <= clock.now()) {
+      clock.runNext();
+      setImmediate(step);
+      return;
+    }
+    var untilMs = Math.min(event ? event.at : Infinity, endMs);
+    if (clock.now() >= endMs) {
+      finish();
+    } else if (watch.exited) {
+      clock.nowMs = untilMs;
+      setImmediate(step);
+    } else {
+      watch.command('RUN ' + untilMs, function(lines) {
+        watchOutput(lines);
+        setImmediate(step);
+      });
+    }
+  }
+
+  try {
+    fs.unlinkSync(persistFile);
+  } catch (e) {
+    // not there
+  }
+  process.on('exit', function() {
+    try {
+      fs.unlinkSync(persistFile);
+    } catch (e) {
+      // already gone
+    }
+  });
+  scheduleDisconnects();
+  launch(function(lines) {
+    watchOutput(lines);
+    step();
+  });
+}
+
+function main() {
+  var args = parseArgs(process.argv.slice(2));
+  var clock = createClock();
+
+  if (!fs.existsSync(HOST)) {
+    console.error("No " + HOST + ", run make in " + __dirname + " first");
+    process.exit(2);
+  }
+  fixtureServer.start({ failureRate: args['http-failure-rate'], random: mulberry32(args.seed + 1), now: clock.now },
+                      function(fixture) {
+    var started = Date.now();
+
+    run(args, fixture, clock, function(stats) {
+      var updates = Math.max(1, stats.answered);
+      var unanswered = stats.requested - stats.answered;
+
+      console.log("Simulated " + args.hours + " hours in " + ((Date.now() - started) / 1000).toFixed(1) + "s, seed " +
+                  args.seed + "; link " + args.latency + "ms +" + args.jitter + "ms jitter, " + args['packet-ms'] +
+                  "ms per " + args.mtu + " byte packet");
+      console.log("Weather round trips: " + stats.answered + " answered, " + unanswered + " not");
+      console.log("  latency      " + summary(stats.latencies, "ms"));
+      console.log("  per update   " + Math.round(stats.toPhone.bytes / updates) + " bytes in " +
+                  (stats.toPhone.messages / updates).toFixed(2) + " messages to the phone, " +
+                  Math.round(stats.toWatch.bytes / updates) + " bytes in " +
+                  (stats.toWatch.messages / updates).toFixed(2) + " messages to the watch, " +
+                  Math.round(fixture.stats.bytes / updates) + " bytes of HTTP");
+      console.log("Faults: " + stats.dropped + " dropped, " + stats.busy + " answered busy, " + stats.beginBusy +
+                  " outbox begins busy, " + stats.disconnects + " disconnects, " + stats.rejected +
+                  " refused by the watch, " + stats.restarts + " watchface restarts");
+      console.log("Watch since its last start: " + (stats.watchStats || "unknown"));
+      fixture.close(function() {
+        process.exit(0);
+      });
+    });
+  });
+}
+
+main();
@@ -0,0 +1,133 @@
+#include "pebble_host.h"
+
+#include <inttypes.h>
+
+#undef time
+
+// Drives the host build from stdin, for bridge.js.  One command per line in, and per command whatever the watch did
+// while it ran, ending with where the clock is:
+//
+//   RUN <until_ms>         runs until then, or until the watch sends something
+//   ACK <id>               the phone took message id
+//   NACK <id> <result>     it did not, with an AppMessageResult
+//   RECV <hex>             a dictionary from the phone, answered with INBOX <result>
+//   BUSY <count>           the next count outbox_begin calls fail with APP_MSG_BUSY
+//   TAP | BT 0|1 | FOCUS 0|1 | BATTERY <percent> <charging> <plugged>
+//   STATS                  answered with STATS and the heap and frame counts
+//   QUIT
+//
+//   SEND <id> <ms> <hex>   a message from the watch at time ms, to be answered with ACK or NACK
+//   EXIT <wakeup>          the watchface quit, and wants to be started again at wakeup (seconds, or 0)
+//   AT <now_ms> <next_ms>  done; next_ms is when something is next due, or -1
+//
+// The environment sets things up before main runs: HOST_START_MS for the clock, HOST_PERSIST_FILE for storage to
+// load now and save at exit, and HOST_LOG=0 to keep the watch's logs off stderr.
+
+#define MAX_LINE 20000
+
+static char const *s_persist_file;
+
+static int hex_value(char c) {
+  return c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+}
+
+static uint16_t from_hex(char const *hex, uint8_t *bytes, size_t max) {
+  uint16_t size = 0;
+
+  while (size < max && hex_value(hex[0]) >= 0 && hex_value(hex[1]) >= 0) {
+    bytes[size++] = (uint8_t)(hex_value(hex[0]) << 4 | hex_value(hex[1]));
+    hex += 2;
+  }
+  return size;
+}
+
+static void print_hex(uint8_t const *bytes, uint16_t size) {
+  for (uint16_t i = 0; i < size; ++i) {
+    printf("%02x", bytes[i]);
+  }
+}
+
+static void phone_receives(uint32_t id, uint8_t const *dictionary, uint16_t size, void *context) {
+  printf("SEND %" PRIu32 " %" PRIu64 " ", id, host_now_ms());
+  print_hex(dictionary, size);
+  putchar('\n');
+}
+
+static void save_persist(void) {
+  if (s_persist_file != NULL) {
+    host_persist_save(s_persist_file);
+  }
+}
+
+__attribute__((constructor)) static void host_stdio_init(void) {
+  char const *start = getenv("HOST_START_MS");
+  char const *log = getenv("HOST_LOG");
+
+  host_init(start != NULL ? strtoull(start, NULL, 10) : (uint64_t)time(NULL) * 1000);
+  host_set_logging(log == NULL || strcmp(log, "0") != 0);
+  host_set_phone(phone_receives, NULL);
+  s_persist_file = getenv("HOST_PERSIST_FILE");
+  if (s_persist_file != NULL) {
+    host_persist_load(s_persist_file);
+  }
+  atexit(save_persist);
+}
+
+static void command(char *line) {
+  static uint8_t dictionary[MAX_LINE / 2];
+  char *name = strtok(line, " \n");
+  char *arg1 = strtok(NULL, " \n");
+  char *arg2 = strtok(NULL, " \n");
+  char *arg3 = strtok(NULL, " \n");
+
+  if (name == NULL) {
+    return;
+  }
+  if (strcmp(name, "RUN") == 0 && arg1 != NULL) {
+    host_run_until(strtoull(arg1, NULL, 10), true);
+  } else if (strcmp(name, "ACK") == 0 && arg1 != NULL) {
+    host_phone_ack(strtoul(arg1, NULL, 10));
+  } else if (strcmp(name, "NACK") == 0 && arg2 != NULL) {
+    host_phone_nack(strtoul(arg1, NULL, 10), (AppMessageResult)strtoul(arg2, NULL, 10));
+  } else if (strcmp(name, "RECV") == 0 && arg1 != NULL) {
+    printf("INBOX %d\n", host_phone_send(dictionary, from_hex(arg1, dictionary, sizeof(dictionary))));
+  } else if (strcmp(name, "BUSY") == 0 && arg1 != NULL) {
+    host_outbox_begin_busy(strtoul(arg1, NULL, 10));
+  } else if (strcmp(name, "TAP") == 0) {
+    host_tap(ACCEL_AXIS_Z, 1);
+  } else if (strcmp(name, "BT") == 0 && arg1 != NULL) {
+    host_set_bluetooth(atoi(arg1) != 0);
+  } else if (strcmp(name, "FOCUS") == 0 && arg1 != NULL) {
+    host_set_focus(atoi(arg1) != 0);
+  } else if (strcmp(name, "BATTERY") == 0 && arg3 != NULL) {
+    host_set_battery((BatteryChargeState) {
+      .charge_percent = atoi(arg1),
+      .is_charging = atoi(arg2) != 0,
+      .is_plugged = atoi(arg3) != 0,
+    });
+  } else if (strcmp(name, "STATS") == 0) {
+    HostHeapStats heap = host_heap_stats();
+    printf("STATS frames=%" PRIu32 " heap_in_use=%zu heap_peak=%zu allocations=%" PRIu32 " failures=%" PRIu32
+           " vibrations=%" PRIu32 "\n", host_frames(), heap.in_use, heap.peak, heap.allocations, heap.failures,
+           host_vibrations());
+  } else {
+    fprintf(stderr, "host: unknown command %s\n", name);
+  }
+}
+
+void app_event_loop(void) {
+  static char line[MAX_LINE];
+
+  while (!host_exited() && fgets(line, sizeof(line), stdin) != NULL) {
+    if (strncmp(line, "QUIT", 4) == 0) {
+      break;
+    }
+    command(line);
+    if (host_exited()) {
+      printf("EXIT %lld\n", (long long)host_wakeup_time());
+    }
+    uint64_t next = host_next_event_ms();
+    printf("AT %" PRIu64 " %lld\n", host_now_ms(), next == UINT64_MAX ? -1LL : (long long)next);
+    fflush(stdout);
+  }
+}
@@ -0,0 +1,1727 @@
+#include "pebble_host.h"
+
+#include <math.h>
+#include <stdarg.h>
+
+// The real ones, for the host's own use.
+#undef malloc
+#undef calloc
+#undef realloc
+#undef free
+#undef time
+
+#define MAX_TIMERS 32
+#define MAX_PERSIST_ENTRIES 64
+#define MAX_DICTIONARY_BYTES 8192
+
+#if defined(PBL_BW)
+#define FRAME_BUFFER_FORMAT GBitmapFormat1Bit
+#define FRAME_BUFFER_BYTES_PER_ROW 20
+#else
+#define FRAME_BUFFER_FORMAT GBitmapFormat8Bit
+#define FRAME_BUFFER_BYTES_PER_ROW HOST_SCREEN_WIDTH
+#endif
+
+// The watch's allocator keeps a header with every block.  Counted against the cap so it fills up the same way.
+#define HEAP_BLOCK_OVERHEAD 8
+
+struct GBitmap {
+  uint8_t *data;
+  uint16_t bytes_per_row;
+  GBitmapFormat format;
+  GRect bounds;
+};
+
+struct GContext {
+  GBitmap *frame_buffer;
+  GPoint offset;  // of the layer being drawn, on screen
+  GRect clip;     // on screen
+  GColor stroke_color;
+  GColor fill_color;
+  GColor text_color;
+  uint8_t stroke_width;
+  bool antialiased;
+  bool captured;  // the frame buffer is out, so drawing through the context does nothing
+};
+
+struct Layer {
+  GRect frame;
+  GRect bounds;
+  Layer *parent;
+  Layer *first_child;
+  Layer *next_sibling;
+  LayerUpdateProc update_proc;
+  bool hidden;
+  Window *window;  // root layers only
+  size_t data_size;
+  uint8_t data[];
+};
+
+struct Window {
+  Layer root;
+  WindowHandlers handlers;
+  void *user_data;
+  GColor background_color;
+  bool loaded;
+};
+
+struct AppTimer {
+  bool active;
+  uint64_t due_ms;
+  uint32_t sequence;
+  AppTimerCallback callback;
+  void *data;
+};
+
+struct HostFont {
+  uint32_t resource_id;
+};
+
+typedef struct {
+  bool used;
+  uint32_t key;
+  uint16_t size;
+  uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} PersistEntry;
+
+typedef enum {
+  OUTBOX_IDLE,
+  OUTBOX_BUILDING,
+  OUTBOX_IN_FLIGHT,
+} OutboxState;
+
+typedef struct {
+  uint32_t id;
+  AppMessageResult reason;
+} OutboxResult;
+
+static uint64_t s_now_ms;
+static bool s_logging = true;
+
+static HostHeapStats s_heap;
+static size_t s_heap_cap;
+
+static uint8_t s_frame_buffer_data[FRAME_BUFFER_BYTES_PER_ROW * HOST_SCREEN_HEIGHT];
+static GBitmap s_frame_buffer = {
+  .data = s_frame_buffer_data,
+  .bytes_per_row = FRAME_BUFFER_BYTES_PER_ROW,
+  .format = FRAME_BUFFER_FORMAT,
+  .bounds = { { 0, 0 }, { HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT } },
+};
+static uint32_t s_frames;
+static bool s_dirty;
+
+static Window *s_top_window;
+static bool s_exited;
+
+static AppTimer s_timers[MAX_TIMERS];
+static uint32_t s_timer_sequence;
+
+static TimeUnits s_tick_units;
+static TickHandler s_tick_handler;
+static time_t s_last_tick;
+
+static BatteryChargeState s_battery;
+static BatteryStateHandler s_battery_handler;
+static bool s_connected;
+static ConnectionHandlers s_connection_handlers;
+static AccelTapHandler s_tap_handler;
+static AccelDataHandler s_accel_data_handler;
+static uint32_t s_accel_samples_per_update;
+static AppFocusHandlers s_focus_handlers;
+static uint32_t s_activities;
+static int32_t s_steps_per_minute;
+
+static PersistEntry s_persist[MAX_PERSIST_ENTRIES];
+static time_t s_wakeup_time;
+static uint32_t s_vibrations;
+
+static bool s_app_message_open;
+static void *s_app_message_context;
+static AppMessageInboxReceived s_inbox_received;
+static AppMessageInboxDropped s_inbox_dropped;
+static AppMessageOutboxSent s_outbox_sent;
+static AppMessageOutboxFailed s_outbox_failed;
+static uint8_t *s_inbox;
+static uint32_t s_inbox_size;
+static uint8_t *s_outbox;
+static uint32_t s_outbox_size;
+static OutboxState s_outbox_state;
+static DictionaryIterator s_outbox_iterator;
+static uint32_t s_message_id;
+static uint32_t s_begin_busy;
+static bool s_sent;
+static HostPhoneHandler s_phone;
+static void *s_phone_context;
+
+static void outbox_done(void *data);
+
+//
+// Clock and run loop.
+//
+
+time_t host_time(time_t *tloc) {
+  time_t now = (time_t)(s_now_ms / 1000);
+  if (tloc != NULL) {
+    *tloc = now;
+  }
+  return now;
+}
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms) {
+  uint16_t ms = (uint16_t)(s_now_ms % 1000);
+  host_time(tloc);
+  if (out_ms != NULL) {
+    *out_ms = ms;
+  }
+  return ms;
+}
+
+uint64_t host_now_ms(void) {
+  return s_now_ms;
+}
+
+// Ticks come on the second when seconds are wanted, otherwise on the minute, which is also when any bigger unit
+// changes.
+static uint64_t next_tick_ms(void) {
+  if (s_tick_handler == NULL) {
+    return UINT64_MAX;
+  }
+  uint64_t period_ms = (s_tick_units & SECOND_UNIT) ? 1000 : 60 * 1000;
+  return (s_now_ms / period_ms + 1) * period_ms;
+}
+
+static AppTimer *next_timer(void) {
+  AppTimer *next = NULL;
+
+  for (int i = 0; i < MAX_TIMERS; ++i) {
+    AppTimer *timer = &s_timers[i];
+    if (timer->active && (next == NULL || timer->due_ms < next->due_ms ||
+                          (timer->due_ms == next->due_ms && timer->sequence < next->sequence))) {
+      next = timer;
+    }
+  }
+  return next;
+}
+
+uint64_t host_next_event_ms(void) {
+  AppTimer *timer = next_timer();
+  uint64_t tick_ms = next_tick_ms();
+
+  return timer != NULL && timer->due_ms < tick_ms ? timer->due_ms : tick_ms;
+}
+
+static void fill_rect_on_screen(GBitmap *frame_buffer, GRect rect, GColor color);
+static void draw_layer(Layer *layer, GContext *ctx, GPoint origin, GRect clip);
+
+static GRect screen_rect(void) {
+  return GRect(0, 0, HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT);
+}
+
+// The watch draws a frame once the event that asked for one has been handled.
+static void after_event(void) {
+  if (!s_dirty || s_top_window == NULL) {
+    return;
+  }
+  s_dirty = false;
+
+  if ((s_top_window->background_color.argb & 0xc0) != 0) {
+    fill_rect_on_screen(&s_frame_buffer, screen_rect(), s_top_window->background_color);
+  }
+  GContext ctx = {
+    .frame_buffer = &s_frame_buffer,
+    .stroke_color = GColorBlack,
+    .fill_color = GColorBlack,
+    .text_color = GColorBlack,
+    .stroke_width = 1,
+    .antialiased = true,
+  };
+  draw_layer(&s_top_window->root, &ctx, GPointZero, screen_rect());
+  ++s_frames;
+}
+
+static void tick(void) {
+  time_t now = (time_t)(s_now_ms / 1000);
+  struct tm previous = *localtime(&s_last_tick);
+  struct tm *current = localtime(&now);
+  TimeUnits changed = SECOND_UNIT;
+
+  if (current->tm_min != previous.tm_min || now - s_last_tick >= 60) {
+    changed |= MINUTE_UNIT;
+  }
+  if (current->tm_hour != previous.tm_hour || now - s_last_tick >= 60 * 60) {
+    changed |= HOUR_UNIT;
+  }
+  if (current->tm_yday != previous.tm_yday || current->tm_year != previous.tm_year) {
+    changed |= DAY_UNIT;
+  }
+  if (current->tm_mon != previous.tm_mon || current->tm_year != previous.tm_year) {
+    changed |= MONTH_UNIT;
+  }
+  if (current->tm_year != previous.tm_year) {
+    changed |= YEAR_UNIT;
+  }
+  s_last_tick = now;
+  if (changed & s_tick_units) {
+    s_tick_handler(current, changed);
+  }
+}
+
+void host_run_until(uint64_t until_ms, bool stop_on_send) {
+  s_sent = false;
+  after_event();
+  while (!s_exited) {
+    AppTimer *timer = next_timer();
+    uint64_t tick_ms = next_tick_ms();
+    uint64_t due_ms = timer != NULL && timer->due_ms < tick_ms ? timer->due_ms : tick_ms;
+
+    if (due_ms > until_ms) {
+      break;
+    }
+    if (due_ms > s_now_ms) {
+      s_now_ms = due_ms;
+    }
+    if (timer != NULL && timer->due_ms == due_ms) {
+      timer->active = false;
+      timer->callback(timer->data);
+    } else {
+      tick();
+    }
+    after_event();
+    if (stop_on_send && s_sent) {
+      return;
+    }
+  }
+  if (!s_exited && until_ms > s_now_ms) {
+    s_now_ms = until_ms;
+  }
+}
+
+bool host_exited(void) {
+  return s_exited;
+}
+
+void host_init(uint64_t start_ms) {
+  s_now_ms = start_ms;
+  s_heap = (HostHeapStats) { 0 };
+  s_heap_cap = 0;
+  memset(s_frame_buffer_data, 0, sizeof(s_frame_buffer_data));
+  s_frames = 0;
+  s_dirty = false;
+  s_top_window = NULL;
+  s_exited = false;
+  memset(s_timers, 0, sizeof(s_timers));
+  s_timer_sequence = 0;
+  s_tick_units = 0;
+  s_tick_handler = NULL;
+  s_battery = (BatteryChargeState) { .charge_percent = 80 };
+  s_battery_handler = NULL;
+  s_connected = true;
+  s_connection_handlers = (ConnectionHandlers) { 0 };
+  s_tap_handler = NULL;
+  s_accel_data_handler = NULL;
+  s_accel_samples_per_update = 0;
+  s_focus_handlers = (AppFocusHandlers) { 0 };
+  s_activities = 0;
+  s_steps_per_minute = 0;
+  s_wakeup_time = 0;
+  s_vibrations = 0;
+  s_app_message_open = false;
+  s_app_message_context = NULL;
+  s_inbox_received = NULL;
+  s_inbox_dropped = NULL;
+  s_outbox_sent = NULL;
+  s_outbox_failed = NULL;
+  s_inbox = NULL;
+  s_outbox = NULL;
+  s_outbox_state = OUTBOX_IDLE;
+  s_message_id = 0;
+  s_begin_busy = 0;
+  s_sent = false;
+  s_phone = NULL;
+  s_phone_context = NULL;
+}
+
+//
+// Heap.
+//
+
+typedef union {
+  size_t size;
+  long double align;
+} BlockHeader;
+
+void host_heap_set_cap(size_t cap) {
+  s_heap_cap = cap;
+}
+
+HostHeapStats host_heap_stats(void) {
+  return s_heap;
+}
+
+void *host_malloc(size_t size) {
+  size_t charged = size + HEAP_BLOCK_OVERHEAD;
+
+  if (s_heap_cap != 0 && s_heap.in_use + charged > s_heap_cap) {
+    ++s_heap.failures;
+    return NULL;
+  }
+  BlockHeader *block = malloc(sizeof(BlockHeader) + size);
+  if (block == NULL) {
+    ++s_heap.failures;
+    return NULL;
+  }
+  block->size = size;
+  s_heap.in_use += charged;
+  if (s_heap.in_use > s_heap.peak) {
+    s_heap.peak = s_heap.in_use;
+  }
+  ++s_heap.allocations;
+  return block + 1;
+}
+
+void *host_calloc(size_t count, size_t size) {
+  void *pointer = host_malloc(count * size);
+  if (pointer != NULL) {
+    memset(pointer, 0, count * size);
+  }
+  return pointer;
+}
+
+void host_free(void *pointer) {
+  if (pointer == NULL) {
+    return;
+  }
+  BlockHeader *block = (BlockHeader *)pointer - 1;
+  s_heap.in_use -= block->size + HEAP_BLOCK_OVERHEAD;
+  free(block);
+}
+
+void *host_realloc(void *pointer, size_t size) {
+  if (pointer == NULL) {
+    return host_malloc(size);
+  }
+  size_t old_size = ((BlockHeader *)pointer - 1)->size;
+  void *moved = host_malloc(size);
+  if (moved != NULL) {
+    memcpy(moved, pointer, old_size < size ? old_size : size);
+    host_free(pointer);
+  }
+  return moved;
+}
+
+//
+// Logging.
+//
+
+void host_set_logging(bool enabled) {
+  s_logging = enabled;
+}
+
+void app_log(uint8_t log_level, char const *src_filename, int src_line_number, char const *fmt, ...) {
+  if (!s_logging) {
+    return;
+  }
+
+  char const *level = log_level <= APP_LOG_LEVEL_ERROR ? "E" : log_level <= APP_LOG_LEVEL_WARNING ? "W" :
+                      log_level <= APP_LOG_LEVEL_INFO ? "I" : "D";
+  char const *file = strrchr(src_filename, '/');
+  time_t now = (time_t)(s_now_ms / 1000);
+  struct tm *utc = gmtime(&now);
+  va_list args;
+
+  fprintf(stderr, "[%02d:%02d:%02d.%03u] %s %s:%d ", utc->tm_hour, utc->tm_min, utc->tm_sec,
+          (unsigned)(s_now_ms % 1000), level, file != NULL ? file + 1 : src_filename, src_line_number);
+  va_start(args, fmt);
+  vfprintf(stderr, fmt, args);
+  va_end(args);
+  fputc('\n', stderr);
+}
+
+//
+// Geometry, color and trigonometry.
+//
+
+bool gpoint_equal(GPoint const *point_a, GPoint const *point_b) {
+  return point_a->x == point_b->x && point_a->y == point_b->y;
+}
+
+bool grect_equal(GRect const *rect_a, GRect const *rect_b) {
+  return gpoint_equal(&rect_a->origin, &rect_b->origin) && rect_a->size.w == rect_b->size.w &&
+         rect_a->size.h == rect_b->size.h;
+}
+
+GPoint grect_center_point(GRect const *rect) {
+  return GPoint(rect->origin.x + rect->size.w / 2, rect->origin.y + rect->size.h / 2);
+}
+
+GColor GColorFromRGB(uint8_t red, uint8_t green, uint8_t blue) {
+  return (GColor) { .argb = 0xc0 | (red >> 6) << 4 | (green >> 6) << 2 | (blue >> 6) };
+}
+
+GColor GColorFromHEX(uint32_t hex) {
+  return GColorFromRGB((hex >> 16) & 0xff, (hex >> 8) & 0xff, hex & 0xff);
+}
+
+bool gcolor_equal(GColor color_a, GColor color_b) {
+  return color_a.argb == color_b.argb;
+}
+
+int32_t sin_lookup(int32_t angle) {
+  return (int32_t)lround(sin(2 * M_PI * angle / TRIG_MAX_ANGLE) * TRIG_MAX_RATIO);
+}
+
+int32_t cos_lookup(int32_t angle) {
+  return (int32_t)lround(cos(2 * M_PI * angle / TRIG_MAX_ANGLE) * TRIG_MAX_RATIO);
+}
+
+int32_t atan2_lookup(int16_t y, int16_t x) {
+  double angle = atan2(y, x);
+  if (angle < 0) {
+    angle += 2 * M_PI;
+  }
+  return (int32_t)lround(angle * TRIG_MAX_ANGLE / (2 * M_PI)) % TRIG_MAX_ANGLE;
+}
+
+//
+// Bitmaps and drawing.  Plain, unantialiased, one pixel wide unless the stroke width says otherwise; close enough
+// to see what was drawn where, not a match for the watch pixel for pixel.
+//
+
+GBitmapFormat gbitmap_get_format(GBitmap const *bitmap) {
+  return bitmap->format;
+}
+
+uint8_t *gbitmap_get_data(GBitmap const *bitmap) {
+  return bitmap->data;
+}
+
+uint16_t gbitmap_get_bytes_per_row(GBitmap const *bitmap) {
+  return bitmap->bytes_per_row;
+}
+
+GRect gbitmap_get_bounds(GBitmap const *bitmap) {
+  return bitmap->bounds;
+}
+
+GBitmapDataRowInfo gbitmap_get_data_row_info(GBitmap const *bitmap, uint16_t y) {
+  return (GBitmapDataRowInfo) {
+    .data = bitmap->data + y * bitmap->bytes_per_row,
+    .min_x = 0,
+    .max_x = bitmap->bounds.size.w - 1,
+  };
+}
+
+GBitmap *host_frame_buffer(void) {
+  return &s_frame_buffer;
+}
+
+uint32_t host_frames(void) {
+  return s_frames;
+}
+
+static bool is_light(GColor color) {
+  return ((color.argb >> 4) & 3) + ((color.argb >> 2) & 3) + (color.argb & 3) >= 5;
+}
+
+// 1 bit frame buffers keep the leftmost pixel of each byte in its low bit, and a set bit is white.
+static void set_pixel(GBitmap *frame_buffer, int x, int y, GColor color) {
+  if ((color.argb & 0xc0) == 0 || x < 0 || y < 0 || x >= frame_buffer->bounds.size.w ||
+      y >= frame_buffer->bounds.size.h) {
+    return;
+  }
+  uint8_t *row = frame_buffer->data + y * frame_buffer->bytes_per_row;
+  if (frame_buffer->format == GBitmapFormat1Bit) {
+    if (is_light(color)) {
+      row[x / 8] |= 1 << (x % 8);
+    } else {
+      row[x / 8] &= ~(1 << (x % 8));
+    }
+  } else {
+    row[x] = color.argb | 0xc0;
+  }
+}
+
+static void fill_rect_on_screen(GBitmap *frame_buffer, GRect rect, GColor color) {
+  for (int y = rect.origin.y; y < rect.origin.y + rect.size.h; ++y) {
+    for (int x = rect.origin.x; x < rect.origin.x + rect.size.w; ++x) {
+      set_pixel(frame_buffer, x, y, color);
+    }
+  }
+}
+
+static bool can_draw(GContext *ctx) {
+  return ctx != NULL && !ctx->captured;
+}
+
+// x, y in the coordinates of the layer being drawn.
+static void plot(GContext *ctx, int x, int y, GColor color) {
+  x += ctx->offset.x;
+  y += ctx->offset.y;
+  if (x < ctx->clip.origin.x || y < ctx->clip.origin.y || x >= ctx->clip.origin.x + ctx->clip.size.w ||
+      y >= ctx->clip.origin.y + ctx->clip.size.h) {
+    return;
+  }
+  set_pixel(ctx->frame_buffer, x, y, color);
+}
+
+static void span(GContext *ctx, int y, int left, int right, GColor color) {
+  for (int x = left; x <= right; ++x) {
+    plot(ctx, x, y, color);
+  }
+}
+
+static void disc(GContext *ctx, int center_x, int center_y, int radius, GColor color) {
+  for (int y = -radius; y <= radius; ++y) {
+    int half = (int)sqrt((double)(radius * radius - y * y));
+    span(ctx, center_y + y, center_x - half, center_x + half, color);
+  }
+}
+
+// A wide stroke is a disc at every point of the line.
+static void stroke_point(GContext *ctx, int x, int y) {
+  if (ctx->stroke_width <= 1) {
+    plot(ctx, x, y, ctx->stroke_color);
+  } else {
+    disc(ctx, x, y, ctx->stroke_width / 2, ctx->stroke_color);
+  }
+}
+
+static void stroke_line(GContext *ctx, GPoint from, GPoint to) {
+  int dx = abs(to.x - from.x);
+  int dy = -abs(to.y - from.y);
+  int step_x = from.x < to.x ? 1 : -1;
+  int step_y = from.y < to.y ? 1 : -1;
+  int error = dx + dy;
+  int x = from.x;
+  int y = from.y;
+
+  for (;;) {
+    stroke_point(ctx, x, y);
+    if (x == to.x && y == to.y) {
+      break;
+    }
+    int error2 = 2 * error;
+    if (error2 >= dy) {
+      error += dy;
+      x += step_x;
+    }
+    if (error2 <= dx) {
+      error += dx;
+      y += step_y;
+    }
+  }
+}
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color) {
+  ctx->stroke_color = color;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+  ctx->fill_color = color;
+}
+
+void graphics_context_set_text_color(GContext *ctx, GColor color) {
+  ctx->text_color = color;
+}
+
+void graphics_context_set_stroke_width(GContext *ctx, uint8_t stroke_width) {
+  ctx->stroke_width = stroke_width;
+}
+
+void graphics_context_set_antialiased(GContext *ctx, bool enable) {
+  ctx->antialiased = enable;
+}
+
+void graphics_draw_pixel(GContext *ctx, GPoint point) {
+  if (can_draw(ctx)) {
+    plot(ctx, point.x, point.y, ctx->stroke_color);
+  }
+}
+
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1) {
+  if (can_draw(ctx)) {
+    stroke_line(ctx, p0, p1);
+  }
+}
+
+void graphics_draw_rect(GContext *ctx, GRect rect) {
+  if (!can_draw(ctx) || rect.size.w <= 0 || rect.size.h <= 0) {
+    return;
+  }
+  int right = rect.origin.x + rect.size.w - 1;
+  int bottom = rect.origin.y + rect.size.h - 1;
+  span(ctx, rect.origin.y, rect.origin.x, right, ctx->stroke_color);
+  span(ctx, bottom, rect.origin.x, right, ctx->stroke_color);
+  for (int y = rect.origin.y; y <= bottom; ++y) {
+    plot(ctx, rect.origin.x, y, ctx->stroke_color);
+    plot(ctx, right, y, ctx->stroke_color);
+  }
+}
+
+// Corners are left square.
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+  if (!can_draw(ctx)) {
+    return;
+  }
+  for (int y = rect.origin.y; y < rect.origin.y + rect.size.h; ++y) {
+    span(ctx, y, rect.origin.x, rect.origin.x + rect.size.w - 1, ctx->fill_color);
+  }
+}
+
+void graphics_draw_circle(GContext *ctx, GPoint p, uint16_t radius) {
+  if (!can_draw(ctx)) {
+    return;
+  }
+  int x = radius, y = 0, error = 1 - radius;
+  while (x >= y) {
+    stroke_point(ctx, p.x + x, p.y + y);
+    stroke_point(ctx, p.x - x, p.y + y);
+    stroke_point(ctx, p.x + x, p.y - y);
+    stroke_point(ctx, p.x - x, p.y - y);
+    stroke_point(ctx, p.x + y, p.y + x);
+    stroke_point(ctx, p.x - y, p.y + x);
+    stroke_point(ctx, p.x + y, p.y - x);
+    stroke_point(ctx, p.x - y, p.y - x);
+    ++y;
+    if (error < 0) {
+      error += 2 * y + 1;
+    } else {
+      --x;
+      error += 2 * (y - x) + 1;
+    }
+  }
+}
+
+void graphics_fill_circle(GContext *ctx, GPoint p, uint16_t radius) {
+  if (can_draw(ctx)) {
+    disc(ctx, p.x, p.y, radius, ctx->fill_color);
+  }
+}
+
+void graphics_draw_text(GContext *ctx, char const *text, GFont const font, GRect const box,
+                        GTextOverflowMode const overflow_mode, GTextAlignment const alignment,
+                        GTextAttributes *text_attributes) {
+}
+
+GBitmap *graphics_capture_frame_buffer(GContext *ctx) {
+  if (ctx->captured) {
+    return NULL;
+  }
+  ctx->captured = true;
+  return ctx->frame_buffer;
+}
+
+bool graphics_release_frame_buffer(GContext *ctx, GBitmap *buffer) {
+  if (!ctx->captured || buffer != ctx->frame_buffer) {
+    return false;
+  }
+  ctx->captured = false;
+  return true;
+}
+
+GPath *gpath_create(GPathInfo const *init) {
+  GPath *path = host_malloc(sizeof(GPath));
+  if (path != NULL) {
+    *path = (GPath) { .num_points = init->num_points, .points = init->points };
+  }
+  return path;
+}
+
+void gpath_destroy(GPath *path) {
+  host_free(path);
+}
+
+void gpath_rotate_to(GPath *path, int32_t angle) {
+  path->rotation = angle;
+}
+
+void gpath_move_to(GPath *path, GPoint point) {
+  path->offset = point;
+}
+
+static GPoint place_point(GPath const *path, GPoint point) {
+  int32_t cos = cos_lookup(path->rotation);
+  int32_t sin = sin_lookup(path->rotation);
+
+  return GPoint(point.x * cos / TRIG_MAX_RATIO - point.y * sin / TRIG_MAX_RATIO + path->offset.x,
+                point.y * cos / TRIG_MAX_RATIO + point.x * sin / TRIG_MAX_RATIO + path->offset.y);
+}
+
+// Even-odd scanline fill, sampling each row through its middle.
+void gpath_draw_filled(GContext *ctx, GPath *path) {
+  if (!can_draw(ctx) || path->num_points < 3) {
+    return;
+  }
+  int top = INT16_MAX, bottom = INT16_MIN;
+  for (uint32_t i = 0; i < path->num_points; ++i) {
+    GPoint point = place_point(path, path->points[i]);
+    top = point.y < top ? point.y : top;
+    bottom = point.y > bottom ? point.y : bottom;
+  }
+  for (int y = top; y <= bottom; ++y) {
+    double crossings[32];
+    int count = 0;
+    for (uint32_t i = 0; i < path->num_points && count < 32; ++i) {
+      GPoint a = place_point(path, path->points[i]);
+      GPoint b = place_point(path, path->points[(i + 1) % path->num_points]);
+      double sample = y + 0.5;
+      if ((a.y <= sample) != (b.y <= sample)) {
+        crossings[count++] = a.x + (sample - a.y) * (b.x - a.x) / (b.y - a.y);
+      }
+    }
+    for (int i = 1; i < count; ++i) {
+      for (int j = i; j > 0 && crossings[j - 1] > crossings[j]; --j) {
+        double swap = crossings[j];
+        crossings[j] = crossings[j - 1];
+        crossings[j - 1] = swap;
+      }
+    }
+    for (int i = 0; i + 1 < count; i += 2) {
+      span(ctx, y, (int)lround(crossings[i]), (int)lround(crossings[i + 1]), ctx->fill_color);
+    }
+  }
+}
+
+void gpath_draw_outline(GContext *ctx, GPath *path) {
+  if (!can_draw(ctx)) {
+    return;
+  }
+  for (uint32_t i = 0; i < path->num_points; ++i) {
+    stroke_line(ctx, place_point(path, path->points[i]),
+                place_point(path, path->points[(i + 1) % path->num_points]));
+  }
+}
+
+bool host_write_frame(char const *path) {
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    return false;
+  }
+  if (s_frame_buffer.format == GBitmapFormat1Bit) {
+    fprintf(file, "P4\n%d %d\n", HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT);
+    for (int y = 0; y < HOST_SCREEN_HEIGHT; ++y) {
+      uint8_t const *row = s_frame_buffer.data + y * s_frame_buffer.bytes_per_row;
+      for (int x = 0; x < HOST_SCREEN_WIDTH; x += 8) {
+        uint8_t packed = 0;
+        for (int bit = 0; bit < 8; ++bit) {
+          bool white = row[(x + bit) / 8] & (1 << ((x + bit) % 8));
+          packed |= (white ? 0 : 1) << (7 - bit);  // PBM is most significant bit first, and 1 is black
+        }
+        fputc(packed, file);
+      }
+    }
+  } else {
+    fprintf(file, "P6\n%d %d\n255\n", HOST_SCREEN_WIDTH, HOST_SCREEN_HEIGHT);
+    for (int y = 0; y < HOST_SCREEN_HEIGHT; ++y) {
+      for (int x = 0; x < HOST_SCREEN_WIDTH; ++x) {
+        uint8_t argb = s_frame_buffer.data[y * s_frame_buffer.bytes_per_row + x];
+        fputc(((argb >> 4) & 3) * 85, file);
+        fputc(((argb >> 2) & 3) * 85, file);
+        fputc((argb & 3) * 85, file);
+      }
+    }
+  }
+  return fclose(file) == 0;
+}
+
+//
+// Resources and fonts.  Fonts take heap as they do on the watch, but are never drawn.
+//
+
+ResHandle resource_get_handle(uint32_t resource_id) {
+  return (ResHandle)(uintptr_t)resource_id;
+}
+
+GFont fonts_load_custom_font(ResHandle handle) {
+  GFont font = host_malloc(sizeof(struct HostFont));
+  if (font != NULL) {
+    font->resource_id = (uint32_t)(uintptr_t)handle;
+  }
+  return font;
+}
+
+void fonts_unload_custom_font(GFont font) {
+  host_free(font);
+}
+
+//
+// Windows and layers.  One window at a time is all the watchface needs.
+//
+
+static void layer_init(Layer *layer, GRect frame) {
+  *layer = (Layer) {
+    .frame = frame,
+    .bounds = GRect(0, 0, frame.size.w, frame.size.h),
+  };
+}
+
+Window *window_create(void) {
+  Window *window = host_malloc(sizeof(Window));
+  if (window != NULL) {
+    *window = (Window) { .background_color = GColorWhite };
+    layer_init(&window->root, screen_rect());
+    window->root.window = window;
+  }
+  return window;
+}
+
+void window_destroy(Window *window) {
+  if (window == s_top_window) {
+    window_stack_pop_all(false);
+  }
+  host_free(window);
+}
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers) {
+  window->handlers = handlers;
+}
+
+Layer *window_get_root_layer(Window const *window) {
+  return (Layer *)&window->root;
+}
+
+void window_set_background_color(Window *window, GColor background_color) {
+  window->background_color = background_color;
+  s_dirty = true;
+}
+
+void window_set_user_data(Window *window, void *data) {
+  window->user_data = data;
+}
+
+void *window_get_user_data(Window const *window) {
+  return window->user_data;
+}
+
+void window_stack_push(Window *window, bool animated) {
+  s_top_window = window;
+  if (!window->loaded) {
+    window->loaded = true;
+    if (window->handlers.load != NULL) {
+      window->handlers.load(window);
+    }
+  }
+  if (window->handlers.appear != NULL) {
+    window->handlers.appear(window);
+  }
+  s_dirty = true;
+}
+
+// Emptying the stack ends the app.
+void window_stack_pop_all(bool animated) {
+  Window *window = s_top_window;
+
+  if (window == NULL) {
+    return;
+  }
+  s_top_window = NULL;
+  if (window->handlers.disappear != NULL) {
+    window->handlers.disappear(window);
+  }
+  if (window->loaded) {
+    window->loaded = false;
+    if (window->handlers.unload != NULL) {
+      window->handlers.unload(window);
+    }
+  }
+  s_exited = true;
+}
+
+Layer *layer_create(GRect frame) {
+  return layer_create_with_data(frame, 0);
+}
+
+Layer *layer_create_with_data(GRect frame, size_t data_size) {
+  Layer *layer = host_malloc(sizeof(Layer) + data_size);
+  if (layer != NULL) {
+    layer_init(layer, frame);
+    layer->data_size = data_size;
+    memset(layer->data, 0, data_size);
+  }
+  return layer;
+}
+
+void layer_remove_from_parent(Layer *child) {
+  if (child->parent == NULL) {
+    return;
+  }
+  Layer **link = &child->parent->first_child;
+  while (*link != child) {
+    link = &(*link)->next_sibling;
+  }
+  *link = child->next_sibling;
+  child->parent = NULL;
+  child->next_sibling = NULL;
+  s_dirty = true;
+}
+
+void layer_destroy(Layer *layer) {
+  if (layer == NULL) {
+    return;
+  }
+  layer_remove_from_parent(layer);
+  for (Layer *child = layer->first_child; child != NULL; child = child->next_sibling) {
+    child->parent = NULL;
+  }
+  host_free(layer);
+}
+
+void *layer_get_data(Layer const *layer) {
+  return (void *)layer->data;
+}
+
+void layer_mark_dirty(Layer *layer) {
+  s_dirty = true;
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+  layer->update_proc = update_proc;
+}
+
+void layer_set_frame(Layer *layer, GRect frame) {
+  layer->frame = frame;
+  layer->bounds.size = frame.size;
+  s_dirty = true;
+}
+
+GRect layer_get_frame(Layer const *layer) {
+  return layer->frame;
+}
+
+void layer_set_bounds(Layer *layer, GRect bounds) {
+  layer->bounds = bounds;
+  s_dirty = true;
+}
+
+GRect layer_get_bounds(Layer const *layer) {
+  return layer->bounds;
+}
+
+GRect layer_get_unobstructed_bounds(Layer const *layer) {
+  return layer->bounds;
+}
+
+Window *layer_get_window(Layer const *layer) {
+  while (layer->parent != NULL) {
+    layer = layer->parent;
+  }
+  return layer->window;
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+  layer_remove_from_parent(child);
+  Layer **link = &parent->first_child;
+  while (*link != NULL) {
+    link = &(*link)->next_sibling;
+  }
+  *link = child;
+  child->parent = parent;
+  s_dirty = true;
+}
+
+void layer_set_hidden(Layer *layer, bool hidden) {
+  layer->hidden = hidden;
+  s_dirty = true;
+}
+
+bool layer_get_hidden(Layer const *layer) {
+  return layer->hidden;
+}
+
+static GRect intersect(GRect a, GRect b) {
+  int left = a.origin.x > b.origin.x ? a.origin.x : b.origin.x;
+  int top = a.origin.y > b.origin.y ? a.origin.y : b.origin.y;
+  int right = a.origin.x + a.size.w < b.origin.x + b.size.w ? a.origin.x + a.size.w : b.origin.x + b.size.w;
+  int bottom = a.origin.y + a.size.h < b.origin.y + b.size.h ? a.origin.y + a.size.h : b.origin.y + b.size.h;
+
+  return GRect(left, top, right > left ? right - left : 0, bottom > top ? bottom - top : 0);
+}
+
+// origin is where the parent's bounds start on screen.
+static void draw_layer(Layer *layer, GContext *ctx, GPoint origin, GRect clip) {
+  if (layer->hidden) {
+    return;
+  }
+  GPoint frame_origin = GPoint(origin.x + layer->frame.origin.x, origin.y + layer->frame.origin.y);
+  GRect layer_clip = intersect(clip, GRect(frame_origin.x, frame_origin.y, layer->frame.size.w, layer->frame.size.h));
+  GPoint bounds_origin = GPoint(frame_origin.x + layer->bounds.origin.x, frame_origin.y + layer->bounds.origin.y);
+
+  if (layer->update_proc != NULL) {
+    ctx->offset = bounds_origin;
+    ctx->clip = layer_clip;
+    layer->update_proc(layer, ctx);
+    if (ctx->captured) {
+      fprintf(stderr, "host: a layer update proc kept the frame buffer\n");
+      ctx->captured = false;
+    }
+  }
+  for (Layer *child = layer->first_child; child != NULL; child = child->next_sibling) {
+    draw_layer(child, ctx, bounds_origin, layer_clip);
+  }
+}
+
+//
+// Timers.
+//
+
+static AppTimer *add_timer(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+  for (int i = 0; i < MAX_TIMERS; ++i) {
+    AppTimer *timer = &s_timers[i];
+    if (!timer->active) {
+      *timer = (AppTimer) {
+        .active = true,
+        .due_ms = s_now_ms + timeout_ms,
+        .sequence = ++s_timer_sequence,
+        .callback = callback,
+        .data = callback_data,
+      };
+      return timer;
+    }
+  }
+  fprintf(stderr, "host: out of timers\n");
+  abort();
+}
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+  return add_timer(timeout_ms, callback, callback_data);
+}
+
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms) {
+  if (timer_handle == NULL || !timer_handle->active) {
+    return false;
+  }
+  timer_handle->due_ms = s_now_ms + new_timeout_ms;
+  timer_handle->sequence = ++s_timer_sequence;
+  return true;
+}
+
+void app_timer_cancel(AppTimer *timer_handle) {
+  if (timer_handle != NULL) {
+    timer_handle->active = false;
+  }
+}
+
+//
+// Dictionaries.  The same bytes as on the watch: a count, then per tuple its key, type, length and value.
+//
+
+#define TUPLE_HEADER_BYTES (sizeof(Tuple))
+
+static Tuple *next_tuple(Tuple *tuple) {
+  return (Tuple *)((uint8_t *)tuple + TUPLE_HEADER_BYTES + tuple->length);
+}
+
+DictionaryResult dict_write_begin(DictionaryIterator *iter, uint8_t *const buffer, const uint16_t size) {
+  if (iter == NULL || buffer == NULL || size < sizeof(Dictionary)) {
+    return DICT_INVALID_ARGS;
+  }
+  iter->dictionary = (Dictionary *)buffer;
+  iter->dictionary->count = 0;
+  iter->cursor = iter->dictionary->head;
+  iter->end = buffer + size;
+  return DICT_OK;
+}
+
+static DictionaryResult write_tuple(DictionaryIterator *iter, uint32_t key, TupleType type, void const *value,
+                                    uint16_t length) {
+  if ((uint8_t *)iter->cursor + TUPLE_HEADER_BYTES + length > (uint8_t const *)iter->end) {
+    return DICT_NOT_ENOUGH_STORAGE;
+  }
+  iter->cursor->key = key;
+  iter->cursor->type = type;
+  iter->cursor->length = length;
+  memcpy(iter->cursor->value, value, length);
+  iter->cursor = next_tuple(iter->cursor);
+  ++iter->dictionary->count;
+  return DICT_OK;
+}
+
+DictionaryResult dict_write_data(DictionaryIterator *iter, const uint32_t key, const uint8_t *const data,
+                                 const uint16_t size) {
+  return write_tuple(iter, key, TUPLE_BYTE_ARRAY, data, size);
+}
+
+DictionaryResult dict_write_cstring(DictionaryIterator *iter, const uint32_t key, const char *const cstring) {
+  return write_tuple(iter, key, TUPLE_CSTRING, cstring, cstring != NULL ? strlen(cstring) + 1 : 0);
+}
+
+DictionaryResult dict_write_int(DictionaryIterator *iter, const uint32_t key, const void *integer,
+                                const uint8_t width_bytes, const bool is_signed) {
+  if (width_bytes != 1 && width_bytes != 2 && width_bytes != 4) {
+    return DICT_INVALID_ARGS;
+  }
+  return write_tuple(iter, key, is_signed ? TUPLE_INT : TUPLE_UINT, integer, width_bytes);
+}
+
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key, const uint8_t value) {
+  return dict_write_int(iter, key, &value, sizeof(value), false);
+}
+
+DictionaryResult dict_write_uint16(DictionaryIterator *iter, const uint32_t key, const uint16_t value) {
+  return dict_write_int(iter, key, &value, sizeof(value), false);
+}
+
+DictionaryResult dict_write_uint32(DictionaryIterator *iter, const uint32_t key, const uint32_t value) {
+  return dict_write_int(iter, key, &value, sizeof(value), false);
+}
+
+DictionaryResult dict_write_int8(DictionaryIterator *iter, const uint32_t key, const int8_t value) {
+  return dict_write_int(iter, key, &value, sizeof(value), true);
+}
+
+DictionaryResult dict_write_int16(DictionaryIterator *iter, const uint32_t key, const int16_t value) {
+  return dict_write_int(iter, key, &value, sizeof(value), true);
+}
+
+DictionaryResult dict_write_int32(DictionaryIterator *iter, const uint32_t key, const int32_t value) {
+  return dict_write_int(iter, key, &value, sizeof(value), true);
+}
+
+// Until this is called the dictionary is as big as the buffer it is written to, as far as dict_size is concerned.
+uint32_t dict_write_end(DictionaryIterator *iter) {
+  iter->end = iter->cursor;
+  return dict_size(iter);
+}
+
+Tuple *dict_read_begin_from_buffer(DictionaryIterator *iter, const uint8_t *const buffer, const uint16_t size) {
+  iter->dictionary = (Dictionary *)buffer;
+  iter->end = buffer + size;
+  return dict_read_first(iter);
+}
+
+Tuple *dict_read_first(DictionaryIterator *iter) {
+  iter->cursor = iter->dictionary->head;
+  if (iter->dictionary->count == 0 || (uint8_t *)iter->cursor + TUPLE_HEADER_BYTES > (uint8_t const *)iter->end) {
+    return NULL;
+  }
+  return iter->cursor;
+}
+
+Tuple *dict_read_next(DictionaryIterator *iter) {
+  iter->cursor = next_tuple(iter->cursor);
+  if ((uint8_t *)iter->cursor + TUPLE_HEADER_BYTES > (uint8_t const *)iter->end) {
+    return NULL;
+  }
+  return iter->cursor;
+}
+
+Tuple *dict_find(const DictionaryIterator *iter, const uint32_t key) {
+  DictionaryIterator copy = *iter;
+
+  for (Tuple *tuple = dict_read_first(&copy); tuple != NULL; tuple = dict_read_next(&copy)) {
+    if (tuple->key == key) {
+      return tuple;
+    }
+  }
+  return NULL;
+}
+
+uint32_t dict_size(DictionaryIterator *iter) {
+  return (uint32_t)((uint8_t const *)iter->end - (uint8_t const *)iter->dictionary);
+}
+
+//
+// AppMessage.  The buffers come out of the heap, as on the watch.
+//
+
+void *app_message_get_context(void) {
+  return s_app_message_context;
+}
+
+void *app_message_set_context(void *context) {
+  void *previous = s_app_message_context;
+  s_app_message_context = context;
+  return previous;
+}
+
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback) {
+  AppMessageInboxReceived previous = s_inbox_received;
+  s_inbox_received = received_callback;
+  return previous;
+}
+
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback) {
+  AppMessageInboxDropped previous = s_inbox_dropped;
+  s_inbox_dropped = dropped_callback;
+  return previous;
+}
+
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent sent_callback) {
+  AppMessageOutboxSent previous = s_outbox_sent;
+  s_outbox_sent = sent_callback;
+  return previous;
+}
+
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback) {
+  AppMessageOutboxFailed previous = s_outbox_failed;
+  s_outbox_failed = failed_callback;
+  return previous;
+}
+
+void app_message_deregister_callbacks(void) {
+  s_inbox_received = NULL;
+  s_inbox_dropped = NULL;
+  s_outbox_sent = NULL;
+  s_outbox_failed = NULL;
+  s_app_message_context = NULL;
+}
+
+uint32_t app_message_inbox_size_maximum(void) {
+  return PBL_IF_COLOR_ELSE(8200, 124);
+}
+
+uint32_t app_message_outbox_size_maximum(void) {
+  return PBL_IF_COLOR_ELSE(8200, 636);
+}
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound) {
+  if (s_app_message_open) {
+    return APP_MSG_INVALID_STATE;
+  }
+  s_inbox = host_malloc(size_inbound);
+  s_outbox = host_malloc(size_outbound);
+  if (s_inbox == NULL || s_outbox == NULL) {
+    host_free(s_inbox);
+    host_free(s_outbox);
+    s_inbox = s_outbox = NULL;
+    return APP_MSG_OUT_OF_MEMORY;
+  }
+  s_inbox_size = size_inbound;
+  s_outbox_size = size_outbound;
+  s_app_message_open = true;
+  return APP_MSG_OK;
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator) {
+  if (!s_app_message_open) {
+    return APP_MSG_INVALID_STATE;
+  }
+  if (s_begin_busy > 0) {
+    --s_begin_busy;
+    return APP_MSG_BUSY;
+  }
+  if (s_outbox_state != OUTBOX_IDLE) {
+    return APP_MSG_BUSY;
+  }
+  dict_write_begin(&s_outbox_iterator, s_outbox, s_outbox_size);
+  s_outbox_state = OUTBOX_BUILDING;
+  *iterator = &s_outbox_iterator;
+  return APP_MSG_OK;
+}
+
+static void answer_later(uint32_t id, AppMessageResult reason) {
+  OutboxResult *result = malloc(sizeof(OutboxResult));
+  *result = (OutboxResult) { .id = id, .reason = reason };
+  add_timer(0, outbox_done, result);
+}
+
+AppMessageResult app_message_outbox_send(void) {
+  if (s_outbox_state != OUTBOX_BUILDING) {
+    return APP_MSG_INVALID_STATE;
+  }
+  uint32_t size = dict_write_end(&s_outbox_iterator);
+  s_outbox_state = OUTBOX_IN_FLIGHT;
+  ++s_message_id;
+  if (!s_connected || s_phone == NULL) {
+    answer_later(s_message_id, APP_MSG_NOT_CONNECTED);
+  } else {
+    s_sent = true;
+    s_phone(s_message_id, s_outbox, (uint16_t)size, s_phone_context);
+  }
+  return APP_MSG_OK;
+}
+
+static void outbox_done(void *data) {
+  OutboxResult result = *(OutboxResult *)data;
+  free(data);
+
+  if (s_outbox_state != OUTBOX_IN_FLIGHT || result.id != s_message_id) {
+    return;  // answered already
+  }
+  s_outbox_state = OUTBOX_IDLE;
+  DictionaryIterator iterator;
+  dict_read_begin_from_buffer(&iterator, s_outbox, s_outbox_iterator.end == NULL ? 0 :
+                              (uint16_t)dict_size(&s_outbox_iterator));
+  if (result.reason == APP_MSG_OK) {
+    if (s_outbox_sent != NULL) {
+      s_outbox_sent(&iterator, s_app_message_context);
+    }
+  } else if (s_outbox_failed != NULL) {
+    s_outbox_failed(&iterator, result.reason, s_app_message_context);
+  }
+}
+
+void host_set_phone(HostPhoneHandler handler, void *context) {
+  s_phone = handler;
+  s_phone_context = context;
+}
+
+void host_phone_ack(uint32_t id) {
+  answer_later(id, APP_MSG_OK);
+}
+
+void host_phone_nack(uint32_t id, AppMessageResult reason) {
+  answer_later(id, reason);
+}
+
+AppMessageResult host_phone_send(uint8_t const *dictionary, uint16_t size) {
+  AppMessageResult result = APP_MSG_OK;
+
+  if (!s_app_message_open || s_exited) {
+    return APP_MSG_APP_NOT_RUNNING;
+  }
+  if (!s_connected) {
+    return APP_MSG_NOT_CONNECTED;
+  }
+  if (size > s_inbox_size) {
+    result = APP_MSG_BUFFER_OVERFLOW;
+    if (s_inbox_dropped != NULL) {
+      s_inbox_dropped(result, s_app_message_context);
+    }
+  } else if (s_inbox_received != NULL) {
+    DictionaryIterator iterator;
+    memcpy(s_inbox, dictionary, size);
+    dict_read_begin_from_buffer(&iterator, s_inbox, size);
+    s_inbox_received(&iterator, s_app_message_context);
+  }
+  after_event();
+  return result;
+}
+
+void host_outbox_begin_busy(uint32_t count) {
+  s_begin_busy = count;
+}
+
+//
+// Event services.
+//
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler) {
+  s_tick_units = tick_units;
+  s_tick_handler = handler;
+  s_last_tick = (time_t)(s_now_ms / 1000);
+}
+
+void tick_timer_service_unsubscribe(void) {
+  s_tick_units = 0;
+  s_tick_handler = NULL;
+}
+
+void battery_state_service_subscribe(BatteryStateHandler handler) {
+  s_battery_handler = handler;
+}
+
+void battery_state_service_unsubscribe(void) {
+  s_battery_handler = NULL;
+}
+
+BatteryChargeState battery_state_service_peek(void) {
+  return s_battery;
+}
+
+void host_set_battery(BatteryChargeState state) {
+  s_battery = state;
+  if (s_battery_handler != NULL) {
+    s_battery_handler(state);
+    after_event();
+  }
+}
+
+bool connection_service_peek_pebble_app_connection(void) {
+  return s_connected;
+}
+
+bool connection_service_peek_pebblekit_connection(void) {
+  return s_connected;
+}
+
+void connection_service_subscribe(ConnectionHandlers conn_handlers) {
+  s_connection_handlers = conn_handlers;
+}
+
+void connection_service_unsubscribe(void) {
+  s_connection_handlers = (ConnectionHandlers) { 0 };
+}
+
+void host_set_bluetooth(bool connected) {
+  if (connected == s_connected) {
+    return;
+  }
+  s_connected = connected;
+  // Whatever was on its way is lost with the link.
+  if (!connected && s_outbox_state == OUTBOX_IN_FLIGHT) {
+    answer_later(s_message_id, APP_MSG_NOT_CONNECTED);
+  }
+  if (s_connection_handlers.pebble_app_connection_handler != NULL) {
+    s_connection_handlers.pebble_app_connection_handler(connected);
+    after_event();
+  }
+}
+
+void accel_tap_service_subscribe(AccelTapHandler handler) {
+  s_tap_handler = handler;
+}
+
+void accel_tap_service_unsubscribe(void) {
+  s_tap_handler = NULL;
+}
+
+void host_tap(AccelAxisType axis, int32_t direction) {
+  if (s_tap_handler != NULL) {
+    s_tap_handler(axis, direction);
+    after_event();
+  }
+}
+
+void accel_data_service_subscribe(uint32_t samples_per_update, AccelDataHandler handler) {
+  s_accel_data_handler = handler;
+  s_accel_samples_per_update = samples_per_update;
+}
+
+void accel_data_service_unsubscribe(void) {
+  s_accel_data_handler = NULL;
+}
+
+int accel_service_set_sampling_rate(AccelSamplingRate rate) {
+  return 0;
+}
+
+bool host_accel_subscribed(void) {
+  return s_accel_data_handler != NULL;
+}
+
+void host_accel(AccelData *samples, uint32_t count) {
+  if (s_accel_data_handler != NULL) {
+    s_accel_data_handler(samples, count < s_accel_samples_per_update ? count : s_accel_samples_per_update);
+    after_event();
+  }
+}
+
+void app_focus_service_subscribe_handlers(AppFocusHandlers handlers) {
+  s_focus_handlers = handlers;
+}
+
+void app_focus_service_subscribe(AppFocusHandler handler) {
+  s_focus_handlers = (AppFocusHandlers) { .did_focus = handler };
+}
+
+void app_focus_service_unsubscribe(void) {
+  s_focus_handlers = (AppFocusHandlers) { 0 };
+}
+
+// Whatever covered the window leaves the frame buffer with it.
+void host_set_focus(bool in_focus) {
+  if (!in_focus) {
+    memset(s_frame_buffer_data, 0, sizeof(s_frame_buffer_data));
+  }
+  if (s_focus_handlers.will_focus != NULL) {
+    s_focus_handlers.will_focus(in_focus);
+  }
+  if (s_focus_handlers.did_focus != NULL) {
+    s_focus_handlers.did_focus(in_focus);
+  }
+  after_event();
+}
+
+#if HOST_API_unobstructed_area_service_subscribe
+void unobstructed_area_service_subscribe(UnobstructedAreaHandlers handlers, void *context) {
+}
+
+void unobstructed_area_service_unsubscribe(void) {
+}
+#endif
+
+void host_set_activities(uint32_t activities) {
+  s_activities = activities;
+}
+
+void host_set_steps_per_minute(int32_t steps) {
+  s_steps_per_minute = steps;
+}
+
+#if defined(PBL_HEALTH)
+HealthActivityMask health_service_peek_current_activities(void) {
+  return s_activities;
+}
+
+HealthValue health_service_sum(HealthMetric metric, time_t time_start, time_t time_end) {
+  return metric == HealthMetricStepCount ? s_steps_per_minute * (int32_t)((time_end - time_start) / 60) : 0;
+}
+
+HealthValue health_service_sum_today(HealthMetric metric) {
+  time_t now = (time_t)(s_now_ms / 1000);
+  return health_service_sum(metric, now - now % (24 * 60 * 60), now);
+}
+
+HealthServiceAccessibilityMask health_service_metric_accessible(HealthMetric metric, time_t time_start,
+                                                                time_t time_end) {
+  return metric == HealthMetricStepCount ? HealthServiceAccessibilityMaskAvailable
+                                         : HealthServiceAccessibilityMaskNotSupported;
+}
+#endif
+
+//
+// Storage.
+//
+
+static PersistEntry *persist_find(uint32_t key, bool create) {
+  PersistEntry *unused = NULL;
+
+  for (int i = 0; i < MAX_PERSIST_ENTRIES; ++i) {
+    if (s_persist[i].used && s_persist[i].key == key) {
+      return &s_persist[i];
+    }
+    if (!s_persist[i].used && unused == NULL) {
+      unused = &s_persist[i];
+    }
+  }
+  if (!create || unused == NULL) {
+    return NULL;
+  }
+  *unused = (PersistEntry) { .used = true, .key = key };
+  return unused;
+}
+
+bool persist_exists(const uint32_t key) {
+  return persist_find(key, false) != NULL;
+}
+
+int persist_get_size(const uint32_t key) {
+  PersistEntry *entry = persist_find(key, false);
+  return entry != NULL ? entry->size : E_DOES_NOT_EXIST;
+}
+
+bool persist_read_bool(const uint32_t key) {
+  PersistEntry *entry = persist_find(key, false);
+  return entry != NULL && entry->size > 0 && entry->data[0] != 0;
+}
+
+int32_t persist_read_int(const uint32_t key) {
+  int32_t value = 0;
+  PersistEntry *entry = persist_find(key, false);
+  if (entry != NULL) {
+    memcpy(&value, entry->data, entry->size < sizeof(value) ? entry->size : sizeof(value));
+  }
+  return value;
+}
+
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size) {
+  PersistEntry *entry = persist_find(key, false);
+  if (entry == NULL) {
+    return E_DOES_NOT_EXIST;
+  }
+  size_t size = entry->size < buffer_size ? entry->size : buffer_size;
+  memcpy(buffer, entry->data, size);
+  return (int)size;
+}
+
+int persist_read_string(const uint32_t key, char *buffer, const size_t buffer_size) {
+  int size = persist_read_data(key, buffer, buffer_size);
+  if (size > 0) {
+    buffer[buffer_size - 1] = '\0';
+  }
+  return size;
+}
+
+int persist_write_data(const uint32_t key, const void *data, const size_t size) {
+  if (size > PERSIST_DATA_MAX_LENGTH) {
+    return E_RANGE;
+  }
+  PersistEntry *entry = persist_find(key, true);
+  if (entry == NULL) {
+    return E_ERROR;
+  }
+  memcpy(entry->data, data, size);
+  entry->size = (uint16_t)size;
+  return (int)size;
+}
+
+StatusCode persist_write_bool(const uint32_t key, const bool value) {
+  uint8_t byte = value;
+  return persist_write_data(key, &byte, sizeof(byte)) < 0 ? E_ERROR : S_SUCCESS;
+}
+
+StatusCode persist_write_int(const uint32_t key, const int32_t value) {
+  return persist_write_data(key, &value, sizeof(value)) < 0 ? E_ERROR : S_SUCCESS;
+}
+
+int persist_write_string(const uint32_t key, const char *cstring) {
+  return persist_write_data(key, cstring, strlen(cstring) + 1);
+}
+
+StatusCode persist_delete(const uint32_t key) {
+  PersistEntry *entry = persist_find(key, false);
+  if (entry == NULL) {
+    return E_DOES_NOT_EXIST;
+  }
+  entry->used = false;
+  return S_SUCCESS;
+}
+
+// Each entry is its key and size as little endian uint32 and uint16, then its bytes.
+bool host_persist_load(char const *path) {
+  FILE *file = fopen(path, "rb");
+  uint8_t header[6];
+
+  if (file == NULL) {
+    return false;
+  }
+  memset(s_persist, 0, sizeof(s_persist));
+  while (fread(header, sizeof(header), 1, file) == 1) {
+    uint32_t key = header[0] | header[1] << 8 | header[2] << 16 | (uint32_t)header[3] << 24;
+    uint16_t size = header[4] | header[5] << 8;
+    uint8_t data[PERSIST_DATA_MAX_LENGTH];
+    if (size > sizeof(data) || fread(data, 1, size, file) != size) {
+      break;
+    }
+    persist_write_data(key, data, size);
+  }
+  fclose(file);
+  return true;
+}
+
+bool host_persist_save(char const *path) {
+  FILE *file = fopen(path, "wb");
+
+  if (file == NULL) {
+    return false;
+  }
+  for (int i = 0; i < MAX_PERSIST_ENTRIES; ++i) {
+    PersistEntry const *entry = &s_persist[i];
+    if (entry->used) {
+      uint8_t header[6] = {
+        entry->key & 0xff, (entry->key >> 8) & 0xff, (entry->key >> 16) & 0xff, entry->key >> 24,
+        entry->size & 0xff, entry->size >> 8,
+      };
+      fwrite(header, sizeof(header), 1, file);
+      fwrite(entry->data, 1, entry->size, file);
+    }
+  }
+  return fclose(file) == 0;
+}
+
+//
+// Everything else.
+//
+
+WakeupId wakeup_schedule(time_t timestamp, int32_t cookie, bool notify_if_missed) {
+  s_wakeup_time = timestamp;
+  return 1;
+}
+
+time_t host_wakeup_time(void) {
+  return s_wakeup_time;
+}
+
+void vibes_double_pulse(void) {
+  ++s_vibrations;
+}
+
+void vibes_short_pulse(void) {
+  ++s_vibrations;
+}
+
+uint32_t host_vibrations(void) {
+  return s_vibrations;
+}
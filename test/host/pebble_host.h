@@ -0,0 +1,79 @@
+#pragma once
+
+#include <pebble.h>
+
+// What the host build offers on top of the SDK, for whatever drives the watchface: a test calling in directly, or
+// host_stdio.c taking commands from bridge.js.
+//
+// Time only moves in host_run_until.  Everything the watch would do in that time, timers, ticks and whatever the
+// driver queued with the host_* calls below, runs in order of when it is due, and a frame is drawn after any of it
+// that marked a layer dirty, the way the watch's event loop does it.
+
+#define HOST_SCREEN_WIDTH 144
+#define HOST_SCREEN_HEIGHT 168
+
+// Starts the clock at start_ms since the epoch and clears everything else.  Persisted data stays.
+void host_init(uint64_t start_ms);
+uint64_t host_now_ms(void);
+// When the next timer or tick is due, or UINT64_MAX if nothing is.
+uint64_t host_next_event_ms(void);
+// Runs what is due up to until_ms, then leaves the clock there.  Returns early, with the clock at the time of the
+// message, when stop_on_send is set and the watch sends something.
+void host_run_until(uint64_t until_ms, bool stop_on_send);
+// Whether the window stack has been emptied, which on the watch ends the app.
+bool host_exited(void);
+// The watch's APP_LOG output goes to stderr unless this turns it off.
+void host_set_logging(bool enabled);
+
+// Heap.  The cap is the most the watchface may have allocated at once; 0 for none.  Past it, malloc returns NULL
+// as on the watch.
+
+typedef struct {
+  size_t in_use;
+  size_t peak;
+  uint32_t allocations;
+  uint32_t failures;  // allocations refused for going over the cap
+} HostHeapStats;
+
+void host_heap_set_cap(size_t cap);
+HostHeapStats host_heap_stats(void);
+
+// Frames drawn so far, and the frame buffer as it was left by the last one.
+uint32_t host_frames(void);
+GBitmap *host_frame_buffer(void);
+// Writes the frame buffer as a PBM (1 bit) or PPM (8 bit) image.
+bool host_write_frame(char const *path);
+
+// AppMessage.  The phone is told about every message the watch sends, with an id to answer it by.  Answers and
+// messages from the phone are taken at the current time.
+
+typedef void (*HostPhoneHandler)(uint32_t id, uint8_t const *dictionary, uint16_t size, void *context);
+
+void host_set_phone(HostPhoneHandler handler, void *context);
+void host_phone_ack(uint32_t id);
+void host_phone_nack(uint32_t id, AppMessageResult reason);
+// Hands the watch a dictionary from the phone.  Returns APP_MSG_OK once the watch took it, or why it did not.
+AppMessageResult host_phone_send(uint8_t const *dictionary, uint16_t size);
+// The next count calls to app_message_outbox_begin fail with APP_MSG_BUSY, as they can after a reconnect.
+void host_outbox_begin_busy(uint32_t count);
+
+// Sensors and system events, taken at the current time.
+
+void host_set_bluetooth(bool connected);
+void host_set_battery(BatteryChargeState state);
+void host_tap(AccelAxisType axis, int32_t direction);
+// A batch of accelerometer samples, to whoever subscribed to the data service, cut to the batch size they asked for.
+bool host_accel_subscribed(void);
+void host_accel(AccelData *samples, uint32_t count);
+void host_set_focus(bool in_focus);
+// Health, on platforms that have it.
+void host_set_activities(uint32_t activities);
+void host_set_steps_per_minute(int32_t steps);
+
+// Persistent storage, in the layout host_persist_save writes.
+bool host_persist_load(char const *path);
+bool host_persist_save(char const *path);
+
+// The time wakeup_schedule was last called for, or 0.
+time_t host_wakeup_time(void);
+uint32_t host_vibrations(void);
@@ -0,0 +1,94 @@
+#include "pebble_host.h"
+#include "watchface_window.h"
+
+// The seconds hand while moving: on once the face shows, gone once the watch has been still for the set duration,
+// back with the first batch of accelerometer data that moves, and kept up by ordinary wrist motion with no taps.
+// Counts the frames drawn in each stretch, and checks the redraws saved end up in persistent storage.  Bluetooth
+// stays off so no weather goes back and forth.
+
+#define START_MS 1792306800000ULL  // 2026-10-18 07:00 UTC
+#define MINUTE_MS (60 * 1000)
+#define BATCH_MS 2500              // 25 samples at 10Hz
+
+// Keep in sync with watchface_window.c.
+#define MESSAGE_KEY_SHOW_SECONDS_HAND 5
+#define MESSAGE_KEY_SECONDS_HAND_DURATION 18
+#define PERSIST_KEY_SECONDS_REDRAWS_SAVED 107
+#define SECONDS_HAND_WHILE_MOVING_OFF 0x7
+#define DURATION_MINUTES 2
+
+typedef enum {
+  STILL,    // on a desk: a few thousandths of a g of noise
+  WRIST,    // a wrist going about its day, swinging a tenth of a g or two, no taps
+} Motion;
+
+static uint32_t s_sample;
+
+static void run_minutes(int minutes, Motion motion) {
+  uint64_t until = host_now_ms() + (uint64_t)minutes * MINUTE_MS;
+  AccelData samples[25];
+
+  while (host_now_ms() < until && !host_exited()) {
+    for (int i = 0; i < 25; ++i, ++s_sample) {
+      int swing = motion == WRIST ? (int)(s_sample % 20) * 15 - 150 : (int)(s_sample % 3) * 2;
+      samples[i] = (AccelData) { .x = swing, .y = -1000 + swing / 2, .z = 20, .timestamp = host_now_ms() };
+    }
+    host_run_until(host_now_ms() + BATCH_MS, false);
+    host_accel(samples, 25);
+  }
+}
+
+static uint32_t frames_in(int minutes, Motion motion) {
+  uint32_t before = host_frames();
+  run_minutes(minutes, motion);
+  return host_frames() - before;
+}
+
+static int check(bool ok, char const *what) {
+  if (!ok) {
+    printf("FAIL: %s\n", what);
+  }
+  return ok ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+  char const *log = getenv("HOST_LOG");
+  int failures = 0;
+
+  host_init(START_MS);
+  host_set_logging(log != NULL && strcmp(log, "0") != 0);
+  host_set_bluetooth(false);
+  persist_write_int(MESSAGE_KEY_SHOW_SECONDS_HAND, SECONDS_HAND_WHILE_MOVING_OFF);
+  persist_write_int(MESSAGE_KEY_SECONDS_HAND_DURATION, DURATION_MINUTES);
+
+  Window *watchface_window = watchface_window_create();
+  watchface_window_show(watchface_window);
+  failures += check(host_accel_subscribed(), "no accelerometer data subscription");
+
+  uint32_t shown = frames_in(DURATION_MINUTES - 1, STILL);
+  run_minutes(2, STILL);  // the hand goes away somewhere in here
+  uint32_t still = frames_in(10, STILL);
+  uint32_t back = frames_in(1, WRIST);
+  uint32_t wrist = frames_in(10, WRIST);
+  run_minutes(DURATION_MINUTES + 1, STILL);
+  uint32_t still_again = frames_in(5, STILL);
+
+  printf("%s: frames per minute %u shown, %u still, %u back, %u on the wrist, %u still again\n", argv[0],
+         (unsigned)(shown / (DURATION_MINUTES - 1)), (unsigned)(still / 10), (unsigned)back, (unsigned)(wrist / 10),
+         (unsigned)(still_again / 5));
+  failures += check(shown >= 50 * (DURATION_MINUTES - 1), "the seconds hand did not start off shown");
+  failures += check(still <= 2 * 10, "the seconds hand kept going while the watch was still");
+  failures += check(back >= 50, "the seconds hand did not come back with motion");
+  failures += check(wrist >= 50 * 10, "the seconds hand went away while the watch was moving");
+  failures += check(still_again <= 2 * 5, "the seconds hand kept going once the watch was still again");
+  failures += check(!host_exited(), "the watchface quit");
+
+  watchface_window_destroy(watchface_window);
+  int32_t saved = persist_read_int(PERSIST_KEY_SECONDS_REDRAWS_SAVED);
+  printf("%s: %ld redraws saved\n", argv[0], (long)saved);
+  // At least the ten still minutes, less their minute ticks, and the five at the end.
+  failures += check(saved >= 15 * 59, "the redraws saved were not stored");
+  failures += check(!host_accel_subscribed(), "accelerometer data still subscribed after the window went");
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,200 @@
+#include "pebble_host.h"
+#include "alloc_trace.h"
+#include "startup_profile.h"
+#include "watchface_window.h"
+
+// Runs the watchface for days of virtual time on the host build, built with ALLOC_TRACE, with a phone that answers
+// every weather request and the usual taps, battery changes, bluetooth drops and notifications going on.  Fails if
+// anything allocates once the face is up: a steady state violation counted by alloc_trace, or the heap growing in
+// any other way.  HOST_LOG=1 shows the watch's log, violations included.
+//
+// Built again as heap_cap_test with HEAP_CAP set to aplite's 24 KB for the app and STATIC_BYTES to what the
+// watchface's statics take of it, so the heap gets only the rest.  There it also fails if any allocation does not fit.
+
+#define START_MS 1792306800000ULL  // 2026-10-18 07:00 UTC
+#define HOURS 72
+#define MINUTE_MS (60 * 1000)
+
+#define KEY_MESSAGE_TYPE 0
+#define KEY_MESSAGE_ID 1
+#define KEY_CONDITION_CODE 2
+#define KEY_TEMPERATURE 3
+#define KEY_IS_DAYLIGHT 4
+#define KEY_FORECAST 21
+#define KEY_FORECAST_START 22
+#define KEY_LATITUDE 23
+#define KEY_LONGITUDE 24
+#define MESSAGE_TYPE_READY 0
+#define MESSAGE_TYPE_WEATHER 1
+#define FORECAST_SLOTS 12
+
+typedef struct {
+  bool ack_due;
+  uint32_t ack_id;
+  bool weather_due;
+  int32_t weather_id;
+  uint32_t requests;
+} Phone;
+
+static void phone_receives(uint32_t id, uint8_t const *dictionary, uint16_t size, void *context) {
+  Phone *phone = context;
+  DictionaryIterator iterator;
+
+  dict_read_begin_from_buffer(&iterator, dictionary, size);
+  Tuple *type = dict_find(&iterator, KEY_MESSAGE_TYPE);
+  Tuple *message_id = dict_find(&iterator, KEY_MESSAGE_ID);
+  if (type != NULL && type->value->int32 == MESSAGE_TYPE_WEATHER && message_id != NULL) {
+    phone->weather_due = true;
+    phone->weather_id = message_id->value->int32;
+    ++phone->requests;
+  }
+  phone->ack_due = true;
+  phone->ack_id = id;
+}
+
+static void send_ready(void) {
+  uint8_t buffer[64];
+  DictionaryIterator iterator;
+
+  dict_write_begin(&iterator, buffer, sizeof(buffer));
+  dict_write_int32(&iterator, KEY_MESSAGE_TYPE, MESSAGE_TYPE_READY);
+  host_phone_send(buffer, dict_write_end(&iterator));
+}
+
+// Clear skies at 15 degrees, with the next twelve hours the same, the way app.js packs them.
+static void send_weather(int32_t message_id) {
+  uint8_t buffer[256];
+  uint8_t forecast[FORECAST_SLOTS * 3];
+  DictionaryIterator iterator;
+  time_t now = (time_t)(host_now_ms() / 1000);
+
+  for (int i = 0; i < FORECAST_SLOTS; ++i) {
+    uint16_t code = 800 | 0x8000;
+    forecast[i * 3] = code & 0xff;
+    forecast[i * 3 + 1] = code >> 8;
+    forecast[i * 3 + 2] = 15;
+  }
+  dict_write_begin(&iterator, buffer, sizeof(buffer));
+  dict_write_int32(&iterator, KEY_MESSAGE_TYPE, MESSAGE_TYPE_WEATHER);
+  dict_write_int32(&iterator, KEY_MESSAGE_ID, message_id);
+  dict_write_int32(&iterator, KEY_CONDITION_CODE, 800);
+  dict_write_int32(&iterator, KEY_TEMPERATURE, 15);
+  dict_write_int32(&iterator, KEY_IS_DAYLIGHT, 1);
+  dict_write_int32(&iterator, KEY_FORECAST_START, (int32_t)(now - now % (60 * 60)));
+  dict_write_data(&iterator, KEY_FORECAST, forecast, sizeof(forecast));
+  dict_write_int32(&iterator, KEY_LATITUDE, 476062);
+  dict_write_int32(&iterator, KEY_LONGITUDE, -1223321);
+  host_phone_send(buffer, dict_write_end(&iterator));
+}
+
+// Runs the watch to until_ms, the phone answering as it goes.
+static void run_until(Phone *phone, uint64_t until_ms) {
+  while (host_now_ms() < until_ms && !host_exited()) {
+    host_run_until(until_ms, true);
+    if (phone->ack_due) {
+      phone->ack_due = false;
+      host_phone_ack(phone->ack_id);
+    }
+    if (phone->weather_due) {
+      phone->weather_due = false;
+      send_weather(phone->weather_id);
+    }
+  }
+}
+
+// Whatever the watch does now and then besides telling the time, one thing per call.
+static void disturb(uint32_t minute) {
+  if (minute % 7 == 0) {
+    host_tap(ACCEL_AXIS_Z, 1);
+  }
+  if (minute % 60 == 30) {
+    host_set_battery((BatteryChargeState) { .charge_percent = 100 - (minute / 60) % 100 });
+  }
+  if (minute % 180 == 90) {
+    host_set_bluetooth(false);
+  } else if (minute % 180 == 92) {
+    host_set_bluetooth(true);
+  }
+  if (minute % 240 == 120) {
+    host_set_focus(false);
+  } else if (minute % 240 == 121) {
+    host_set_focus(true);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  Phone phone = { 0 };
+  char const *log = getenv("HOST_LOG");
+  HostHeapStats at_ready = { 0 };
+  bool ready = false;
+  int failures = 0;
+
+  host_init(START_MS);
+#ifdef HEAP_CAP
+  if (STATIC_BYTES >= HEAP_CAP) {
+    printf("FAIL: %d bytes of statics, over the %d byte cap\n", STATIC_BYTES, HEAP_CAP);
+    return 1;
+  }
+  host_heap_set_cap(HEAP_CAP - STATIC_BYTES);
+#endif
+  host_set_logging(log != NULL && strcmp(log, "0") != 0);
+  host_set_phone(phone_receives, &phone);
+
+  startup_profile_begin();
+  Window *watchface_window = watchface_window_create();
+  watchface_window_show(watchface_window);
+  run_until(&phone, START_MS + 1500);  // PebbleKit JS starting up
+  send_ready();
+
+  for (uint32_t minute = 0; minute < HOURS * 60 && !host_exited(); ++minute) {
+    run_until(&phone, START_MS + (uint64_t)(minute + 1) * MINUTE_MS);
+    if (!ready && alloc_trace_is_ready()) {
+      ready = true;
+      at_ready = host_heap_stats();
+    }
+    disturb(minute);
+  }
+
+  HostHeapStats heap = host_heap_stats();
+  printf("%s: %d hours, %u frames, %u weather requests, heap %zu bytes in use, %zu at most, "
+         "%u allocations, %u after the face was up\n", argv[0], HOURS, (unsigned)host_frames(),
+         (unsigned)phone.requests, heap.in_use, heap.peak, (unsigned)heap.allocations,
+         (unsigned)(heap.allocations - at_ready.allocations));
+
+  if (host_exited()) {
+    printf("FAIL: the watchface quit\n");
+    ++failures;
+  }
+  if (!ready) {
+    printf("FAIL: the face never reached ALLOC_TRACE_READY\n");
+    ++failures;
+  }
+  if (alloc_trace_violations() != 0) {
+    printf("FAIL: %u allocations in steady state, run with HOST_LOG=1 to see where\n",
+           (unsigned)alloc_trace_violations());
+    ++failures;
+  }
+  if (ready && heap.allocations != at_ready.allocations) {
+    printf("FAIL: %u heap allocations after the face was up\n", (unsigned)(heap.allocations - at_ready.allocations));
+    ++failures;
+  }
+  if (heap.failures != 0) {
+    printf("FAIL: %u allocations failed\n", (unsigned)heap.failures);
+    ++failures;
+  }
+#ifdef HEAP_CAP
+  printf("%s: %d bytes of statics and %zu of heap at most, against %d\n", argv[0], STATIC_BYTES, heap.peak,
+         HEAP_CAP);
+  if (STATIC_BYTES + heap.peak > HEAP_CAP) {
+    printf("FAIL: over the %d byte cap\n", HEAP_CAP);
+    ++failures;
+  }
+#endif
+  if (phone.requests == 0) {
+    printf("FAIL: the watch never asked for weather\n");
+    ++failures;
+  }
+
+  watchface_window_destroy(watchface_window);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,204 @@
+/*jslint node: true*/
+
+// Benchmarks the PebbleKit JS side of a weather update against the fixture server.
+//
+//   node test/pkjs/bench.js [--requests=2000] [--latency=0] [--jitter=0] [--failure-rate=0] [--parses=5000]
+//
+// The watch asks for the weather --requests times, one after another, as the watch would.  Reported are the
+// latency from the watch asking until the answer reaches it, the JS heap allocated per request (the harness and
+// HTTP included, from V8's GC statistics where Node has them), the bytes each update costs over HTTP and over
+// the air, and how long the One Call response takes to parse on its own.  The first WARMUP requests are left out.
+
+var http = require('http');
+var v8 = require('v8');
+
+var fixtureServer = require('../fixture_server');
+var harness = require('./harness');
+
+var MESSAGE_TYPE_READY = 0;
+var MESSAGE_TYPE_WEATHER = 1;
+var MESSAGE_TYPE_ERROR = 4;
+var WEATHER_SOURCE_OPENWEATHERMAP = 1;
+var TEMPERATURE_UNITS_CELSIUS = 0;
+var WARMUP = 50;
+
+// AppMessage dictionary size, counted the way radio.js and the watch count it.
+var DICT_HEADER_BYTES = 1;
+var TUPLE_HEADER_BYTES = 7;
+var INT_BYTES = 4;
+
+function parseArgs(argv) {
+  var args = { requests: 2000, latency: 0, jitter: 0, 'failure-rate': 0, parses: 5000 };
+  argv.forEach(function(arg) {
+    var match = arg.match(/^--([a-z-]+)=(.*)$/);
+    if (!match || !args.hasOwnProperty(match[1])) {
+      console.error("Unknown argument: " + arg);
+      process.exit(2);
+    }
+    args[match[1]] = parseFloat(match[2]);
+  });
+  return args;
+}
+
+function dictionaryBytes(payload) {
+  return Object.keys(payload).reduce(function(bytes, key) {
+    var value = payload[key];
+    return bytes + TUPLE_HEADER_BYTES + (Array.isArray(value) ? value.length : INT_BYTES);
+  }, DICT_HEADER_BYTES);
+}
+
+function percentile(sorted, fraction) {
+  return sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * fraction))];
+}
+
+function summary(values, unit, digits) {
+  var sorted = values.slice().sort(function(a, b) { return a - b; });
+  var total = sorted.reduce(function(sum, value) { return sum + value; }, 0);
+  function format(value) {
+    return value.toFixed(digits) + unit;
+  }
+  return "mean " + format(total / sorted.length) + ", p50 " + format(percentile(sorted, 0.5)) +
+         ", p90 " + format(percentile(sorted, 0.9)) + ", p99 " + format(percentile(sorted, 0.99)) +
+         ", max " + format(sorted[sorted.length - 1]);
+}
+
+function elapsedMs(start) {
+  var elapsed = process.hrtime(start);
+  return elapsed[0] * 1e3 + elapsed[1] / 1e6;
+}
+
+// Bytes allocated on the JS heap while run goes: what is live at the end less what was live at the start, plus
+// what every GC in between collected.
+function startAllocationCount() {
+  var profiler = v8.GCProfiler ? new v8.GCProfiler() : null;
+  var startUsed = v8.getHeapStatistics().used_heap_size;
+
+  if (profiler) {
+    profiler.start();
+  }
+  return function stop() {
+    var collected = 0;
+    if (profiler) {
+      profiler.stop().statistics.forEach(function(gc) {
+        collected += gc.beforeGC.heapStatistics.usedHeapSize - gc.afterGC.heapStatistics.usedHeapSize;
+      });
+    }
+    return { bytes: v8.getHeapStatistics().used_heap_size - startUsed + collected, exact: !!profiler };
+  };
+}
+
+function runRequests(args, fixture, done) {
+  var waiting = null;
+  var results = { latencies: [], appMessageBytes: [], errors: 0 };
+  var phone = harness.createPhone({
+    fixture: fixture,
+    watch: function(payload, ack, nack) {
+      setImmediate(ack);
+      if (waiting && payload['KEY_MESSAGE_ID'] === waiting.id &&
+          (payload['KEY_MESSAGE_TYPE'] === MESSAGE_TYPE_WEATHER || payload['KEY_MESSAGE_TYPE'] === MESSAGE_TYPE_ERROR)) {
+        var answered = waiting;
+        waiting = null;
+        answered.callback(payload);
+      }
+    }
+  });
+  var stopCount = null;
+  var xhrBytesAtWarmup = 0;
+
+  function request(id) {
+    if (id === WARMUP) {
+      xhrBytesAtWarmup = fixture.stats.bytes;
+      stopCount = startAllocationCount();
+    }
+    if (id === args.requests + WARMUP) {
+      var allocated = stopCount();
+      results.allocatedBytes = allocated.bytes;
+      results.allocationsExact = allocated.exact;
+      results.xhrBytes = fixture.stats.bytes - xhrBytesAtWarmup;
+      done(results, phone);
+      return;
+    }
+
+    var start = process.hrtime();
+    waiting = {
+      id: id,
+      callback: function(payload) {
+        if (id >= WARMUP) {
+          results.latencies.push(elapsedMs(start));
+          results.appMessageBytes.push(dictionaryBytes(payload));
+          if (payload['KEY_MESSAGE_TYPE'] === MESSAGE_TYPE_ERROR) {
+            results.errors++;
+          }
+        }
+        setImmediate(request, id + 1);
+      }
+    };
+    phone.watchSends({
+      'KEY_MESSAGE_TYPE': MESSAGE_TYPE_WEATHER,
+      'KEY_MESSAGE_ID': id,
+      'TEMPERATURE_UNITS': TEMPERATURE_UNITS_CELSIUS,
+      'WEATHER_SOURCE': WEATHER_SOURCE_OPENWEATHERMAP
+    });
+  }
+
+  phone.emit('ready');
+  phone.watchSends({ 'KEY_MESSAGE_TYPE': MESSAGE_TYPE_READY });
+  request(0);
+}
+
+function runParses(args, phone, body) {
+  var parse = phone.require('./providers').parseOpenWeatherMapOneCall;
+  var times = [];
+  var stopCount;
+
+  for (var i = 0; i < WARMUP; i++) {
+    parse(body);
+  }
+  stopCount = startAllocationCount();
+  for (i = 0; i < args.parses; i++) {
+    var start = process.hrtime();
+    parse(body);
+    times.push(elapsedMs(start) * 1000);
+  }
+  return { times: times, allocated: stopCount() };
+}
+
+function main() {
+  var args = parseArgs(process.argv.slice(2));
+
+  fixtureServer.start({ latencyMs: args.latency, jitterMs: args.jitter, failureRate: args['failure-rate'] },
+                      function(fixture) {
+    var started = process.hrtime();
+
+    runRequests(args, fixture, function(results, phone) {
+      var wallMs = elapsedMs(started);
+      http.get(fixture.onecallUrl, function(response) {
+        var chunks = [];
+        response.setEncoding('utf8');
+        response.on('data', function(chunk) { chunks.push(chunk); });
+        response.on('end', function() {
+          var text = chunks.join('');
+          var parses = runParses(args, phone, text);
+          var appMessageTotal = results.appMessageBytes.reduce(function(sum, bytes) { return sum + bytes; }, 0);
+
+          console.log("Weather requests: " + args.requests + " in " + (wallMs / 1000).toFixed(1) + "s, " +
+                      results.errors + " answered with an error, fixture latency " + args.latency + "ms +" +
+                      args.jitter + "ms, failure rate " + args['failure-rate']);
+          console.log("  latency      " + summary(results.latencies, "ms", 2));
+          console.log("  allocated    " + Math.round(results.allocatedBytes / args.requests) + " bytes per request" +
+                      (results.allocationsExact ? "" : " (heap growth only, this Node has no GCProfiler)"));
+          console.log("  HTTP         " + Math.round(results.xhrBytes / args.requests) + " bytes per request down");
+          console.log("  AppMessage   " + Math.round(appMessageTotal / args.requests) + " bytes per update to the watch");
+          console.log("One Call parse: " + args.parses + " parses of " + text.length + " bytes");
+          console.log("  time         " + summary(parses.times, "us", 1));
+          console.log("  allocated    " + Math.round(parses.allocated.bytes / args.parses) + " bytes per parse");
+          fixture.close(function() {
+            process.exit(0);
+          });
+        });
+      });
+    });
+  });
+}
+
+main();
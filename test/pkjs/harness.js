@@ -0,0 +1,367 @@
+/*jslint node: true*/
+
+// Runs the PebbleKit JS app in Node, without a phone or a watch.
+//
+// Each phone loads src/pkjs afresh into its own context, with stand-ins for what the Pebble app provides:
+//
+//   Pebble                  addEventListener, sendAppMessage and friends; messages go to options.watch
+//   navigator.geolocation   answers with options.position, or fails with options.positionError
+//   XMLHttpRequest          real HTTP, with api.openweathermap.org sent to the fixture server and anything else
+//                           not on loopback failing as if offline
+//   localStorage            in memory, starting from options.localStorage
+//   pebble-clay             just enough for the config page events
+//
+// The watch is a function(payload, ack, nack) called for every message the phone sends, with the payload keyed
+// by name the way app.js writes it.  The default one acknowledges everything.  Messages from the watch go in with
+// phone.watchSends(payload), keyed by name too; toKeyIds and toKeyNames convert using package.json.
+//
+// The fixture server is started separately, see fixture_server.js, and passed in as options.fixture.
+//
+// Time is the real thing unless options.clock replaces it, for a simulation running on a clock of its own:
+// Date, setTimeout and clearTimeout in the app then go to clock.now, clock.setTimeout and clock.clearTimeout.
+// HTTP still happens in real time, and phone.xhrsOutstanding counts requests waiting on it; once the response is
+// in, the app sees it options.xhrLatencyMs later on the clock.
+
+var fs = require('fs');
+var http = require('http');
+var path = require('path');
+var url = require('url');
+var vm = require('vm');
+
+var PKJS_DIR = path.join(__dirname, '..', '..', 'src', 'pkjs');
+var MESSAGE_KEYS = require('../../package.json').pebble.messageKeys;
+var MESSAGE_KEY_NAMES = {};
+Object.keys(MESSAGE_KEYS).forEach(function(name) {
+  MESSAGE_KEY_NAMES[MESSAGE_KEYS[name]] = name;
+});
+
+var OWM_HOST = 'api.openweathermap.org';
+var LOOPBACK_HOSTS = ['127.0.0.1', 'localhost'];
+
+var DEFAULT_POSITION = { latitude: 47.6062, longitude: -122.3321 };
+
+var agent = new http.Agent({ keepAlive: true });
+
+// Sources are read once; every phone compiles them into its own context.
+var sources = {};
+
+function readSource(file) {
+  if (!sources[file]) {
+    sources[file] = fs.readFileSync(file, 'utf8');
+  }
+  return sources[file];
+}
+
+function convertKeys(payload, table) {
+  var converted = {};
+  Object.keys(payload).forEach(function(key) {
+    converted[table.hasOwnProperty(key) ? table[key] : key] = payload[key];
+  });
+  return converted;
+}
+
+function toKeyIds(payload) {
+  return convertKeys(payload, MESSAGE_KEYS);
+}
+
+function toKeyNames(payload) {
+  return convertKeys(payload, MESSAGE_KEY_NAMES);
+}
+
+function createLocalStorage(initial) {
+  var items = {};
+  var storage = {
+    getItem: function(key) {
+      return items.hasOwnProperty(key) ? items[key] : null;
+    },
+    setItem: function(key, value) {
+      items[key] = String(value);
+    },
+    removeItem: function(key) {
+      delete items[key];
+    },
+    clear: function() {
+      items = {};
+    },
+    items: function() {
+      return items;
+    }
+  };
+  Object.keys(initial || {}).forEach(function(key) {
+    storage.setItem(key, initial[key]);
+  });
+  return storage;
+}
+
+// Clay's constructor and the two calls app.js makes.  The config page response is taken to be the settings as
+// JSON, keyed by message key name, the way Clay hands them back.
+function FakeClay(config, customFn, options) {
+  this.config = config;
+  this.options = options;
+}
+
+FakeClay.prototype.generateUrl = function() {
+  return 'data:text/html,clay';
+};
+
+FakeClay.prototype.getSettings = function(response) {
+  return JSON.parse(decodeURIComponent(response));
+};
+
+// A Date whose now is clock.now.  Dates it makes are ordinary ones.
+function createDate(clock) {
+  function ClockDate(value) {
+    if (!(this instanceof ClockDate)) {
+      return new Date(clock.now()).toString();
+    }
+    if (arguments.length === 0) {
+      return new Date(clock.now());
+    }
+    return new (Function.prototype.bind.apply(Date, [null].concat(Array.prototype.slice.call(arguments))))();
+  }
+  ClockDate.now = function() {
+    return clock.now();
+  };
+  ClockDate.UTC = Date.UTC;
+  ClockDate.parse = Date.parse;
+  ClockDate.prototype = Date.prototype;
+  return ClockDate;
+}
+
+function createXMLHttpRequest(phone, fixture, clock, latencyMs) {
+  // How the app hears of a finished request.
+  var deliver = clock ? function(callback) {
+    clock.setTimeout(callback, latencyMs || 0);
+  } : function(callback) {
+    callback();
+  };
+
+  function XMLHttpRequest() {
+    this.status = 0;
+    this.responseText = '';
+    this.timeout = 0;
+  }
+
+  XMLHttpRequest.prototype.open = function(method, requestUrl) {
+    this.method = method;
+    this.url = requestUrl;
+  };
+
+  XMLHttpRequest.prototype.send = function(body) {
+    var xhr = this;
+    var target = url.parse(xhr.url);
+    var finished = false;
+
+    function finish(handler) {
+      if (!finished) {
+        finished = true;
+        phone.xhrsOutstanding--;
+        deliver(function() {
+          if (xhr[handler]) {
+            xhr[handler]();
+          }
+        });
+      }
+    }
+
+    phone.xhrsOutstanding++;
+    phone.stats.xhrs++;
+    if (target.hostname === OWM_HOST && fixture) {
+      target = url.parse(fixture.onecallUrl.replace(/\/onecall$/, '') + target.pathname.replace(/^\/data\/2\.5/, '') +
+                         (target.search || ''));
+    }
+    if (LOOPBACK_HOSTS.indexOf(target.hostname) < 0) {
+      setImmediate(finish, 'onerror');
+      return;
+    }
+
+    var request = http.request({
+      agent: agent,
+      method: xhr.method,
+      hostname: target.hostname,
+      port: target.port,
+      path: target.path
+    }, function(response) {
+      var chunks = [];
+      response.setEncoding('utf8');
+      response.on('data', function(chunk) { chunks.push(chunk); });
+      response.on('end', function() {
+        xhr.status = response.statusCode;
+        xhr.responseText = chunks.join('');
+        finish('onload');
+      });
+    });
+    request.on('error', function() {
+      finish('onerror');
+    });
+    if (xhr.timeout > 0) {
+      request.setTimeout(xhr.timeout, function() {
+        request.abort();
+        finish('ontimeout');
+      });
+    }
+    request.end(body);
+  };
+
+  return XMLHttpRequest;
+}
+
+function acknowledgeAll(payload, ack, nack) {
+  setImmediate(ack);
+}
+
+// options, all optional:
+//   watch          function(payload, ack, nack), see above
+//   fixture        a started fixture server; also becomes localStorage.fixtureProviderUrl unless that is given
+//   position       { latitude, longitude }
+//   positionError  { code, message } to fail every position request instead
+//   positionMs     how long a position takes
+//   localStorage   initial items
+//   log            function(line) for console output from the app; dropped by default
+//   clock          { now, setTimeout, clearTimeout } for the app to use instead of the real ones
+//   xhrLatencyMs   with a clock, how long after the HTTP response the app gets it
+function createPhone(options) {
+  options = options || {};
+  var listeners = {};
+  var transactionId = 0;
+  var modules = {};
+  var watch = options.watch || acknowledgeAll;
+  var position = options.position || DEFAULT_POSITION;
+  var initialStorage = options.localStorage || {};
+  var clock = options.clock || { now: Date.now, setTimeout: setTimeout, clearTimeout: clearTimeout };
+
+  if (options.fixture && !initialStorage.hasOwnProperty('fixtureProviderUrl')) {
+    initialStorage = JSON.parse(JSON.stringify(initialStorage));
+    initialStorage.fixtureProviderUrl = options.fixture.onecallUrl;
+  }
+
+  var phone = {
+    xhrsOutstanding: 0,
+    stats: { sent: 0, acked: 0, nacked: 0, received: 0, xhrs: 0, positions: 0 },
+    localStorage: createLocalStorage(initialStorage),
+    emit: emit,
+    watchSends: watchSends,
+    openConfig: openConfig
+  };
+
+  function emit(type, event) {
+    (listeners[type] || []).forEach(function(listener) {
+      listener(event || {});
+    });
+  }
+
+  function watchSends(payload) {
+    phone.stats.received++;
+    emit('appmessage', { payload: payload });
+  }
+
+  // Closes the config page with settings, keyed by message key name.
+  function openConfig(settings) {
+    emit('showConfiguration', {});
+    emit('webviewclosed', { response: encodeURIComponent(JSON.stringify(settings)) });
+  }
+
+  var Pebble = {
+    addEventListener: function(type, listener) {
+      (listeners[type] = listeners[type] || []).push(listener);
+    },
+    removeEventListener: function(type, listener) {
+      listeners[type] = (listeners[type] || []).filter(function(other) { return other !== listener; });
+    },
+    sendAppMessage: function(payload, ack, nack) {
+      var id = ++transactionId;
+      var answered = false;
+
+      phone.stats.sent++;
+      watch(JSON.parse(JSON.stringify(payload)), function() {
+        if (!answered) {
+          answered = true;
+          phone.stats.acked++;
+          if (ack) {
+            ack({ data: { transactionId: id } });
+          }
+        }
+      }, function(error) {
+        if (!answered) {
+          answered = true;
+          phone.stats.nacked++;
+          if (nack) {
+            nack({ data: { transactionId: id }, error: { message: error || "NACK" } });
+          }
+        }
+      });
+      return id;
+    },
+    getWatchToken: function() {
+      return 'harness-watch';
+    },
+    getAccountToken: function() {
+      return 'harness-account';
+    },
+    getActiveWatchInfo: function() {
+      return { platform: 'aplite', model: 'pebble_black', language: 'en_US', firmware: { major: 3, minor: 12 } };
+    },
+    openURL: function(configUrl) {
+      phone.configUrl = configUrl;
+    },
+    showSimpleNotificationOnPebble: function() {}
+  };
+
+  var geolocation = {
+    getCurrentPosition: function(success, failure, positionOptions) {
+      phone.stats.positions++;
+      clock.setTimeout(function() {
+        if (options.positionError) {
+          failure(options.positionError);
+        } else {
+          success({ coords: { latitude: position.latitude, longitude: position.longitude, accuracy: 50 },
+                    timestamp: clock.now() });
+        }
+      }, options.positionMs || 0);
+    }
+  };
+
+  var log = options.log || function() {};
+  var globals = {
+    Pebble: Pebble,
+    navigator: { geolocation: geolocation },
+    XMLHttpRequest: createXMLHttpRequest(phone, options.fixture, options.clock, options.xhrLatencyMs),
+    localStorage: phone.localStorage,
+    console: { log: log, warn: log, error: log, info: log },
+    setTimeout: clock.setTimeout,
+    clearTimeout: clock.clearTimeout,
+    setInterval: setInterval,
+    clearInterval: clearInterval,
+    encodeURIComponent: encodeURIComponent,
+    unescape: unescape
+  };
+  if (options.clock) {
+    globals.Date = createDate(options.clock);
+  }
+  var context = vm.createContext(globals);
+
+  function load(name) {
+    if (name === 'pebble-clay') {
+      return FakeClay;
+    }
+    var file = path.join(PKJS_DIR, name.replace(/^\.\//, '') + '.js');
+    if (!modules[file]) {
+      var module = modules[file] = { exports: {} };
+      var wrapper = vm.runInContext('(function(require, module, exports) {' + readSource(file) + '\n})', context,
+                                    { filename: file });
+      wrapper(load, module, module.exports);
+    }
+    return modules[file].exports;
+  }
+
+  phone.require = load;
+  load('./app');
+  return phone;
+}
+
+module.exports = {
+  createPhone: createPhone,
+  toKeyIds: toKeyIds,
+  toKeyNames: toKeyNames,
+  MESSAGE_KEYS: MESSAGE_KEYS
+};
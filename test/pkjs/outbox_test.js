@@ -0,0 +1,192 @@
+/*jslint node: true*/
+
+// Tests outbox.js on the harness, with a watch that answers only when told to and a clock that only moves when
+// told to.
+//
+//   node test/pkjs/outbox_test.js
+//
+// Each case gets a phone of its own, so a fresh outbox.  Exits non-zero if any case fails.
+
+var harness = require('./harness');
+
+var RETRY_DELAYS_MS = [500, 1000, 2000, 4000, 8000];
+
+// setTimeout and friends on virtual time, run by advance.
+function createClock() {
+  var now = 1792306800000;  // 2026-10-18 07:00 UTC
+  var timers = [];
+  var nextId = 1;
+
+  return {
+    now: function() {
+      return now;
+    },
+    setTimeout: function(callback, delay) {
+      var timer = { id: nextId++, at: now + (delay || 0), callback: callback };
+      timers.push(timer);
+      return timer.id;
+    },
+    clearTimeout: function(id) {
+      timers = timers.filter(function(timer) { return timer.id !== id; });
+    },
+    advance: function(ms) {
+      var until = now + ms;
+      for (;;) {
+        var due = timers.filter(function(timer) { return timer.at <= until; });
+        if (due.length === 0) {
+          break;
+        }
+        due.sort(function(a, b) { return a.at - b.at || a.id - b.id; });
+        timers.splice(timers.indexOf(due[0]), 1);
+        now = due[0].at;
+        due[0].callback();
+      }
+      now = until;
+    }
+  };
+}
+
+// A phone whose watch keeps every message it gets in sent, for the case to ack or nack.
+function createSetup() {
+  var setup = { clock: createClock(), sent: [], events: [] };
+  var phone = harness.createPhone({
+    clock: setup.clock,
+    watch: function(payload, ack, nack) {
+      setup.sent.push({ payload: payload, ack: ack, nack: nack });
+    }
+  });
+
+  setup.outbox = phone.require('./outbox');
+  // Callbacks that note what happened to a message under name.
+  setup.callbacks = function(name) {
+    return {
+      ack: function() {
+        setup.events.push(name + " acked");
+      },
+      nack: function(event) {
+        setup.events.push(name + (event && event.superseded ? " superseded" : " failed"));
+      }
+    };
+  };
+  setup.send = function(type, name, message, options) {
+    var callbacks = setup.callbacks(name);
+    options = options || {};
+    options.ack = callbacks.ack;
+    options.nack = callbacks.nack;
+    setup.outbox.send(type, message, options);
+  };
+  setup.last = function() {
+    return setup.sent[setup.sent.length - 1];
+  };
+  return setup;
+}
+
+function expectEqual(actual, expected, what) {
+  if (JSON.stringify(actual) !== JSON.stringify(expected)) {
+    throw new Error(what + ": expected " + JSON.stringify(expected) + ", got " + JSON.stringify(actual));
+  }
+}
+
+var cases = {
+  // A newer message replaces the one waiting in its slot, and the one out is not retried once a newer one waits.
+  supersede: function(setup) {
+    setup.send("weather", "first", { id: 1 });
+    setup.send("weather", "second", { id: 2 });
+    setup.send("weather", "third", { id: 3 });
+    expectEqual(setup.events, ["second superseded"], "events while the first is out");
+    expectEqual(setup.sent.length, 1, "messages sent while the first is out");
+
+    setup.last().nack();
+    expectEqual(setup.events, ["second superseded", "first superseded"], "events once the first fails");
+    expectEqual(setup.sent.length, 2, "messages sent once the first fails");
+    expectEqual(setup.last().payload, { id: 3 }, "message sent once the first fails");
+
+    setup.last().ack();
+    setup.clock.advance(60000);
+    expectEqual(setup.events, ["second superseded", "first superseded", "third acked"], "events at the end");
+    expectEqual(setup.sent.length, 2, "messages sent at the end");
+  },
+
+  // A failed message goes again after each backoff delay, and is given up on after the last.
+  retry: function(setup) {
+    setup.send("ready", "ready", { ready: 1 });
+    RETRY_DELAYS_MS.forEach(function(delay, retry) {
+      setup.last().nack();
+      setup.clock.advance(delay - 1);
+      expectEqual(setup.sent.length, retry + 1, "messages sent just before retry " + (retry + 1));
+      setup.clock.advance(1);
+      expectEqual(setup.sent.length, retry + 2, "messages sent at retry " + (retry + 1));
+    });
+    expectEqual(setup.events, [], "events before the last try fails");
+
+    setup.last().nack();
+    setup.clock.advance(60000);
+    expectEqual(setup.events, ["ready failed"], "events once the last try fails");
+    expectEqual(setup.sent.length, RETRY_DELAYS_MS.length + 1, "messages sent in all");
+  },
+
+  // A message whose id the watch has acknowledged in its slot is dropped; another id in the slot still goes.
+  ackDrop: function(setup) {
+    setup.send("weather", "first", { id: 7 }, { id: 7 });
+    setup.last().ack();
+    setup.send("weather", "again", { id: 7 }, { id: 7 });
+    setup.send("event log", "other slot", { id: 7 }, { id: 7 });
+    setup.last().ack();
+    setup.send("weather", "next", { id: 8 }, { id: 8 });
+    setup.last().ack();
+
+    expectEqual(setup.sent.map(function(sent) { return sent.payload.id; }), [7, 7, 8], "ids sent");
+    expectEqual(setup.events, ["first acked", "other slot acked", "next acked"], "events");
+  },
+
+  // Merged messages add up their keys, newer ones winning, and a merged message that fails while another waits
+  // goes along with it rather than being dropped.
+  merge: function(setup) {
+    setup.send("settings", "first", { a: 1, b: 1 }, { merge: true });
+    setup.send("settings", "second", { b: 2 }, { merge: true });
+    setup.send("settings", "third", { c: 3 }, { merge: true });
+    expectEqual(setup.sent.length, 1, "messages sent while the first is out");
+
+    setup.last().nack();
+    expectEqual(setup.sent.length, 2, "messages sent once the first fails");
+    expectEqual(setup.last().payload, { b: 2, c: 3, a: 1 }, "message sent once the first fails");
+    expectEqual(setup.events, [], "events once the first fails");
+
+    setup.last().ack();
+    expectEqual(setup.events, ["first acked", "second acked", "third acked"], "events at the end");
+  },
+
+  // Cancelling a slot drops what waits in it, and the message already out is not retried if it fails.
+  cancel: function(setup) {
+    setup.send("weather", "first", { id: 1 });
+    setup.send("weather", "second", { id: 2 });
+    setup.outbox.cancel("weather");
+    expectEqual(setup.events, ["second superseded"], "events once cancelled");
+
+    setup.last().nack();
+    setup.clock.advance(60000);
+    expectEqual(setup.events, ["second superseded", "first superseded"], "events once the first fails");
+    expectEqual(setup.sent.length, 1, "messages sent");
+
+    setup.send("weather", "third", { id: 3 });
+    setup.last().ack();
+    expectEqual(setup.events.slice(-1), ["third acked"], "events for a message after the cancel");
+  }
+};
+
+function main() {
+  var failures = 0;
+
+  Object.keys(cases).forEach(function(name) {
+    try {
+      cases[name](createSetup());
+      console.log("ok " + name);
+    } catch (error) {
+      console.log("FAIL " + name + ": " + error.message);
+      failures++;
+    }
+  });
+  process.exit(failures === 0 ? 0 : 1);
+}
+
+main();